@@ -0,0 +1,13 @@
+/*
+    Микробенчмарки game_model и collision_detection_lib.
+
+    Сравнение сборок:
+      game_benchmarks --benchmark_out=before.json --benchmark_out_format=json
+      game_benchmarks --benchmark_out=after.json --benchmark_out_format=json
+      compare.py benchmarks before.json after.json   (из поставки Google Benchmark)
+
+    Отдельные группы выбираются через --benchmark_filter=BM_FindGatherEvents.
+*/
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
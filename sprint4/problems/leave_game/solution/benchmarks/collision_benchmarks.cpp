@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "../src/collision_detector.h"
+#include "../tests/vector_provider.h"
+#include "synthetic_world.h"
+
+namespace {
+
+using namespace collision_detector;
+
+using test_support::VectorProvider;
+
+/* Предметы и собаки на карте-сетке; собаки проходят за тик один шаг сетки */
+VectorProvider MakeProvider(int items, int gatherers) {
+    const model::Map map = bench::MakeGridMap("collisions", bench::GridSideFor(items + gatherers));
+    bench::WorldRandom random;
+
+    std::vector<Item> item_list;
+    item_list.reserve(items);
+    for (int i = 0; i < items; ++i) {
+        item_list.push_back({random.RoadPoint(map), 0.});
+    }
+
+    std::vector<Gatherer> gatherer_list;
+    gatherer_list.reserve(gatherers);
+    for (int i = 0; i < gatherers; ++i) {
+        const model::PairDouble start = random.RoadPoint(map);
+        const model::PairDouble speed = random.AxisSpeed(bench::ROAD_STEP);
+        gatherer_list.push_back({start, {start.x + speed.x, start.y + speed.y}, 0.6});
+    }
+    return VectorProvider{std::move(item_list), std::move(gatherer_list)};
+}
+
+/* range(0) - число предметов, range(1) - число собак */
+void BM_FindGatherEvents(benchmark::State& state) {
+    const VectorProvider provider = MakeProvider(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    size_t events = 0;
+    for (auto _ : state) {
+        auto result = FindGatherEvents(provider);
+        events = result.size();
+        benchmark::DoNotOptimize(result);
+    }
+    state.counters["events"] = static_cast<double>(events);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+BENCHMARK(BM_FindGatherEvents)
+    ->ArgsProduct({benchmark::CreateRange(10, 100'000, 10), {10, 100}})
+    ->ArgNames({"items", "dogs"})
+    ->Unit(benchmark::kMicrosecond);
+
+/* Те же данные через перегрузку с массивами: без виртуальных вызовов на каждый предмет */
+void BM_FindGatherEventsSpan(benchmark::State& state) {
+    const VectorProvider provider = MakeProvider(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    size_t events = 0;
+    for (auto _ : state) {
+        auto result = FindGatherEvents(provider.Items(), provider.Gatherers());
+        events = result.size();
+        benchmark::DoNotOptimize(result);
+    }
+    state.counters["events"] = static_cast<double>(events);
+    state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+BENCHMARK(BM_FindGatherEventsSpan)
+    ->ArgsProduct({benchmark::CreateRange(10, 100'000, 10), {10, 100}})
+    ->ArgNames({"items", "dogs"})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,43 @@
+#!/bin/bash
+# Сравнение режимов --io-mode shared и per-core под одинаковой нагрузкой load_generator.
+# Нужны собранные game_server и load_generator и переменная GAME_DB_URL.
+#
+#   GAME_DB_URL=postgres://... benchmarks/compare_io_modes.sh [bin_dir] [threads] [users] [seconds]
+#
+# Дополнительные флаги сервера (например --pin-threads) передаются через SERVER_FLAGS.
+set -euo pipefail
+
+BIN_DIR=${1:-./build/bin}
+THREADS=${2:-$(nproc)}
+USERS=${3:-200}
+DURATION=${4:-30}
+PORT=8080
+
+: "${GAME_DB_URL:?GAME_DB_URL is not specified}"
+
+wait_for_server() {
+  for _ in $(seq 50); do
+    if curl -sf "http://127.0.0.1:${PORT}/api/v1/maps" >/dev/null; then
+      return 0
+    fi
+    sleep 0.1
+  done
+  echo "server did not start" >&2
+  return 1
+}
+
+for MODE in shared per-core; do
+  "${BIN_DIR}/game_server" -c ./data/config.json -r ./static/ -t 50 \
+    --io-mode "${MODE}" --threads "${THREADS}" ${SERVER_FLAGS:-} >/dev/null &
+  SERVER_PID=$!
+  trap 'kill ${SERVER_PID} 2>/dev/null || true' EXIT
+
+  wait_for_server
+  echo "=== io-mode=${MODE} threads=${THREADS} ==="
+  "${BIN_DIR}/load_generator" --mode closed --users "${USERS}" --duration "${DURATION}" \
+    --threads "${THREADS}"
+
+  kill -INT "${SERVER_PID}"
+  wait "${SERVER_PID}" || true
+  trap - EXIT
+done
@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+
+#include "../src/app.h"
+#include "../src/http_compression.h"
+#include "synthetic_world.h"
+
+namespace {
+
+/* Тело ответа /api/v1/game/state для сессии с dogs игроками */
+std::string StateBody(int dogs) {
+    bench::World world(bench::GridSideFor(dogs), dogs, dogs, 42);
+    players::Players players;
+    bench::AddPlayers(players, *world.session);
+
+    boost::json::object response;
+    response["players"] = app::GameStateUseCase::GetPlayersForState(players.FindPlayersBySession(world.session));
+    response["lostObjects"] = app::GameStateUseCase::GetLootObject(world.session);
+    return boost::json::serialize(response);
+}
+
+/*
+    Цена сжатия ответа о состоянии: range(0) игроков, range(1) - кодировка
+    (1 - gzip, 2 - deflate), range(2) - уровень zlib. Счётчики ratio и
+    bytes_saved показывают выигрыш в трафике против затраченного CPU.
+*/
+void BM_CompressState(benchmark::State& state) {
+    const std::string body = StateBody(static_cast<int>(state.range(0)));
+    const auto encoding = static_cast<http_compression::Encoding>(state.range(1));
+    const int level = static_cast<int>(state.range(2));
+
+    size_t compressed = 0;
+    for (auto _ : state) {
+        std::string out = http_compression::Compress(body, encoding, level);
+        compressed = out.size();
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * body.size()));
+    state.counters["bytes_in"] = static_cast<double>(body.size());
+    state.counters["bytes_out"] = static_cast<double>(compressed);
+    state.counters["ratio"] = static_cast<double>(body.size()) / static_cast<double>(compressed);
+    state.counters["bytes_saved"] = static_cast<double>(body.size() - compressed);
+}
+
+BENCHMARK(BM_CompressState)
+    ->ArgsProduct({{10, 100, 1'000, 10'000}, {1}, {1, 6, 9}})
+    ->Args({1'000, 2, 6})
+    ->ArgNames({"players", "encoding", "level"})
+    ->Unit(benchmark::kMicrosecond);
+
+/* Ответ из кэша описаний карт: после первого запроса сжатие не выполняется */
+void BM_MapPayloadCached(benchmark::State& state) {
+    const std::string key = "/api/v1/maps/map1";
+    http_compression::PayloadCache cache;
+    cache.Put(key, StateBody(static_cast<int>(state.range(0))));
+
+    for (auto _ : state) {
+        const std::string* body = cache.Find(key, http_compression::Encoding::GZIP);
+        benchmark::DoNotOptimize(body);
+    }
+}
+
+BENCHMARK(BM_MapPayloadCached)->Arg(1'000)->ArgName("players");
+
+}  // namespace
@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+
+#include <boost/json.hpp>
+#include <filesystem>
+#include <fstream>
+
+#include "../src/json_loader.h"
+#include "synthetic_world.h"
+
+namespace {
+
+namespace json = boost::json;
+
+/* Карта в формате config.json: сетка дорог, дом в каждой клетке, четыре офиса */
+json::object MapConfig(int index, int roads_per_side) {
+    const int extent = (roads_per_side - 1) * bench::ROAD_STEP;
+    json::array roads;
+    json::array buildings;
+    for (int i = 0; i < roads_per_side; ++i) {
+        roads.push_back(json::object{{"x0", 0}, {"y0", i * bench::ROAD_STEP}, {"x1", extent}});
+        roads.push_back(json::object{{"x0", i * bench::ROAD_STEP}, {"y0", 0}, {"y1", extent}});
+        for (int j = 0; j + 1 < roads_per_side; ++j) {
+            buildings.push_back(json::object{{"x", i * bench::ROAD_STEP + 2},
+                                             {"y", j * bench::ROAD_STEP + 2},
+                                             {"w", bench::ROAD_STEP - 4},
+                                             {"h", bench::ROAD_STEP - 4}});
+        }
+    }
+    json::array offices;
+    for (int x : {0, extent}) {
+        for (int y : {0, extent}) {
+            offices.push_back(json::object{{"id", "o" + std::to_string(offices.size())},
+                                           {"x", x}, {"y", y}, {"offsetX", 0}, {"offsetY", 0}});
+        }
+    }
+    json::array loot_types;
+    for (int value : {10, 30}) {
+        loot_types.push_back(json::object{{"name", "loot" + std::to_string(value)},
+                                          {"file", "assets/loot.obj"},
+                                          {"type", "obj"},
+                                          {"rotation", 90},
+                                          {"color", "#338844"},
+                                          {"scale", 0.03},
+                                          {"value", value}});
+    }
+    return json::object{{"id", "map" + std::to_string(index)},
+                        {"name", "Map " + std::to_string(index)},
+                        {"dogSpeed", bench::DOG_SPEED},
+                        {"bagCapacity", bench::BAG_CAPACITY},
+                        {"roads", std::move(roads)},
+                        {"buildings", std::move(buildings)},
+                        {"offices", std::move(offices)},
+                        {"lootTypes", std::move(loot_types)}};
+}
+
+/* Файл конфигурации с maps картами; удаляется вместе с объектом */
+class ConfigFile {
+public:
+    ConfigFile(int maps, int roads_per_side)
+        : path_(std::filesystem::temp_directory_path() /
+                ("game_config_bench_" + std::to_string(maps) + ".json")) {
+        json::array maps_array;
+        for (int i = 0; i < maps; ++i) {
+            maps_array.push_back(MapConfig(i, roads_per_side));
+        }
+        json::object config{{"defaultDogSpeed", 3.0},
+                            {"dogRetirementTime", 15.0},
+                            {"lootGeneratorConfig", json::object{{"period", 5.0}, {"probability", 0.5}}},
+                            {"maps", std::move(maps_array)}};
+        std::ofstream(path_) << json::serialize(config);
+        size_ = std::filesystem::file_size(path_);
+    }
+
+    ConfigFile(const ConfigFile&) = delete;
+    ConfigFile& operator=(const ConfigFile&) = delete;
+
+    ~ConfigFile() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+
+    const std::filesystem::path& Path() const noexcept {
+        return path_;
+    }
+
+    uintmax_t Size() const noexcept {
+        return size_;
+    }
+
+private:
+    std::filesystem::path path_;
+    uintmax_t size_ = 0;
+};
+
+/*
+    Время запуска сервера до приёма соединений определяется загрузкой
+    конфигурации: range(0) карт по 2 * range(1) дорог. Разбор файла
+    выполняется один раз, карты строятся параллельно.
+*/
+void BM_LoadGame(benchmark::State& state) {
+    const ConfigFile config(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+
+    for (auto _ : state) {
+        model::Game game = json_loader::LoadGame(config.Path());
+        benchmark::DoNotOptimize(game);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * config.Size()));
+    state.counters["maps_per_second"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * state.range(0)), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_LoadGame)
+    ->ArgsProduct({{1, 100, 2'000}, {10}})
+    ->Args({200, 40})
+    ->ArgNames({"maps", "roads_per_side"})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,136 @@
+#include <benchmark/benchmark.h>
+
+#include <list>
+#include <vector>
+
+#include "../src/loot_generator.h"
+#include "synthetic_world.h"
+
+namespace {
+
+using namespace std::literals;
+
+constexpr int TICK_MS = 50;
+/* Раз в столько итераций собакам возвращаются исходные позиции, иначе все упрутся в края дорог */
+constexpr int64_t RESET_PERIOD = 256;
+
+/* range(0) - число дорог на карте */
+void BM_FindRoadsByCoords(benchmark::State& state) {
+    const int roads_per_side = std::max<int>(1, static_cast<int>(state.range(0) / 2));
+    const model::Map map = bench::MakeGridMap("roads", roads_per_side);
+
+    bench::WorldRandom random;
+    std::vector<model::Dog::Position> queries;
+    for (int i = 0; i < 1024; ++i) {
+        queries.emplace_back(random.RoadPoint(map));
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        auto roads = map.FindRoadsByCoords(queries[i++ % queries.size()]);
+        benchmark::DoNotOptimize(roads);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_FindRoadsByCoords)->RangeMultiplier(10)->Range(10, 100'000)->ArgName("roads");
+
+struct DogSnapshot {
+    model::Dog::Position pos;
+    model::Dog::Speed speed;
+};
+
+std::vector<DogSnapshot> SaveDogs(const model::GameSession& session) {
+    std::vector<DogSnapshot> result;
+    for (const model::Dog& dog : session.GetDogs()) {
+        result.push_back({dog.GetPosition(), dog.GetSpeed()});
+    }
+    return result;
+}
+
+void RestoreDogs(model::GameSession& session, const std::vector<DogSnapshot>& snapshot) {
+    auto it = snapshot.begin();
+    for (model::Dog& dog : session.GetDogs()) {
+        dog.SetPosition(it->pos);
+        dog.SetSpeed(it->speed);
+        dog.ClearBag();
+        ++it;
+    }
+}
+
+/*
+    Game::UpdateDogPos закрыт, поэтому измеряется весь Game::UpdateGameState:
+    перемещение собак по дорогам и сбор/доставка без трофеев на карте (только офисы).
+    range(0) - число собак в сессии.
+*/
+void BM_UpdateGameState(benchmark::State& state) {
+    const int dogs = static_cast<int>(state.range(0));
+    bench::World world{bench::GridSideFor(dogs), dogs, 0};
+    const std::vector<DogSnapshot> initial = SaveDogs(*world.session);
+
+    int64_t iteration = 0;
+    for (auto _ : state) {
+        if (++iteration % RESET_PERIOD == 0) {
+            state.PauseTiming();
+            RestoreDogs(*world.session, initial);
+            state.ResumeTiming();
+        }
+        world.game.UpdateGameState(TICK_MS);
+    }
+    state.SetItemsProcessed(state.iterations() * dogs);
+}
+
+BENCHMARK(BM_UpdateGameState)->RangeMultiplier(10)->Range(10, 100'000)->ArgName("dogs")->Unit(benchmark::kMicrosecond);
+
+/*
+    То же с трофеями: по одному на собаку, чтобы подбор занимал заметную часть тика.
+    Мир строится один раз, а перед каждым тиком (вне замера) собаки и трофеи
+    возвращаются в исходное состояние: замеряется только тик, с прогретой ареной тика.
+*/
+void BM_UpdateGameStateWithLoot(benchmark::State& state) {
+    const int dogs = static_cast<int>(state.range(0));
+    bench::World world{bench::GridSideFor(dogs), dogs, dogs};
+    const std::vector<DogSnapshot> initial_dogs = SaveDogs(*world.session);
+    const std::list<model::Loot> initial_loot(world.session->GetLootObjects().begin(),
+                                              world.session->GetLootObjects().end());
+    world.game.UpdateGameState(TICK_MS);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        RestoreDogs(*world.session, initial_dogs);
+        world.session->SetLootObjects(initial_loot);
+        state.ResumeTiming();
+        world.game.UpdateGameState(TICK_MS);
+    }
+    state.SetItemsProcessed(state.iterations() * dogs);
+}
+
+BENCHMARK(BM_UpdateGameStateWithLoot)->RangeMultiplier(10)->Range(10, 10'000)->ArgName("dogs")->Unit(benchmark::kMicrosecond);
+
+/* range(0) - число мародёров, трофеев вдвое меньше */
+void BM_LootGeneratorGenerate(benchmark::State& state) {
+    loot_gen::LootGenerator generator{5s, 0.5};
+    const int looters = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(generator.Generate(50ms, looters / 2, looters));
+    }
+}
+
+BENCHMARK(BM_LootGeneratorGenerate)->RangeMultiplier(10)->Range(10, 100'000)->ArgName("looters");
+
+/* Генерация трофеев с размещением на карте, как по таймеру сервера; перед каждой итерацией карта очищается вне замера */
+void BM_GenerateLootInSessions(benchmark::State& state) {
+    const int dogs = static_cast<int>(state.range(0));
+    bench::World world{bench::GridSideFor(dogs), dogs, 0};
+    for (auto _ : state) {
+        state.PauseTiming();
+        world.session->SetLootObjects({});
+        state.ResumeTiming();
+        world.game.GenerateLootInSessions(5s);
+    }
+    state.SetItemsProcessed(state.iterations() * dogs);
+}
+
+BENCHMARK(BM_GenerateLootInSessions)->RangeMultiplier(10)->Range(10, 100'000)->ArgName("dogs")->Unit(benchmark::kMicrosecond);
+
+}  // namespace
@@ -0,0 +1,148 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+#include "../src/app.h"
+#include "../src/model_serialization.h"
+#include "synthetic_world.h"
+
+namespace {
+
+/* Мир с игроками: по собаке на игрока и по трофею на собаку */
+struct PopulatedWorld {
+    bench::World world;
+    players::Players players;
+
+    explicit PopulatedWorld(int dogs, double interest_radius = 0)
+        : world(bench::GridSideFor(dogs), dogs, dogs, 42, interest_radius) {
+        bench::AddPlayers(players, *world.session);
+    }
+};
+
+/* Ответ /api/v1/game/state для сессии с range(0) игроками */
+void BM_StateJsonSerialization(benchmark::State& state) {
+    PopulatedWorld populated(static_cast<int>(state.range(0)));
+    const auto session_players = populated.players.FindPlayersBySession(populated.world.session);
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        boost::json::object response;
+        response["players"] = app::GameStateUseCase::GetPlayersForState(session_players);
+        response["lostObjects"] = app::GameStateUseCase::GetLootObject(populated.world.session);
+        std::string body = boost::json::serialize(response);
+        bytes = body.size();
+        benchmark::DoNotOptimize(body);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    state.counters["bytes_per_response"] = static_cast<double>(bytes);
+}
+
+BENCHMARK(BM_StateJsonSerialization)->RangeMultiplier(10)->Range(10, 100'000)->ArgName("players")->Unit(benchmark::kMicrosecond);
+
+/* Тот же ответ в MessagePack (Accept: application/msgpack); сравнивать с BM_StateJsonSerialization */
+void BM_StateMsgPackSerialization(benchmark::State& state) {
+    PopulatedWorld populated(static_cast<int>(state.range(0)));
+    app::GameStateUseCase::StateView view;
+    view.players = populated.players.FindPlayersBySession(populated.world.session);
+    for (const model::Loot& loot : populated.world.session->GetLootObjects()) {
+        view.loot.push_back(&loot);
+    }
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        std::string body = app::GameStateUseCase::EncodeStateMsgPack(view);
+        bytes = body.size();
+        benchmark::DoNotOptimize(body);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+    state.counters["bytes_per_response"] = static_cast<double>(bytes);
+}
+
+BENCHMARK(BM_StateMsgPackSerialization)->RangeMultiplier(10)->Range(10, 100'000)->ArgName("players")->Unit(benchmark::kMicrosecond);
+
+/*
+    Тот же ответ с областью интереса радиусом в две дороги: запрос к сетке сессии
+    и сериализация только соседей. Запрашивающие игроки перебираются по кругу.
+*/
+void BM_StateJsonInterestRadius(benchmark::State& state) {
+    constexpr double RADIUS = 2 * bench::ROAD_STEP;
+    PopulatedWorld populated(static_cast<int>(state.range(0)), RADIUS);
+    const auto session_players = populated.players.FindPlayersBySession(populated.world.session);
+    const model::Map::Id& map_id = populated.world.map->GetId();
+
+    std::vector<const model::Dog*> dogs;
+    std::vector<const model::Loot*> loot;
+    size_t requester = 0;
+    size_t bytes = 0;
+    for (auto _ : state) {
+        const players::SharedPlayer& player = session_players[requester++ % session_players.size()];
+        const model::PairDouble center = *player->GetDog()->GetPosition();
+
+        populated.world.session->FindDogsInRadius(center, RADIUS, dogs);
+        std::vector<players::SharedPlayer> visible;
+        visible.reserve(dogs.size());
+        for (const model::Dog* dog : dogs) {
+            visible.push_back(populated.players.FindByDogIdAndMapId(dog->GetId(), map_id));
+        }
+        populated.world.session->FindLootInRadius(center, RADIUS, loot);
+
+        boost::json::object response;
+        response["players"] = app::GameStateUseCase::GetPlayersForState(visible);
+        response["lostObjects"] = app::GameStateUseCase::GetLootObject(loot);
+        std::string body = boost::json::serialize(response);
+        bytes += body.size();
+        benchmark::DoNotOptimize(body);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.counters["bytes_per_response"] = benchmark::Counter(static_cast<double>(bytes) / state.iterations());
+}
+
+BENCHMARK(BM_StateJsonInterestRadius)->RangeMultiplier(10)->Range(10, 100'000)->ArgName("players")->Unit(benchmark::kMicrosecond);
+
+/*
+    Снимок состояния. Players::FindByPlayer ищет токен линейным проходом,
+    поэтому построение GameStateRepr квадратично и размер ограничен 10k.
+*/
+void BM_SnapshotSave(benchmark::State& state) {
+    PopulatedWorld populated(static_cast<int>(state.range(0)));
+
+    size_t bytes = 0;
+    for (auto _ : state) {
+        std::ostringstream out;
+        {
+            boost::archive::text_oarchive archive{out};
+            serialization::GameStateRepr repr{populated.world.game.GetAllSessions(), populated.players};
+            archive << repr;
+        }
+        bytes = out.str().size();
+        benchmark::DoNotOptimize(bytes);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+BENCHMARK(BM_SnapshotSave)->RangeMultiplier(10)->Range(10, 10'000)->ArgName("players")->Unit(benchmark::kMicrosecond);
+
+void BM_SnapshotLoad(benchmark::State& state) {
+    std::string snapshot;
+    {
+        PopulatedWorld populated(static_cast<int>(state.range(0)));
+        std::ostringstream out;
+        boost::archive::text_oarchive archive{out};
+        serialization::GameStateRepr repr{populated.world.game.GetAllSessions(), populated.players};
+        archive << repr;
+        snapshot = out.str();
+    }
+
+    for (auto _ : state) {
+        std::istringstream in{snapshot};
+        boost::archive::text_iarchive archive{in};
+        serialization::GameStateRepr repr;
+        archive >> repr;
+        benchmark::DoNotOptimize(repr);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * snapshot.size()));
+}
+
+BENCHMARK(BM_SnapshotLoad)->RangeMultiplier(10)->Range(10, 10'000)->ArgName("players")->Unit(benchmark::kMicrosecond);
+
+}  // namespace
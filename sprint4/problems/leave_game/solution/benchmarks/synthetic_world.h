@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../src/model.h"
+#include "../src/players.h"
+
+namespace bench {
+
+/* Расстояние между соседними параллельными дорогами синтетической карты */
+constexpr int ROAD_STEP = 10;
+constexpr double DOG_SPEED = 1.0;
+constexpr int BAG_CAPACITY = 3;
+
+/*
+    Квадратная сетка: roads_per_side горизонтальных и столько же вертикальных дорог
+    длиной во всю карту, офис в каждом углу, два типа трофеев.
+*/
+inline model::Map MakeGridMap(const std::string& id, int roads_per_side) {
+    roads_per_side = std::max(roads_per_side, 1);
+    const int extent = (roads_per_side - 1) * ROAD_STEP;
+    model::Map map(model::Map::Id{id}, "Synthetic " + id);
+    for (int i = 0; i < roads_per_side; ++i) {
+        map.AddRoad(model::Road(model::Road::HORIZONTAL, {0, i * ROAD_STEP}, extent));
+        map.AddRoad(model::Road(model::Road::VERTICAL, {i * ROAD_STEP, 0}, extent));
+    }
+    int office_id = 0;
+    for (int x : {0, extent}) {
+        for (int y : {0, extent}) {
+            map.AddOffice(model::Office(model::Office::Id{"o" + std::to_string(office_id++)}, {x, y}, {0, 0}));
+        }
+    }
+    for (int value : {10, 30}) {
+        model::LootType type;
+        type.value = value;
+        map.AddLootType(type);
+    }
+    map.AddDogSpeed(DOG_SPEED);
+    map.AddBagCapacity(BAG_CAPACITY);
+    return map;
+}
+
+/* Сторона сетки, при которой на одну дорогу приходится порядка десяти собак */
+inline int GridSideFor(int dogs) {
+    int side = 2;
+    while (side * side * 5 < dogs) {
+        ++side;
+    }
+    return side;
+}
+
+/* Детерминированный источник синтетических позиций и скоростей */
+class WorldRandom {
+public:
+    explicit WorldRandom(uint64_t seed = 42) : engine_(seed) {}
+
+    double Uniform(double from, double to) {
+        return from + (to - from) * (static_cast<double>(engine_() >> 11) * 0x1.0p-53);
+    }
+
+    int Below(int bound) {
+        return static_cast<int>(engine_() % static_cast<uint64_t>(bound));
+    }
+
+    model::PairDouble RoadPoint(const model::Map& map) {
+        const auto& roads = map.GetRoads();
+        const model::Road& road = roads[Below(static_cast<int>(roads.size()))];
+        const double t = Uniform(0, 1);
+        const model::Point start = road.GetStart();
+        const model::Point end = road.GetEnd();
+        return {start.x + (end.x - start.x) * t, start.y + (end.y - start.y) * t};
+    }
+
+    /* Скорость вдоль одной из осей, как после команды игрока */
+    model::PairDouble AxisSpeed(double speed) {
+        switch (Below(4)) {
+            case 0: return {speed, 0};
+            case 1: return {-speed, 0};
+            case 2: return {0, speed};
+            default: return {0, -speed};
+        }
+    }
+
+private:
+    model::RandomEngine engine_;
+};
+
+/* Игра с одной картой-сеткой и одной сессией на ней; interest_radius - радиус области интереса карты */
+struct World {
+    model::Game game;
+    model::GameSession* session = nullptr;
+    const model::Map* map = nullptr;
+
+    World(int roads_per_side, int dogs, int loot, uint64_t seed = 42, double interest_radius = 0) {
+        game.SetLootGenerator(5000, 0.5);
+        model::Map grid = MakeGridMap("grid", roads_per_side);
+        grid.SetInterestRadius(interest_radius);
+        game.AddMap(std::move(grid));
+        map = game.FindMap(model::Map::Id{"grid"});
+        session = game.AddSession(map->GetId());
+
+        WorldRandom random{seed};
+        for (int i = 0; i < dogs; ++i) {
+            model::Dog* dog = session->AddDog(i, model::Dog::Name("dog" + std::to_string(i)),
+                                              model::Dog::Position(random.RoadPoint(*map)),
+                                              model::Dog::Speed(random.AxisSpeed(DOG_SPEED)),
+                                              model::Direction::NORTH);
+            dog->SetBagCapacity(BAG_CAPACITY);
+        }
+
+        std::list<model::Loot> loot_objects;
+        for (int i = 0; i < loot; ++i) {
+            loot_objects.push_back(model::Loot{i, random.Below(2), 10, random.RoadPoint(*map)});
+        }
+        session->SetLootObjects(std::move(loot_objects));
+    }
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+};
+
+/* Регистрирует игрока для каждой собаки сессии, как это делает join */
+inline void AddPlayers(players::Players& players, model::GameSession& session) {
+    for (model::Dog& dog : session.GetDogs()) {
+        players.AddPlayer(dog.GetId(), *dog.GetName(), &dog, &session);
+    }
+}
+
+}  // namespace bench
@@ -0,0 +1,114 @@
+#include "admission_control.h"
+
+#include <functional>
+#include <string>
+
+namespace http_handler {
+
+namespace {
+
+constexpr std::string_view BEARER = "Bearer ";
+
+/* Семейства регистрируются один раз на процесс, даже если экземпляров несколько */
+metrics::Gauge &QueueDepthGauge() {
+  static metrics::Gauge &gauge =
+      metrics::DefaultRegistry()
+          .AddGauge("game_api_strand_queue_depth",
+                    "API requests waiting for the strand")
+          .WithLabels({});
+  return gauge;
+}
+
+metrics::Counter &ShedCounter(Route route) {
+  static metrics::Family<metrics::Counter> &family =
+      metrics::DefaultRegistry().AddCounter(
+          "game_http_requests_shed_total",
+          "API requests rejected with 503 while the strand is overloaded",
+          {"route"});
+  return family.WithLabels({std::string(RouteName(route))});
+}
+
+} // namespace
+
+AdmissionControl::AdmissionControl(AdmissionSettings settings)
+    : settings_(settings),
+      depth_gauge_(QueueDepthGauge()),
+      shed_records_(ShedCounter(Route::RECORDS)),
+      shed_players_(ShedCounter(Route::PLAYERS)),
+      shed_state_(ShedCounter(Route::STATE)) {}
+
+void AdmissionControl::Enqueued() noexcept {
+  depth_.fetch_add(1, std::memory_order_relaxed);
+  depth_gauge_.Add(1);
+}
+
+void AdmissionControl::Dequeued(metrics::Clock::duration wait) noexcept {
+  depth_.fetch_sub(1, std::memory_order_relaxed);
+  depth_gauge_.Add(-1);
+
+  /* Гонка между load и store лишь теряет одно наблюдение, что для оценки допустимо */
+  const int64_t sample =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count();
+  const int64_t average = queue_delay_ns_.load(std::memory_order_relaxed);
+  queue_delay_ns_.store(average + (sample - average) / 8,
+                        std::memory_order_relaxed);
+}
+
+bool AdmissionControl::Overloaded() const noexcept {
+  const size_t depth = depth_.load(std::memory_order_relaxed);
+  if (settings_.max_queue_depth != 0 && depth >= settings_.max_queue_depth) {
+    return true;
+  }
+  /* Среднее обновляется только при выходе из очереди, поэтому при пустой
+     очереди оно устаревшее: новый запрос всё равно выполнится сразу */
+  if (settings_.max_queue_delay.count() != 0 && depth != 0) {
+    const std::chrono::nanoseconds delay{
+        queue_delay_ns_.load(std::memory_order_relaxed)};
+    return delay >= settings_.max_queue_delay;
+  }
+  return false;
+}
+
+bool AdmissionControl::RepeatedStatePoll(std::string_view authorization,
+                                         uint64_t tick) noexcept {
+  if (authorization.substr(0, BEARER.size()) != BEARER) {
+    return false;
+  }
+  const size_t hash =
+      std::hash<std::string_view>{}(authorization.substr(BEARER.size()));
+  const uint64_t fingerprint = static_cast<uint64_t>(hash) >> 32;
+  const uint64_t poll = (fingerprint << 32) | (tick & 0xFFFFFFFFu);
+  auto &slot = state_polls_[hash % STATE_POLL_SLOTS];
+  return slot.exchange(poll, std::memory_order_relaxed) == poll;
+}
+
+bool AdmissionControl::ShouldShed(Route route, std::string_view authorization,
+                                  uint64_t tick) noexcept {
+  if (!Enabled()) {
+    return false;
+  }
+  metrics::Counter *counter = nullptr;
+  switch (route) {
+  case Route::RECORDS:
+    counter = Overloaded() ? &shed_records_ : nullptr;
+    break;
+  case Route::PLAYERS:
+    counter = Overloaded() ? &shed_players_ : nullptr;
+    break;
+  case Route::STATE:
+    /* Опрос запоминается всегда, чтобы первый опрос в тике не был отклонён */
+    counter = RepeatedStatePoll(authorization, tick) && Overloaded()
+                  ? &shed_state_
+                  : nullptr;
+    break;
+  default:
+    break;
+  }
+  if (counter == nullptr) {
+    return false;
+  }
+  counter->Increment();
+  return true;
+}
+
+} // namespace http_handler
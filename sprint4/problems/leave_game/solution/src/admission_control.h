@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "metrics.h"
+#include "request_metrics.h"
+
+namespace http_handler {
+
+struct AdmissionSettings {
+  // Нулевое значение отключает соответствующий порог
+  size_t max_queue_depth = 0;
+  std::chrono::milliseconds max_queue_delay{0};
+  std::chrono::seconds retry_after{1};
+};
+
+/*
+    Контроль допуска запросов в API strand. Считает число запросов, ожидающих
+    strand, и сглаженное время ожидания. Пока хотя бы один порог превышен,
+    второстепенные запросы (/records, /players и повторный /state того же игрока
+    в пределах одного тика) отклоняются ещё до постановки в очередь.
+    Вход в игру и действия игроков не отклоняются никогда.
+    Все методы потокобезопасны и не берут блокировок.
+*/
+class AdmissionControl {
+public:
+  explicit AdmissionControl(AdmissionSettings settings);
+
+  bool Enabled() const noexcept {
+    return settings_.max_queue_depth != 0 || settings_.max_queue_delay.count() != 0;
+  }
+
+  // Решение принимается до dispatch в strand. authorization - значение
+  // заголовка Authorization, tick - номер текущего тика игры
+  bool ShouldShed(Route route, std::string_view authorization, uint64_t tick) noexcept;
+
+  // Запрос поставлен в очередь strand
+  void Enqueued() noexcept;
+
+  // Запрос начал выполняться в strand после ожидания wait
+  void Dequeued(metrics::Clock::duration wait) noexcept;
+
+  bool Overloaded() const noexcept;
+
+  std::chrono::seconds RetryAfter() const noexcept { return settings_.retry_after; }
+
+private:
+  // Таблица последних опросов /state: отпечаток токена в старших 32 битах,
+  // номер тика в младших. Коллизия слотов лишь пропускает повторный опрос
+  static constexpr size_t STATE_POLL_SLOTS = 4096;
+
+  bool RepeatedStatePoll(std::string_view authorization, uint64_t tick) noexcept;
+
+  AdmissionSettings settings_;
+  std::atomic<size_t> depth_{0};
+  // Экспоненциальное среднее времени ожидания в наносекундах с весом 1/8
+  std::atomic<int64_t> queue_delay_ns_{0};
+  std::array<std::atomic<uint64_t>, STATE_POLL_SLOTS> state_polls_{};
+
+  metrics::Gauge &depth_gauge_;
+  metrics::Counter &shed_records_;
+  metrics::Counter &shed_players_;
+  metrics::Counter &shed_state_;
+};
+
+} // namespace http_handler
@@ -2,38 +2,114 @@
 
 namespace app {
 
-    void PlayerTimeClock::IncreaseTime(size_t delta){
-    current_playtime += Milliseconds(delta);
-
-    if(inactivity_start_time_){
-        if(current_inactivity_time_){
-            current_inactivity_time_ = current_inactivity_time_.value() + Milliseconds(delta);
-        } else {
-            current_inactivity_time_ = inactivity_start_time_.value() + Milliseconds(delta);
+/*----------------------------------------PlayerActivity----------------------------------------*/
+
+    PlayerActivity::PlayerActivity(SharedPlayer player, util::TimingWheel& wheel, uint64_t retirement_time_ms)
+        : player_(std::move(player))
+        , wheel_(wheel)
+        , join_time_(wheel.Now())
+        , retirement_time_ms_(retirement_time_ms)
+    {
+        Dog* dog = player_->GetDog();
+        dog->SetActivityListener(this);
+        if (dog->IsStopped()) {
+            OnDogStopped(*dog);
         }
     }
-}
 
-std::optional<Milliseconds> PlayerTimeClock::GetInactivityTime() const{
-    if(current_inactivity_time_ && inactivity_start_time_){
-        return duration_cast<Milliseconds>(current_inactivity_time_.value() - inactivity_start_time_.value());
-    } else {
-        return std::nullopt;
+    PlayerActivity::~PlayerActivity()
+    {
+        player_->GetDog()->SetActivityListener(nullptr);
+    }
+
+    void PlayerActivity::OnDogStopped(const Dog&)
+    {
+        wheel_.Schedule(*this, wheel_.Now() + retirement_time_ms_);
+    }
+
+    void PlayerActivity::OnDogStartedMoving(const Dog&)
+    {
+        wheel_.Cancel(*this);
+    }
+
+    Milliseconds PlayerActivity::GetPlaytime() const
+    {
+        return Milliseconds(wheel_.Now() - join_time_);
+    }
+
+/*----------------------------------------GameMetrics----------------------------------------*/
+
+    GameMetrics& GameMetrics::Instance()
+    {
+        static GameMetrics instance;
+        return instance;
+    }
+
+    GameMetrics::GameMetrics()
+        : tick_duration_(metrics::DefaultRegistry()
+              .AddHistogram("game_tick_duration_seconds", "Duration of a game tick including periodic save")
+              .WithLabels({}))
+        , snapshot_duration_(metrics::DefaultRegistry()
+              .AddHistogram("game_snapshot_duration_seconds", "Duration of saving the game state to the state file")
+              .WithLabels({}))
+        , sessions_(metrics::DefaultRegistry().AddGauge("game_sessions", "Number of game sessions", {"map"}))
+        , dogs_(metrics::DefaultRegistry().AddGauge("game_dogs", "Number of dogs in sessions", {"map"}))
+        , loot_(metrics::DefaultRegistry().AddGauge("game_loot", "Number of lost objects in sessions", {"map"}))
+        , tick_arena_heap_allocations_(metrics::DefaultRegistry()
+              .AddGauge("game_tick_arena_heap_allocations", "Heap allocations of the tick arena during the last tick")
+              .WithLabels({}))
+        , tick_arena_buffer_bytes_(metrics::DefaultRegistry()
+              .AddGauge("game_tick_arena_buffer_bytes", "Size of the tick arena buffer")
+              .WithLabels({}))
+    {
     }
-}
 
-void PlayerTimeClock::UpdateActivity(Dog::Speed new_speed){
-    if(inactivity_start_time_.has_value() && new_speed != Dog::Speed({0, 0})){
-        inactivity_start_time_ = std::nullopt;
-        current_inactivity_time_ = std::nullopt;
-    } else if(!inactivity_start_time_.has_value() && new_speed == Dog::Speed({0, 0})){
-        inactivity_start_time_ = Clock::now();
-    } 
-}
+    GameMetrics::MapGauges& GameMetrics::GetMapGauges(const Map::Id& map_id)
+    {
+        if (auto it = map_gauges_.find(map_id); it != map_gauges_.end()) {
+            return it->second;
+        }
+        metrics::LabelValues labels{*map_id};
+        MapGauges gauges{sessions_.WithLabels(labels), dogs_.WithLabels(labels), loot_.WithLabels(labels)};
+        return map_gauges_.emplace(map_id, gauges).first->second;
+    }
 
-Milliseconds PlayerTimeClock::GetPlaytime() const{
-    return duration_cast<Milliseconds>(current_playtime - log_in_time_);
-}
+    void GameMetrics::UpdateSessionGauges(const Game& game)
+    {
+        const Game::SessionsByMapId& all_sessions = game.GetAllSessions();
+        for (const Map& map : game.GetMaps()) {
+            int64_t sessions_count = 0;
+            int64_t dogs_count = 0;
+            int64_t loot_count = 0;
+            if (auto it = all_sessions.find(map.GetId()); it != all_sessions.end()) {
+                for (const GameSession& session : it->second) {
+                    ++sessions_count;
+                    dogs_count += session.GetDogs().size();
+                    loot_count += session.GetLootObjects().size();
+                }
+            }
+            MapGauges& gauges = GetMapGauges(map.GetId());
+            gauges.sessions.Set(sessions_count);
+            gauges.dogs.Set(dogs_count);
+            gauges.loot.Set(loot_count);
+        }
+
+        for (auto it = map_gauges_.begin(); it != map_gauges_.end();) {
+            if (game.FindMap(it->first) != nullptr) {
+                ++it;
+                continue;
+            }
+            metrics::LabelValues labels{*it->first};
+            it = map_gauges_.erase(it);
+            sessions_.Remove(labels);
+            dogs_.Remove(labels);
+            loot_.Remove(labels);
+        }
+
+        const util::TickArena::Stats& arena = game.GetTickArenaStats();
+        tick_arena_heap_allocations_.Set(static_cast<int64_t>(arena.heap_allocations));
+        tick_arena_buffer_bytes_.Set(static_cast<int64_t>(arena.buffer_size));
+    }
 
 /*----------------------------------------JoinGameError----------------------------------------*/
 
@@ -71,8 +147,12 @@ Milliseconds PlayerTimeClock::GetPlaytime() const{
 
     std::string GameStateUseCase::Join(std::string &map_id, std::string &user_name, bool random_spawn)
     {
+        TRACE_SCOPE("GameStateUseCase::Join");
 
-        if (game_.FindMap(model::Map::Id(map_id)) == nullptr) {
+        // Имя из запроса только ищется: неизвестные имена не попадают в таблицу id
+        const std::optional<model::Map::Id> id = model::Map::Id::Find(map_id);
+        const model::Map *map = id ? game_.FindMap(*id) : nullptr;
+        if (map == nullptr) {
             throw JoinGameError(JoinGameErrorReason::InvalidMap);
         }
 
@@ -81,16 +161,12 @@ Milliseconds PlayerTimeClock::GetPlaytime() const{
         }
 
         model::GameSession *game_session =
-            game_.SessionIsExists(model::Map::Id(map_id));
-
-        if (game_session == nullptr) {
-            game_session = game_.AddSession(model::Map::Id(map_id));
-        }
+            game_.FindSessionForNewDog(*id);
 
         Dog::Name dog_name(user_name);
         Dog::Position dog_pos = (random_spawn) 
-            ? Dog::Position(Map::GetRandomPos(game_.FindMap(model::Map::Id(map_id))->GetRoads())) 
-            : Dog::Position(Map::GetFirstPos(game_.FindMap(model::Map::Id(map_id))->GetRoads()));
+            ? Dog::Position(map->GetRandomPos()) 
+            : Dog::Position(Map::GetFirstPos(map->GetRoads()));
         Dog::Speed dog_speed({0, 0});
         Direction dog_dir = Direction::NORTH;
 
@@ -103,7 +179,7 @@ Milliseconds PlayerTimeClock::GetPlaytime() const{
             players_.AddPlayer(random_id_, user_name, dog, game_session);
         random_id_++;
 
-        AddPlayerTimeClock(player.second);
+        AddPlayerActivity(player.second);
 
         json::object respons_body;
         respons_body["authToken"] = *player.first;
@@ -112,32 +188,51 @@ Milliseconds PlayerTimeClock::GetPlaytime() const{
         return json::serialize(respons_body);
     }
 
-    std::string GameStateUseCase::GetState(Token token) const 
+    std::string GameStateUseCase::GetState(Token token, StateEncoding encoding) const
         {
-            const GameSession *game_session = players_.FindByToken(token)->GetGameSession();
-
-            auto players = players_.FindPlayersBySession(game_session);
-
-            json::object player;
-            player["players"] = GetPlayersForState(players);
-            player["lostObjects"] = GetLootObject(game_session);
-            return json::serialize(player);
+            TRACE_SCOPE("GameStateUseCase::GetState");
+            const StateView view = CollectState(players_.FindByToken(token));
+            if (encoding == StateEncoding::MSGPACK) {
+                return EncodeStateMsgPack(view);
+            }
+            return EncodeStateJson(view);
         }
 
-    std::pair<double, double>
-    GameStateUseCase::RandomPos(const model::Map::Roads &roads) const
+    GameStateUseCase::StateView GameStateUseCase::CollectState(const SharedPlayer &player) const
     {
-        double road_id = GetRandomInt(0, roads.size());
-        const model::Road &road = roads[road_id];
+        const GameSession *game_session = player->GetGameSession();
+        StateView view;
+
+        const double radius = game_session->GetMap()->GetInterestRadius();
+        if (radius <= 0) {
+            view.players = players_.FindPlayersBySession(game_session);
+            view.loot.reserve(game_session->GetLootObjects().size());
+            for (const Loot &loot : game_session->GetLootObjects()) {
+                view.loot.push_back(&loot);
+            }
+            return view;
+        }
 
-        if (road.IsHorizontal()) {
-            double x = GetRandomInt(road.GetStart().x, road.GetEnd().x);
-            double y = road.GetStart().y;
-            return {x, y};
+        const Dog *own_dog = player->GetDog();
+        const model::PairDouble center = *own_dog->GetPosition();
+        const Map::Id &map_id = game_session->GetMap()->GetId();
+
+        std::vector<const Dog*> dogs;
+        game_session->FindDogsInRadius(center, radius, dogs);
+
+        view.players.reserve(dogs.size() + 1);
+        view.players.push_back(player);
+        for (const Dog *dog : dogs) {
+            if (dog == own_dog) {
+                continue;
+            }
+            if (SharedPlayer other = players_.FindByDogIdAndMapId(dog->GetId(), map_id)) {
+                view.players.push_back(std::move(other));
+            }
         }
-        double x = road.GetStart().x;
-        double y = GetRandomInt(road.GetStart().y, road.GetEnd().y);
-        return {x, y};
+
+        game_session->FindLootInRadius(center, radius, view.loot);
+        return view;
     }
 
     model::PairDouble
@@ -168,20 +263,18 @@ Milliseconds PlayerTimeClock::GetPlaytime() const{
         return json::serialize(records);
     }
 
-    void GameStateUseCase::AddPlayerTimeClock(SharedPlayer player) {
-       auto emplace_result = clocks_.emplace(player, PlayerTimeClock());
-        if(emplace_result.second){
-            PlayerTimeClock& clock = emplace_result.first->second;
-            emplace_result.first->first->SetPlayerTimeClock([&clock](Dog::Speed new_speed){
-                clock.UpdateActivity(new_speed);
-            });        
-        }  
+    void GameStateUseCase::AddPlayerActivity(SharedPlayer player) {
+        const Player* key = player.get();
+        const uint64_t retirement_time_ms =
+            static_cast<uint64_t>(game_.GetDogRetirementTime()) * kMillisecondsInSecond;
+        activities_.try_emplace(key, std::move(player), retirement_wheel_, retirement_time_ms);
     }
 
     void GameStateUseCase::SaveScore(const SharedPlayer player, Game& game) {
+        TRACE_SCOPE("GameStateUseCase::SaveScore");
         std::string name = player->GetName();
         int score = player->GetDog()->GetScore();
-        double given_time = static_cast<double>(clocks_.at(player).GetPlaytime().count()) / 1000;
+        double given_time = static_cast<double>(activities_.at(player.get()).GetPlaytime().count()) / 1000;
         double time = std::min(given_time, static_cast<double>(game.GetDogRetirementTime()));
         
         db_manager_->InsertData(name, score, time);
@@ -191,8 +284,7 @@ Milliseconds PlayerTimeClock::GetPlaytime() const{
         const GameSession* player_game_session = player->GetGameSession();
         const Dog* player_dog =  player->GetDog();
 
-        auto it = clocks_.find(player);
-        clocks_.erase(it);
+        activities_.erase(player.get());
         players_.DeletePlayer(player);
 
         game.DisconnectDogFromSession(player_game_session, player_dog);
@@ -4,16 +4,22 @@
 #include <boost/asio/strand.hpp>
 #include <boost/json.hpp>
 #include <boost/json/object.hpp>
+#include <atomic>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <optional>
 #include <random>
 
+#include "boost_logger.h"
 #include "model.h"
 #include "players.h"
 #include "model_serialization.h"
 #include "connection_pool.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "timing_wheel.h"
+#include "msgpack_writer.h"
 
 namespace app {
     namespace net = boost::asio;
@@ -75,26 +81,77 @@ namespace app {
         std::chrono::steady_clock::time_point last_tick_;
     };
 
-    class PlayerTimeClock{
+    /*
+        Учёт игрового времени игрока. Время отсчитывается по колесу таймеров
+        (миллисекунды игрового времени). Пока собака стоит, узел ждёт в колесе
+        срока отправки на пенсию; когда собака трогается, узел снимается.
+    */
+    class PlayerActivity : public util::TimerNode, public model::DogActivityListener{
     public:
-        PlayerTimeClock() = default;
+        PlayerActivity(SharedPlayer player, util::TimingWheel& wheel, uint64_t retirement_time_ms);
 
-        void IncreaseTime(size_t delta);
+        PlayerActivity(const PlayerActivity&) = delete;
+        PlayerActivity& operator=(const PlayerActivity&) = delete;
 
-        std::optional<Milliseconds> GetInactivityTime() const;
+        ~PlayerActivity();
 
-        void UpdateActivity(Dog::Speed new_speed);
+        void OnDogStopped(const Dog& dog) override;
+
+        void OnDogStartedMoving(const Dog& dog) override;
+
+        const SharedPlayer& GetPlayer() const {
+            return player_;
+        }
 
         Milliseconds GetPlaytime() const;
     private:
-        Clock::time_point log_in_time_ = Clock::now();
-        Clock::time_point current_playtime = Clock::now();
-        std::optional<Clock::time_point> inactivity_start_time_ = Clock::now();
-        std::optional<Clock::time_point> current_inactivity_time_;
+        SharedPlayer player_;
+        util::TimingWheel& wheel_;
+        uint64_t join_time_;
+        uint64_t retirement_time_ms_;
     };
 
     namespace json = boost::json;
 
+    /*-----------------------------------------------GameMetrics-----------------------------------------------*/
+
+    // Метрики игрового цикла: длительность тика и сохранения состояния,
+    // количество сессий, собак и потерянных предметов на каждой карте,
+    // обращения арены тика к куче
+    class GameMetrics
+    {
+    public:
+        static GameMetrics& Instance();
+
+        metrics::Histogram& TickDuration() { return tick_duration_; }
+
+        metrics::Histogram& SnapshotDuration() { return snapshot_duration_; }
+
+        // Вызывается внутри strand после каждого тика.
+        // Метрики карт, убранных перезагрузкой конфигурации, снимаются с экспорта
+        void UpdateSessionGauges(const Game& game);
+
+    private:
+        GameMetrics();
+
+        struct MapGauges {
+            metrics::Gauge& sessions;
+            metrics::Gauge& dogs;
+            metrics::Gauge& loot;
+        };
+
+        MapGauges& GetMapGauges(const Map::Id& map_id);
+
+        metrics::Histogram& tick_duration_;
+        metrics::Histogram& snapshot_duration_;
+        metrics::Family<metrics::Gauge>& sessions_;
+        metrics::Family<metrics::Gauge>& dogs_;
+        metrics::Family<metrics::Gauge>& loot_;
+        metrics::Gauge& tick_arena_heap_allocations_;
+        metrics::Gauge& tick_arena_buffer_bytes_;
+        std::unordered_map<Map::Id, MapGauges, util::InternedIdHasher<Map::Id>> map_gauges_;
+    };
+
     /*-----------------------------------------------JoinGameError-----------------------------------------------*/
 
     enum class JoinGameErrorReason
@@ -148,45 +205,139 @@ namespace app {
 
     /*-----------------------------------------------GameStateUseCase-----------------------------------------------*/
 
+    // Кодировка ответа о состоянии: выбирается по заголовку Accept, по умолчанию JSON
+    enum class StateEncoding {
+        JSON,
+        MSGPACK
+    };
+
     class GameStateUseCase
     {
     public:
-        // Специальная хэш-функция для shared_ptr
-        struct SharedPlayerHash {
-            std::size_t operator()(const SharedPlayer& player) const {
-                return std::hash<const Player*>()(player.get());
-            }
+        // Игроки и трофеи, попадающие в ответ о состоянии
+        struct StateView {
+            std::vector<SharedPlayer> players;
+            std::vector<const Loot*> loot;
         };
 
-        // Специальный компаратор для shared_ptr
-        struct SharedPlayerEqual {
-            bool operator()(const SharedPlayer& p1, const SharedPlayer& p2) const {
-                return p1.get() == p2.get();
-            }
-        };
-
-        using PlayerTimeClocks = std::unordered_map<const SharedPlayer, PlayerTimeClock, SharedPlayerHash, SharedPlayerEqual>;
+        // Узлы unordered_map не перемещаются, поэтому PlayerActivity хранится по значению
+        using PlayerActivities = std::unordered_map<const Player*, PlayerActivity>;
 
         GameStateUseCase(Players &players, DatabaseManagerPtr&& db, Game &game) : players_(players), db_manager_(std::move(db)), game_(game) {}
 
-        std::string GetState(Token token) const;
+        std::string GetState(Token token, StateEncoding encoding = StateEncoding::JSON) const;
+
+        static std::string EncodeStateJson(const StateView &view)
+        {
+            json::object state;
+            state["players"] = GetPlayersForState(view.players);
+            state["lostObjects"] = GetLootObject(view.loot);
+            return json::serialize(state);
+        }
+
+        /*
+            Та же схема, что у JSON (словари с id-строками в ключах), но в MessagePack:
+            координаты - float 64 без текстового форматирования, целые - в кратчайшей форме
+        */
+        static std::string EncodeStateMsgPack(const StateView &view)
+        {
+            std::string out;
+            msgpack::Writer writer(out);
+            writer.MapHeader(2);
+
+            writer.String("players");
+            writer.MapHeader(static_cast<uint32_t>(view.players.size()));
+            for (const SharedPlayer &player : view.players) {
+                const Dog *dog = player->GetDog();
+                writer.String(std::to_string(player->GetId()));
+                writer.MapHeader(5);
+
+                writer.String("pos");
+                writer.ArrayHeader(2);
+                writer.Double((*dog->GetPosition()).x);
+                writer.Double((*dog->GetPosition()).y);
+
+                writer.String("speed");
+                writer.ArrayHeader(2);
+                writer.Double((*dog->GetSpeed()).x);
+                writer.Double((*dog->GetSpeed()).y);
+
+                writer.String("dir");
+                writer.String(DirectionCode(dog->GetDirection()));
+
+                writer.String("bag");
+                writer.ArrayHeader(static_cast<uint32_t>((*dog->GetBag()).size()));
+                for (const Loot &loot : *dog->GetBag()) {
+                    writer.MapHeader(2);
+                    writer.String("id");
+                    writer.Int(loot.id);
+                    writer.String("type");
+                    writer.Int(loot.type);
+                }
+
+                writer.String("score");
+                writer.Int(dog->GetScore());
+            }
+
+            writer.String("lostObjects");
+            writer.MapHeader(static_cast<uint32_t>(view.loot.size()));
+            for (const Loot *loot : view.loot) {
+                writer.String(std::to_string(loot->id));
+                writer.MapHeader(2);
+                writer.String("type");
+                writer.Int(loot->type);
+                writer.String("pos");
+                writer.ArrayHeader(2);
+                writer.Double(loot->pos.x);
+                writer.Double(loot->pos.y);
+            }
+            return out;
+        }
+
+        static std::string_view DirectionCode(Direction dir)
+        {
+            switch (dir) {
+                case Direction::NORTH: return "U";
+                case Direction::SOUTH: return "D";
+                case Direction::WEST: return "L";
+                case Direction::EAST: return "R";
+            }
+            assert(false);
+            return "Unknown";
+        }
 
         static json::object GetLootObject(const GameSession *session)
         {
             json::object loots;
             for (const Loot &loot : session->GetLootObjects()) {
-                json::object loot_decs;
+                AddLootDesc(loots, loot);
+            }
 
-                loot_decs["type"] = loot.type;
-                json::array pos = {loot.pos.x, loot.pos.y};
-                loot_decs["pos"] = pos;
+            return loots;
+        }
 
-                loots[std::to_string(loot.id)] = loot_decs;
+        // Только трофеи из области интереса игрока
+        static json::object GetLootObject(const std::vector<const Loot*> &visible_loot)
+        {
+            json::object loots;
+            for (const Loot *loot : visible_loot) {
+                AddLootDesc(loots, *loot);
             }
 
             return loots;
         }
 
+        static void AddLootDesc(json::object &loots, const Loot &loot)
+        {
+            json::object loot_decs;
+
+            loot_decs["type"] = loot.type;
+            json::array pos = {loot.pos.x, loot.pos.y};
+            loot_decs["pos"] = pos;
+
+            loots[std::to_string(loot.id)] = loot_decs;
+        }
+
         static json::object
         GetPlayersForState(const std::vector<SharedPlayer> &players)
         {
@@ -201,19 +352,7 @@ namespace app {
                 const Dog::Speed speed = player->GetDog()->GetSpeed();
                 player_state["speed"] = {speed.operator*().x, speed.operator*().y};
 
-                Direction dir = player->GetDog()->GetDirection();
-                if (dir == Direction::NORTH) {
-                    player_state["dir"] = "U";
-                } else if (dir == Direction::SOUTH) {
-                    player_state["dir"] = "D";
-                } else if (dir == Direction::WEST) {
-                    player_state["dir"] = "L";
-                } else if (dir == Direction::EAST) {
-                    player_state["dir"] = "R";
-                } else {
-                    player_state["dir"] = "Unknown";
-                    assert(false);
-                }
+                player_state["dir"] = DirectionCode(player->GetDog()->GetDirection());
 
                 player_state["bag"] = GetBagItems(player->GetDog()->GetBag());
                 player_state["score"] = player->GetDog()->GetScore();
@@ -223,11 +362,18 @@ namespace app {
             return id;
         }
 
+        // Допустимые значения поля move: L, R, U, D и пустая строка - остановка
+        static bool IsValidMove(std::string_view move_dir)
+        {
+            return move_dir.empty() || move_dir == "L" || move_dir == "R" || move_dir == "U" || move_dir == "D";
+        }
+
         static std::string SetPlayerAction(SharedPlayer player,
                                            std::string move_dir)
         {
             float dog_speed = player->GetGameSession()->GetMap()->GetDogSpeed();
-            Direction new_dir;
+            // Пустая команда останавливает собаку, направление остаётся прежним
+            Direction new_dir = player->GetDog()->GetDirection();
             Dog::Speed new_speed({0, 0});
 
             if (move_dir == "U") {
@@ -242,7 +388,7 @@ namespace app {
             } else if (move_dir == "R") {
                 new_speed = Dog::Speed({dog_speed, 0});
                 new_dir = Direction::EAST;
-            } else {
+            } else if (!move_dir.empty()) {
                 assert(false);
             }
 
@@ -253,22 +399,19 @@ namespace app {
 
         std::string TickTimeUseCase(double tick, Game &game)
         {
-            std::deque<SharedPlayer> retired_players;
-            for(auto& [player, clock] : clocks_){
-                clock.IncreaseTime(tick);
-                auto inactivity_time = clock.GetInactivityTime();
-                if(inactivity_time.has_value()){
-                    int converted_time_ms = static_cast<double>(inactivity_time->count());
-                    if(converted_time_ms >= (game.GetDogRetirementTime() * kMillisecondsInSecond)){
-                        retired_players.push_back(player);
-                    }
-                }
-            }
+            TRACE_SCOPE("GameStateUseCase::TickTimeUseCase");
+            // Колесо затрагивает только истёкшие слоты, а не всех игроков
+            retired_players_.clear();
+            retirement_wheel_.Advance(retirement_wheel_.Now() + static_cast<uint64_t>(tick),
+                [this](util::TimerNode& node){
+                    retired_players_.push_back(static_cast<PlayerActivity&>(node).GetPlayer());
+                });
 
-            for(const SharedPlayer player : retired_players){
+            for(const SharedPlayer& player : retired_players_){
                 SaveScore(player, game);
                 DisconnectPlayer(player, game);
             }
+            retired_players_.clear();
             game.UpdateGameState(tick);
             return "{}";
         }
@@ -291,7 +434,7 @@ namespace app {
 
         std::string GetRecords(int start, int max_items);
 
-        void AddPlayerTimeClock(SharedPlayer player);
+        void AddPlayerActivity(SharedPlayer player);
 
         void SaveScore(const SharedPlayer player, Game& game);
 
@@ -299,25 +442,19 @@ namespace app {
 
         std::string Join(std::string &map_id, std::string &user_name, bool random_spawn);
 
-        std::pair<double, double> RandomPos(const Map::Roads &roads) const;
-
-        static double GetRandomInt(int first, int second)
-        {
-            std::minstd_rand generator(static_cast<int>(
-                std::chrono::system_clock::now().time_since_epoch().count()));
-
-            std::uniform_int_distribution<int> distribution(first, second);
-
-            double random_number = distribution(generator);
-
-            return random_number;
-        }
-
         PairDouble GetFirstPos(const Map::Roads &roads) const;
 
     private:
+        /*
+            Вся сессия либо, если у карты задан interestRadius, игроки и трофеи
+            в этом радиусе от собаки игрока; сам игрок включается всегда
+        */
+        StateView CollectState(const SharedPlayer &player) const;
+
         Players &players_;
-        PlayerTimeClocks clocks_;
+        util::TimingWheel retirement_wheel_;
+        PlayerActivities activities_;
+        std::vector<SharedPlayer> retired_players_;
         DatabaseManagerPtr db_manager_;
         Game &game_;
         int random_id_ = 1;
@@ -337,6 +474,7 @@ namespace app {
 
         void SaveOnTick(bool is_periodic)
         {
+            TRACE_SCOPE("GameSaveCase::SaveOnTick");
             if (save_period_.has_value()) {
                 if (is_periodic) {
                     Clock::time_point this_tick = Clock::now();
@@ -355,6 +493,8 @@ namespace app {
         void SaveState()
         {
             using namespace std::literals;
+            TRACE_SCOPE("GameSaveCase::SaveState");
+            metrics::ScopedTimer snapshot_timer{GameMetrics::Instance().SnapshotDuration()};
             std::fstream fstrm(state_file_, std::ios::out);
             boost::archive::text_oarchive output_archive{fstrm};
             serialization::GameStateRepr writed_game_state(sessions_, players_);
@@ -405,7 +545,7 @@ namespace app {
             if (tick.has_value()) {
             time_ticker_ = std::make_shared<app::Ticker>(
                 api_strand_, FromInt(*tick), [this](Milliseconds delta) {
-                    this->TickTime(delta.count() / kMillisecondsInSecond);
+                    this->TickTime(delta.count());
                 });
             time_ticker_->Start();
 
@@ -437,7 +577,9 @@ namespace app {
             return players_.FindByToken(token);
         }
 
-        std::string GetGameState(Token token) { return game_state_.GetState(token); }
+        std::string GetGameState(Token token, StateEncoding encoding = StateEncoding::JSON) {
+            return game_state_.GetState(token, encoding);
+        }
 
         std::string PlayerAction(SharedPlayer player,
                                  std::string move_dir)
@@ -447,17 +589,28 @@ namespace app {
 
         std::string TickTime(double tick)
         {
+            TRACE_SCOPE("Aplication::TickTime");
+            const metrics::Clock::time_point tick_start = metrics::Clock::now();
             std::string res = game_state_.TickTimeUseCase(tick, game_);
             if (save_case_.has_value()) {
                 save_case_.value().SaveOnTick(tick_.has_value());
             }
+            GameMetrics::Instance().TickDuration().RecordDuration(metrics::Clock::now() - tick_start);
+            GameMetrics::Instance().UpdateSessionGauges(game_);
+            tick_count_.fetch_add(1, std::memory_order_relaxed);
             return res;
         }
 
         bool IsTickSet() { return tick_.has_value(); }
 
+        // Номер текущего тика; можно читать вне strand
+        uint64_t GetTickCount() const noexcept {
+            return tick_count_.load(std::memory_order_relaxed);
+        }
+
         void GenerateLoot(model::detail::Milliseconds delta)
         {
+            TRACE_SCOPE("Aplication::GenerateLoot");
             return game_state_.GenerateLoot(delta, game_);
         }
 
@@ -476,18 +629,41 @@ namespace app {
             return game_state_.GetRecords(start, max_items);
         }
 
+        /*
+            Снимок не хранит версию карты: сессии, сохранённые до перезагрузки
+            конфигурации, восстанавливаются на текущей карте с тем же id.
+            Собаки вне дорог новой карты ставятся на точку появления, трофеи
+            вне дорог или с неизвестным типом отбрасываются. Сессии карт,
+            которых больше нет в конфигурации, пропускаются.
+        */
         void LoadState()
         {
             if (save_case_.has_value()) {
                 auto game_state = save_case_.value().LoadState();
                 for (const auto &[map_id, sessions] : game_state.GetAllSessions()) {
+                    // Поиск без интернирования: имя удалённой карты не попадает в таблицу
+                    const std::optional<Map::Id> id = Map::Id::Find(map_id);
+                    const Map *map = id ? game_.FindMap(*id) : nullptr;
+                    if (map == nullptr) {
+                        size_t dropped_players = 0;
+                        for (const auto &session_repr : sessions) {
+                            dropped_players += session_repr.GetDogsRepr().size();
+                        }
+                        logger::LogSessionsSkipped(map_id, dropped_players);
+                        continue;
+                    }
                     for (const auto &session_repr : sessions) {
-                        GameSession *session = game_.AddSession(Map::Id(map_id));
+                        GameSession *session = game_.AddSession(*id);
                         // Загрузка потерянных объектов
-                        session->SetLootObjects(session_repr.GetLoot());
+                        session->SetLootObjects(FitLootToMap(session_repr.GetLoot(), *map));
                         for (const auto &dog_repr : session_repr.GetDogsRepr()) {
                             // Загрузка собаки
-                            Dog *created_dog = session->AddCreatedDog(dog_repr.Restore());
+                            Dog restored_dog = dog_repr.Restore();
+                            if (map->FindRoadsByCoords(restored_dog.GetPosition()).empty()) {
+                                restored_dog.SetPosition(SpawnPosition(*map));
+                                restored_dog.SetSpeed(Dog::Speed({0, 0}));
+                            }
+                            Dog *created_dog = session->AddCreatedDog(std::move(restored_dog));
                             const auto &player_repr = dog_repr.GetPlayerRepr();
                             // Загрузка игрока
                             auto added_player =
@@ -499,6 +675,7 @@ namespace app {
                                                      
                             std::cout << player_repr.GetToken() << " Token in app " << std::endl;
                             players_.LoadPlayerInSession(added_player.second, session);
+                            game_state_.AddPlayerActivity(added_player.second);
                         }
                     }
                 }
@@ -508,12 +685,32 @@ namespace app {
         
 
     private:
+        Dog::Position SpawnPosition(const Map &map) const
+        {
+            return random_spawn_ ? Dog::Position(map.GetRandomPos())
+                                 : Dog::Position(Map::GetFirstPos(map.GetRoads()));
+        }
+
+        // Трофеи снимка, которые есть на дорогах карты и чей тип карта знает
+        static std::list<Loot> FitLootToMap(const std::list<Loot> &loot, const Map &map)
+        {
+            std::list<Loot> fitted;
+            for (const Loot &item : loot) {
+                if (item.type >= 0 && static_cast<size_t>(item.type) < map.GetLootTypes().size()
+                    && !map.FindRoadsByCoords(Dog::Position(item.pos)).empty()) {
+                    fitted.push_back(item);
+                }
+            }
+            return fitted;
+        }
+
         Game &game_;
         Players players_;
         GameStateUseCase game_state_;
         bool random_spawn_;
         Strand api_strand_;
         std::optional<int> tick_;
+        std::atomic<uint64_t> tick_count_{0};
         std::optional<GameSaveCase> save_case_;
         std::shared_ptr<Ticker> time_ticker_;
         std::shared_ptr<Ticker> loot_ticker_;
@@ -59,6 +59,14 @@ void LogResponseSent(int response_time, int code,
     , LogMessages::RESPONSE_SENT);
 }
 
+void LogConfigReloaded(size_t maps) {
+  Log({{"maps"s, maps}}, LogMessages::CONFIG_RELOADED);
+}
+
+void LogSessionsSkipped(const std::string &map, size_t players) {
+  Log({{"map"s, map}, {"players"s, players}}, LogMessages::SESSIONS_SKIPPED);
+}
+
 void LogError(int code, const std::string &text, const std::string &where) {
   Log({{"code"s, code}, {"text"s, text}, {"where"s, where}},
       LogMessages::ERROR);
@@ -22,24 +22,26 @@ enum class LogMessages {
   SERVER_EXITED,
   REQUEST_RECEIVED,
   RESPONSE_SENT,
+  CONFIG_RELOADED,
+  SESSIONS_SKIPPED,
   ERROR
 };
 
+// Замеряет время обработки одного запроса. Start() вызывается при получении
+// каждого запроса, End() возвращает миллисекунды, прошедшие с момента Start()
 class Timer {
 public:
-  void Start() { start_ = std::chrono::system_clock::now(); }
-
-  size_t End() {
-    auto dur = std::chrono::duration_cast<std::chrono::milliseconds>(
-                   std::chrono::system_clock::now() - start_)
-                   .count();
-    start_.min();
-    return dur;
+  void Start() { start_ = std::chrono::steady_clock::now(); }
+
+  size_t End() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - start_)
+        .count();
   }
 
 private:
-  std::chrono::system_clock::time_point start_ =
-      std::chrono::system_clock::now();
+  std::chrono::steady_clock::time_point start_ =
+      std::chrono::steady_clock::now();
 };
 
 static const std::unordered_map<LogMessages, std::string> StrMessages{
@@ -47,6 +49,8 @@ static const std::unordered_map<LogMessages, std::string> StrMessages{
     {LogMessages::SERVER_EXITED, "server exited"},
     {LogMessages::REQUEST_RECEIVED, "request received"},
     {LogMessages::RESPONSE_SENT, "response sent"},
+    {LogMessages::CONFIG_RELOADED, "config reloaded"},
+    {LogMessages::SESSIONS_SKIPPED, "saved sessions skipped"},
     {LogMessages::ERROR, "error"},
 };
 
@@ -68,6 +72,11 @@ void LogRequestReceived(const std::string &ip, const std::string &URI,
 void LogResponseSent(int response_time, int code,
                      const std::string &content_type);
 
+void LogConfigReloaded(size_t maps);
+
+// Сохранённые сессии карты, которой нет в конфигурации, и число выбывших игроков
+void LogSessionsSkipped(const std::string &map, size_t players);
+
 void LogError(int code, const std::string &text, const std::string &where);
 
 }; // namespace logger
\ No newline at end of file
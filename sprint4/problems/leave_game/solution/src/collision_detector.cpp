@@ -25,13 +25,17 @@ CollectionResult TryCollectPoint(Point2D a, Point2D b, Point2D c) {
 // В задании на разработку тестов реализовывать следующую функцию не нужно -
 // она будет линковаться извне.
 
-std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider){
-    std::vector<GatheringEvent> events;
-    for(size_t gatherer_id = 0; gatherer_id < provider.GatherersCount(); ++gatherer_id){
-        Gatherer gatherer = provider.GetGatherer(gatherer_id);
+namespace {
+
+/* GetItem(i) и GetGatherer(i) возвращают предмет и собирателя по индексу */
+template <typename GetItem, typename GetGatherer, typename Events>
+void FillGatherEvents(size_t items_count, GetItem get_item,
+                      size_t gatherers_count, GetGatherer get_gatherer, Events& events){
+    for(size_t gatherer_id = 0; gatherer_id < gatherers_count; ++gatherer_id){
+        const Gatherer gatherer = get_gatherer(gatherer_id);
         if(gatherer.start_pos != gatherer.end_pos){
-            for(size_t item_id = 0; item_id < provider.ItemsCount(); ++item_id){
-                Item item = provider.GetItem(item_id);
+            for(size_t item_id = 0; item_id < items_count; ++item_id){
+                const Item item = get_item(item_id);
                 CollectionResult res = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
 
                 if(res.IsCollected(gatherer.width + item.width)){
@@ -44,9 +48,40 @@ std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provide
     std::sort(events.begin(), events.end(), [](const GatheringEvent& lhs, const GatheringEvent& rhs){
         return lhs.time < rhs.time;
     });
+}
+
+template <typename Events>
+void FillGatherEvents(const ItemGathererProvider& provider, Events& events){
+    FillGatherEvents(
+        provider.ItemsCount(), [&provider](size_t idx){ return provider.GetItem(idx); },
+        provider.GatherersCount(), [&provider](size_t idx){ return provider.GetGatherer(idx); },
+        events);
+}
+
+} // namespace
 
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider){
+    std::vector<GatheringEvent> events;
+    FillGatherEvents(provider, events);
     return events;
 }
 
+std::pmr::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider,
+                                                  std::pmr::memory_resource* memory){
+    std::pmr::vector<GatheringEvent> events{memory};
+    FillGatherEvents(provider, events);
+    return events;
+}
+
+std::pmr::vector<GatheringEvent> FindGatherEvents(std::span<const Item> items,
+                                                  std::span<const Gatherer> gatherers,
+                                                  std::pmr::memory_resource* memory){
+    std::pmr::vector<GatheringEvent> events{memory};
+    FillGatherEvents(
+        items.size(), [items](size_t idx) -> const Item& { return items[idx]; },
+        gatherers.size(), [gatherers](size_t idx) -> const Gatherer& { return gatherers[idx]; },
+        events);
+    return events;
+}
 
 }  // namespace collision_detector
\ No newline at end of file
@@ -2,6 +2,8 @@
 
 #include "geom.h"
 #include <algorithm>
+#include <memory_resource>
+#include <span>
 #include <vector>
 
 namespace collision_detector {
@@ -57,4 +59,14 @@ struct GatheringEvent {
 // При проверке ваших тестов она не нужна - функция будет линковаться снаружи.
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
 
+// То же, но результат размещается в memory (например, в арене тика)
+std::pmr::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider,
+                                                  std::pmr::memory_resource* memory);
+
+// Предметы и собиратели в непрерывных массивах: без виртуальных вызовов во внутреннем цикле,
+// поэтому компилятор может его встроить и векторизовать. События те же, что у провайдера
+std::pmr::vector<GatheringEvent> FindGatherEvents(std::span<const Item> items,
+                                                  std::span<const Gatherer> gatherers,
+                                                  std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
 }  // namespace collision_detector
\ No newline at end of file
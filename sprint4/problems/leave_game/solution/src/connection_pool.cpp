@@ -1,9 +1,21 @@
 #include "connection_pool.h"
+#include "metrics.h"
 
 namespace db_connection{
 
+namespace {
+
+metrics::Histogram& PoolWaitHistogram(){
+    static metrics::Histogram& histogram = metrics::DefaultRegistry()
+        .AddHistogram("game_db_pool_wait_seconds", "Time spent waiting for a free database connection")
+        .WithLabels({});
+    return histogram;
+}
+
+} // namespace
 
 ConnectionPool::ConnectionWrapper ConnectionPool::GetConnection(){
+    metrics::ScopedTimer wait_timer{PoolWaitHistogram()};
     std::unique_lock lock{mutex_};
     cond_var_.wait(lock, [this] {
         return used_connections_ < pool_.size();
@@ -0,0 +1,509 @@
+#pragma once
+#include "http_server.h"
+
+#include <atomic>
+#include <boost/asio/steady_timer.hpp>
+#include <chrono>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <tuple>
+#include <utility>
+
+namespace http_server {
+
+/*
+  Память обработчиков асинхронных операций одного соединения: несколько
+  фиксированных слотов. У соединения одновременно живут одна-две операции
+  (чтение или запись, ожидание ответа, пробуждение из strand игры), поэтому
+  после первого запроса обработчики не обращаются к глобальной куче.
+  Крупные блоки и переполнение слотов уходят в operator new.
+  Слот может быть занят на потоке strand и освобождён на потоке соединения,
+  поэтому флаги атомарные. Аллокаторы владеют памятью совместно с сессией:
+  asio может освободить блок (например, вызывающий объект strand) уже после
+  уничтожения сессии.
+*/
+class HandlerMemory {
+public:
+  HandlerMemory() = default;
+  HandlerMemory(const HandlerMemory &) = delete;
+  HandlerMemory &operator=(const HandlerMemory &) = delete;
+
+  void *Allocate(std::size_t size) {
+    if (size <= SLOT_SIZE) {
+      for (Slot &slot : slots_) {
+        if (!slot.in_use.exchange(true, std::memory_order_acquire)) {
+          return slot.storage;
+        }
+      }
+    }
+    return ::operator new(size);
+  }
+
+  void Deallocate(void *pointer) noexcept {
+    for (Slot &slot : slots_) {
+      if (pointer == slot.storage) {
+        slot.in_use.store(false, std::memory_order_release);
+        return;
+      }
+    }
+    ::operator delete(pointer);
+  }
+
+private:
+  static constexpr std::size_t SLOT_SIZE = 1024;
+  static constexpr std::size_t SLOTS = 4;
+
+  struct Slot {
+    alignas(std::max_align_t) unsigned char storage[SLOT_SIZE];
+    std::atomic<bool> in_use{false};
+  };
+
+  Slot slots_[SLOTS];
+};
+
+// Аллокатор, который asio и beast берут у обработчика (associated_allocator)
+template <typename T> class HandlerAllocator {
+public:
+  using value_type = T;
+
+  explicit HandlerAllocator(std::shared_ptr<HandlerMemory> memory) noexcept
+      : memory_(std::move(memory)) {}
+
+  template <typename U>
+  HandlerAllocator(const HandlerAllocator<U> &other) noexcept
+      : memory_(other.memory_) {}
+
+  T *allocate(std::size_t n) {
+    return static_cast<T *>(memory_->Allocate(sizeof(T) * n));
+  }
+
+  void deallocate(T *pointer, std::size_t) noexcept {
+    memory_->Deallocate(pointer);
+  }
+
+  template <typename U>
+  bool operator==(const HandlerAllocator<U> &other) const noexcept {
+    return memory_ == other.memory_;
+  }
+
+private:
+  template <typename> friend class HandlerAllocator;
+
+  std::shared_ptr<HandlerMemory> memory_;
+};
+
+// Обработчик с памятью соединения; исполнитель остаётся от исходного обработчика
+template <typename Handler> class MemoryBoundHandler {
+public:
+  using allocator_type = HandlerAllocator<Handler>;
+  using executor_type = net::associated_executor_t<Handler>;
+
+  MemoryBoundHandler(const std::shared_ptr<HandlerMemory> &memory, Handler handler)
+      : memory_(memory), handler_(std::move(handler)) {}
+
+  allocator_type get_allocator() const noexcept { return allocator_type(memory_); }
+
+  executor_type get_executor() const noexcept {
+    return net::get_associated_executor(handler_);
+  }
+
+  template <typename... Args> void operator()(Args &&...args) {
+    std::move(handler_)(std::forward<Args>(args)...);
+  }
+
+private:
+  std::shared_ptr<HandlerMemory> memory_;
+  Handler handler_;
+};
+
+/*
+  Одноразовый слот для обработчика завершения без выделения памяти:
+  хранит обработчик во встроенном буфере до вызова Invoke.
+*/
+class CompletionSlot {
+public:
+  CompletionSlot() = default;
+  CompletionSlot(const CompletionSlot &) = delete;
+  CompletionSlot &operator=(const CompletionSlot &) = delete;
+
+  ~CompletionSlot() {
+    if (value_ != nullptr) {
+      value_->~Base();
+    }
+  }
+
+  template <typename Handler> void Emplace(Handler &&handler) {
+    using Typed = TypedHandler<std::decay_t<Handler>>;
+    static_assert(sizeof(Typed) <= CAPACITY && alignof(Typed) <= alignof(std::max_align_t));
+    value_ = new (storage_) Typed(std::forward<Handler>(handler));
+  }
+
+  // Обработчик извлекается из слота до вызова, поэтому внутри вызова слот снова свободен
+  void Invoke() {
+    Base *value = std::exchange(value_, nullptr);
+    value->InvokeAndDestroy();
+  }
+
+private:
+  static constexpr std::size_t CAPACITY = 128;
+
+  class Base {
+  public:
+    virtual ~Base() = default;
+    virtual void InvokeAndDestroy() = 0;
+  };
+
+  template <typename Handler> class TypedHandler final : public Base {
+  public:
+    explicit TypedHandler(Handler &&handler) : handler_(std::move(handler)) {}
+
+    void InvokeAndDestroy() override {
+      Handler handler = std::move(handler_);
+      this->~TypedHandler();
+      std::move(handler)();
+    }
+
+  private:
+    Handler handler_;
+  };
+
+  alignas(std::max_align_t) unsigned char storage_[CAPACITY];
+  Base *value_ = nullptr;
+};
+
+/*
+  Общая для всех обработчиков часть сессии на корутинах. В отличие от
+  SessionBase заголовки и тело запроса размещаются в пуле соединения,
+  ответ - во встроенном слоте, обработчики операций - в HandlerMemory,
+  и всё это переиспользуется между запросами keep-alive соединения.
+  Таймаут чтения ведёт один таймер соединения, который перезапускается
+  только при срабатывании: таймаут beast::basic_stream ждёт свой таймер на
+  каждой операции и выделяет память под any_io_executor.
+  Каждая операция ожидается напрямую, без вложенных корутин: кадры корутин
+  asio переиспользует через кэш потока, а он рассчитан на один кадр.
+*/
+class CoroSessionBase {
+public:
+  /*
+    Конкретный тип исполнителя вместо any_io_executor: any_io_executor не
+    вмещает strand и выделяет память при каждом prefer() внутри asio
+  */
+  using Executor = net::strand<net::io_context::executor_type>;
+  template <typename T = void> using Awaitable = net::awaitable<T, Executor>;
+  using Allocator = std::pmr::polymorphic_allocator<char>;
+  using RequestBody = http::basic_string_body<char, std::char_traits<char>, Allocator>;
+  using HttpRequest = http::request<RequestBody, http::basic_fields<Allocator>>;
+
+  CoroSessionBase(const CoroSessionBase &) = delete;
+  CoroSessionBase &operator=(const CoroSessionBase &) = delete;
+
+protected:
+  using RequestParser = http::request_parser<RequestBody, Allocator>;
+  using Stream = beast::basic_stream<tcp, Executor>;
+  using Clock = std::chrono::steady_clock;
+  using IdleTimer = net::basic_waitable_timer<Clock, net::wait_traits<Clock>, Executor>;
+
+  static constexpr auto READ_TIMEOUT = std::chrono::seconds(30);
+
+  static constexpr net::use_awaitable_t<Executor> use_awaitable{};
+
+  // Ответ со стёртым типом: обработчик может вернуть string_body или file_body
+  class PendingResponse {
+  public:
+    virtual ~PendingResponse() = default;
+    virtual Awaitable<std::size_t> Write(CoroSessionBase &session) = 0;
+    virtual bool NeedEof() const = 0;
+    virtual int Status() const = 0;
+    virtual std::string ContentType() const = 0;
+  };
+
+  template <typename Response> class TypedResponse final : public PendingResponse {
+  public:
+    explicit TypedResponse(Response &&response) : response_(std::move(response)) {}
+
+    Awaitable<std::size_t> Write(CoroSessionBase &session) override {
+      return session.AsyncWrite(response_);
+    }
+
+    bool NeedEof() const override { return response_.need_eof(); }
+
+    int Status() const override { return static_cast<int>(response_.result()); }
+
+    std::string ContentType() const override {
+      return std::string(response_[http::field::content_type]);
+    }
+
+  private:
+    Response response_;
+  };
+
+  // Общий неизменяемый ответ записывается без копирования
+  template <typename Response>
+  class TypedResponse<std::shared_ptr<const Response>> final : public PendingResponse {
+  public:
+    explicit TypedResponse(std::shared_ptr<const Response> response)
+        : response_(std::move(response)) {}
+
+    Awaitable<std::size_t> Write(CoroSessionBase &session) override {
+      return session.AsyncWrite(*response_);
+    }
+
+    bool NeedEof() const override { return response_->need_eof(); }
+
+    int Status() const override { return static_cast<int>(response_->result()); }
+
+    std::string ContentType() const override {
+      return std::string((*response_)[http::field::content_type]);
+    }
+
+  private:
+    std::shared_ptr<const Response> response_;
+  };
+
+  /*
+    Слот для единственного ответа, ожидающего записи: HTTP/1.1 без конвейера,
+    следующий запрос читается только после записи ответа. Ответ размещается
+    во встроенном буфере, если помещается в него.
+  */
+  class ResponseSlot {
+  public:
+    ResponseSlot() = default;
+    ResponseSlot(const ResponseSlot &) = delete;
+    ResponseSlot &operator=(const ResponseSlot &) = delete;
+
+    ~ResponseSlot() { Reset(); }
+
+    template <typename Response> void Emplace(Response &&response) {
+      using Typed = TypedResponse<std::decay_t<Response>>;
+      Reset();
+      if constexpr (sizeof(Typed) <= CAPACITY &&
+                    alignof(Typed) <= alignof(std::max_align_t)) {
+        value_ = new (storage_) Typed(std::move(response));
+        inline_ = true;
+      } else {
+        value_ = new Typed(std::move(response));
+        inline_ = false;
+      }
+    }
+
+    void Reset() noexcept {
+      if (value_ == nullptr) {
+        return;
+      }
+      if (inline_) {
+        value_->~PendingResponse();
+      } else {
+        delete value_;
+      }
+      value_ = nullptr;
+    }
+
+    PendingResponse *Get() const noexcept { return value_; }
+
+  private:
+    static constexpr std::size_t CAPACITY = 512;
+
+    alignas(std::max_align_t) unsigned char storage_[CAPACITY];
+    PendingResponse *value_ = nullptr;
+    bool inline_ = false;
+  };
+
+  explicit CoroSessionBase(tcp::socket &&socket)
+      : stream_(Rebind(std::move(socket))), remote_address_(RemoteAddress(stream_.socket())),
+        idle_timer_(stream_.get_executor()) {}
+
+  ~CoroSessionBase() = default;
+
+  // Сокет от acceptor привязан к strand через any_io_executor; переносим его
+  // на тот же strand с конкретным типом
+  static Stream::socket_type Rebind(tcp::socket &&socket) {
+    const Executor *strand = socket.get_executor().target<Executor>();
+    Stream::socket_type rebound(
+        strand ? *strand
+               : net::make_strand(static_cast<net::io_context &>(
+                     net::query(socket.get_executor(), net::execution::context))));
+    const tcp protocol = socket.local_endpoint().protocol();
+    rebound.assign(protocol, socket.release());
+    return rebound;
+  }
+
+  // Операция с обработчиком, размещённым в памяти соединения
+  template <typename Signature, typename Initiation>
+  Awaitable<std::size_t> WithHandlerMemory(Initiation &&initiation) {
+    return net::async_initiate<const net::use_awaitable_t<Executor> &, Signature>(
+        [this](auto handler, auto &&init) {
+          std::forward<decltype(init)>(init)(
+              MemoryBoundHandler(handler_memory_, std::move(handler)));
+        },
+        use_awaitable, std::forward<Initiation>(initiation));
+  }
+
+  // Ошибки чтения и записи приходят исключением sys::system_error:
+  // это конец соединения, а не отдельного запроса
+  Awaitable<std::size_t> AsyncRead(RequestParser &parser) {
+    read_deadline_ = Clock::now() + READ_TIMEOUT;
+    return WithHandlerMemory<void(beast::error_code, std::size_t)>(
+        [this, &parser](auto handler) {
+          http::async_read(stream_, buffer_, parser, std::move(handler));
+        });
+  }
+
+  template <typename Response> Awaitable<std::size_t> AsyncWrite(Response &response) {
+    return WithHandlerMemory<void(beast::error_code, std::size_t)>(
+        [this, &response](auto handler) {
+          http::async_write(stream_, response, std::move(handler));
+        });
+  }
+
+  /*
+    Ожидание ответа обработчика. Ответ может прийти с любого потока:
+    Complete кладёт его в слот и возобновляет сессию через её strand.
+    Пока сессия ждёт, она не трогает слоты, поэтому гонки нет.
+  */
+  Awaitable<> AwaitResponse() {
+    return net::async_initiate<const net::use_awaitable_t<Executor> &, void()>(
+        [this](auto handler) {
+          resume_.Emplace(MemoryBoundHandler(handler_memory_, std::move(handler)));
+        },
+        use_awaitable);
+  }
+
+  template <typename Response> void Complete(Response &&response) {
+    response_slot_.Emplace(std::forward<Response>(response));
+    // Даже синхронный ответ откладывается: к этому моменту сессия уже ждёт в AwaitResponse
+    net::post(stream_.get_executor(),
+              MemoryBoundHandler(handler_memory_, [this] { resume_.Invoke(); }));
+  }
+
+  /*
+    Сторож таймаута: срок переносит каждое чтение, а таймер просыпается не
+    чаще раза в READ_TIMEOUT. По истечении срока сокет закрывается, как при
+    таймауте beast, и ожидающая операция завершается ошибкой. Сессию
+    обработчик держит слабо, чтобы таймер не продлевал жизнь соединения.
+  */
+  void WatchIdle(std::weak_ptr<void> session) {
+    idle_timer_.expires_at(read_deadline_);
+    idle_timer_.async_wait([this, session = std::move(session)](beast::error_code ec) {
+      const auto alive = session.lock();
+      if (ec || !alive) {
+        return;
+      }
+      if (Clock::now() < read_deadline_) {
+        return WatchIdle(std::move(session));
+      }
+      timed_out_ = true;
+      beast::error_code ignored;
+      stream_.socket().close(ignored);
+    });
+  }
+
+  void Close() {
+    using namespace std::literals;
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+    if (ec) {
+      logger::LogError(ec.value(), ec.message(), "Close");
+      ReportError(ec, "close"sv);
+    }
+  }
+
+  Stream stream_;
+  net::ip::address remote_address_;
+  beast::flat_buffer buffer_;
+  std::shared_ptr<HandlerMemory> handler_memory_ = std::make_shared<HandlerMemory>();
+  ResponseSlot response_slot_;
+  CompletionSlot resume_;
+
+  // Память запросов: пул поверх встроенного буфера, блоки возвращаются в пул
+  // после каждого запроса и достаются следующему
+  alignas(std::max_align_t) std::byte request_buffer_[4096];
+  std::pmr::monotonic_buffer_resource request_arena_{request_buffer_, sizeof(request_buffer_)};
+  std::pmr::unsynchronized_pool_resource request_memory_{&request_arena_};
+
+  logger::Timer response_timer_;
+  IdleTimer idle_timer_;
+  Clock::time_point read_deadline_ = Clock::now() + READ_TIMEOUT;
+  bool timed_out_ = false;
+};
+
+/*
+  Сессия на корутинах (--coroutine-sessions). Обработчик получает запрос по
+  константной ссылке: запрос живёт в пуле соединения, и всё, что должно
+  пережить вызов, обработчик копирует (копия берёт память из обычной кучи).
+*/
+template <typename RequestHandler>
+class CoroSession : public CoroSessionBase,
+                    public std::enable_shared_from_this<CoroSession<RequestHandler>> {
+public:
+  template <typename Handler>
+  CoroSession(tcp::socket &&socket, Handler &&request_handler)
+      : CoroSessionBase(std::move(socket)),
+        request_handler_(std::forward<Handler>(request_handler)) {}
+
+  void Run() {
+    net::co_spawn(stream_.get_executor(), Serve(this->shared_from_this()),
+                  net::detached);
+  }
+
+private:
+  // Цикл keep-alive соединения: читает запрос, передаёт его обработчику и
+  // записывает ответ. Все ожидания - в одном кадре корутины
+  static Awaitable<> Serve(std::shared_ptr<CoroSession> self) {
+    using namespace std::literals;
+    self->WatchIdle(self);
+    try {
+      for (;;) {
+        {
+          const Allocator allocator(&self->request_memory_);
+          RequestParser parser(std::piecewise_construct, std::make_tuple(allocator),
+                               std::make_tuple(allocator));
+          co_await self->AsyncRead(parser);
+          self->HandleRequest(parser.get());
+        }
+        co_await self->AwaitResponse();
+
+        PendingResponse &response = *self->response_slot_.Get();
+        co_await response.Write(*self);
+        if (response.NeedEof()) {
+          // Семантика ответа требует закрыть соединение
+          self->response_slot_.Reset();
+          co_return self->Close();
+        }
+        logger::LogResponseSent(self->response_timer_.End(), response.Status(),
+                                response.ContentType());
+        self->response_slot_.Reset();
+      }
+    } catch (const sys::system_error &ex) {
+      if (ex.code() == http::error::end_of_stream) {
+        // Нормальная ситуация - клиент закрыл соединение
+        co_return self->Close();
+      }
+      const beast::error_code ec = self->timed_out_ ? beast::error::timeout : ex.code();
+      logger::LogError(ec.value(), ec.message(), "CoroSession");
+      ReportError(ec, "session"sv);
+    }
+  }
+
+  void HandleRequest(const HttpRequest &request) {
+    response_timer_.Start();
+    logger::LogRequestReceived(remote_address_.to_string(),
+                               std::string(request.target()),
+                               std::string(request.method_string()));
+
+    request_handler_(request, remote_address_,
+                     [self = this->shared_from_this()](auto &&response) {
+                       self->Complete(std::move(response));
+                     });
+  }
+
+  RequestHandler request_handler_;
+};
+
+} // namespace http_server
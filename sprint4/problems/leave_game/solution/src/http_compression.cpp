@@ -0,0 +1,180 @@
+#include "http_compression.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+
+namespace http_compression {
+
+namespace {
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](char l, char r) {
+        return std::tolower(static_cast<unsigned char>(l)) == std::tolower(static_cast<unsigned char>(r));
+    });
+}
+
+std::string_view Trim(std::string_view str) {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+/* gzip - обёртка gzip (windowBits + 16), deflate в HTTP - это формат zlib */
+int WindowBits(Encoding encoding) {
+    return encoding == Encoding::GZIP ? MAX_WBITS + 16 : MAX_WBITS;
+}
+
+class ThreadDeflater {
+public:
+    ThreadDeflater() = default;
+    ThreadDeflater(const ThreadDeflater&) = delete;
+    ThreadDeflater& operator=(const ThreadDeflater&) = delete;
+
+    ~ThreadDeflater() {
+        for (Stream& stream : streams_) {
+            if (stream.initialized) {
+                deflateEnd(&stream.z);
+            }
+        }
+    }
+
+    z_stream& Acquire(Encoding encoding, int level) {
+        Stream& stream = streams_[encoding == Encoding::GZIP ? 0 : 1];
+        if (!stream.initialized) {
+            stream.z = z_stream{};
+            if (deflateInit2(&stream.z, level, Z_DEFLATED, WindowBits(encoding), 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("deflateInit2 failed");
+            }
+            stream.initialized = true;
+            stream.level = level;
+        } else {
+            deflateReset(&stream.z);
+            if (stream.level != level) {
+                if (deflateParams(&stream.z, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+                    throw std::runtime_error("deflateParams failed");
+                }
+                stream.level = level;
+            }
+        }
+        return stream.z;
+    }
+
+private:
+    struct Stream {
+        z_stream z{};
+        bool initialized = false;
+        int level = DEFAULT_LEVEL;
+    };
+
+    Stream streams_[2];
+};
+
+/* Наибольший вес среди совпавших значений; nullopt - ни одно не упомянуто */
+std::optional<double> FindQuality(std::string_view header, std::initializer_list<std::string_view> values) {
+    std::optional<double> best;
+    size_t begin = 0;
+    while (begin < header.size()) {
+        size_t end = header.find(',', begin);
+        if (end == header.npos) {
+            end = header.size();
+        }
+        std::string_view item = header.substr(begin, end - begin);
+        begin = end + 1;
+
+        double quality = 1;
+        if (size_t semicolon = item.find(';'); semicolon != item.npos) {
+            if (size_t q = item.find("q=", semicolon); q != item.npos) {
+                quality = std::strtod(std::string(item.substr(q + 2)).c_str(), nullptr);
+            }
+            item = item.substr(0, semicolon);
+        }
+        item = Trim(item);
+
+        for (std::string_view value : values) {
+            if (EqualsIgnoreCase(item, value)) {
+                best = std::max(best.value_or(0), quality);
+            }
+        }
+    }
+    return best;
+}
+
+/* Явно названная кодировка важнее "*": "gzip;q=0, *" запрещает gzip */
+double CodingQuality(std::string_view header, std::initializer_list<std::string_view> names) {
+    if (std::optional<double> quality = FindQuality(header, names)) {
+        return *quality;
+    }
+    return FindQuality(header, {"*"}).value_or(0);
+}
+
+}  // namespace
+
+double HeaderQuality(std::string_view header, std::initializer_list<std::string_view> values) {
+    return FindQuality(header, values).value_or(0);
+}
+
+double MediaTypeQuality(std::string_view accept, std::initializer_list<std::string_view> media_types) {
+    if (std::optional<double> quality = FindQuality(accept, media_types)) {
+        return *quality;
+    }
+    const std::string_view main_type = *media_types.begin();
+    const std::string type_range = std::string(main_type.substr(0, main_type.find('/'))) + "/*";
+    if (std::optional<double> quality = FindQuality(accept, {type_range})) {
+        return *quality;
+    }
+    return FindQuality(accept, {"*/*"}).value_or(0);
+}
+
+Encoding ChooseEncoding(std::string_view accept_encoding) {
+    const double gzip = CodingQuality(accept_encoding, {"gzip", "x-gzip"});
+    const double deflate = CodingQuality(accept_encoding, {"deflate"});
+    if (gzip == 0 && deflate == 0) {
+        return Encoding::IDENTITY;
+    }
+    return gzip >= deflate ? Encoding::GZIP : Encoding::DEFLATE;
+}
+
+std::string_view EncodingName(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::GZIP:
+            return "gzip";
+        case Encoding::DEFLATE:
+            return "deflate";
+        case Encoding::IDENTITY:
+            break;
+    }
+    return "identity";
+}
+
+std::string Compress(std::string_view input, Encoding encoding, int level) {
+    if (encoding == Encoding::IDENTITY) {
+        return std::string(input);
+    }
+
+    thread_local ThreadDeflater deflater;
+    z_stream& stream = deflater.Acquire(encoding, level);
+
+    std::string out;
+    out.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+        throw std::runtime_error("deflate did not finish the stream");
+    }
+    out.resize(stream.total_out);
+    return out;
+}
+
+}  // namespace http_compression
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace http_compression {
+
+enum class Encoding {
+    IDENTITY,
+    GZIP,
+    DEFLATE
+};
+
+/* Уровень zlib по умолчанию (Z_DEFAULT_COMPRESSION), чтобы не тянуть zlib.h в заголовок */
+constexpr int DEFAULT_LEVEL = -1;
+
+struct Settings {
+    bool enabled = true;
+    /* Ответы короче порога отправляются как есть: выигрыш меньше затрат на сжатие */
+    size_t min_size = 1024;
+    int level = DEFAULT_LEVEL;
+};
+
+/*
+    Вес значений values в заголовке со списком "значение;q=вес" (Accept, Accept-Encoding):
+    наибольший q среди совпавших без учёта регистра, 0 - не принимается
+*/
+double HeaderQuality(std::string_view header, std::initializer_list<std::string_view> values);
+
+/*
+    Вес медиатипа media_types (первый - основное имя, остальные - синонимы) в заголовке Accept
+    по RFC 7231, 5.3.2: берётся q самого конкретного совпавшего диапазона - точного типа,
+    затем всех подтипов того же типа, затем всех типов; 0 - не принимается
+*/
+double MediaTypeQuality(std::string_view accept, std::initializer_list<std::string_view> media_types);
+
+/* Выбор по Accept-Encoding; при равных весах gzip предпочтительнее deflate */
+Encoding ChooseEncoding(std::string_view accept_encoding);
+
+/* Значение для заголовка Content-Encoding */
+std::string_view EncodingName(Encoding encoding);
+
+/*
+    Сжимает input. Потоки zlib создаются один раз на поток выполнения
+    и переиспользуются через deflateReset, поэтому повторное сжатие не выделяет
+    внутренние буферы zlib заново. Выбрасывает std::runtime_error при ошибке zlib.
+*/
+std::string Compress(std::string_view input, Encoding encoding, int level = DEFAULT_LEVEL);
+
+/*
+    Кэш неизменяемых ответов (описания карт): тело и его сжатые варианты
+    вычисляются один раз на ключ. Не потокобезопасен - используется внутри strand.
+*/
+class PayloadCache {
+public:
+    /* Вариант тела в нужной кодировке; сжатый вариант создаётся при первом запросе. nullptr - ключа нет */
+    const std::string* Find(const std::string& key, Encoding encoding, int level = DEFAULT_LEVEL) {
+        auto it = entries_.find(key);
+        if (it == entries_.end()) {
+            return nullptr;
+        }
+        std::string* variants = it->second.variants;
+        std::string& variant = variants[static_cast<size_t>(encoding)];
+        if (encoding != Encoding::IDENTITY && variant.empty()) {
+            variant = Compress(variants[static_cast<size_t>(Encoding::IDENTITY)], encoding, level);
+        }
+        return &variant;
+    }
+
+    /* Новое тело заменяет запись целиком, сжатые варианты старого тела отбрасываются */
+    void Put(const std::string& key, std::string body) {
+        Entry& entry = entries_[key];
+        entry = Entry{};
+        entry.variants[static_cast<size_t>(Encoding::IDENTITY)] = std::move(body);
+    }
+
+    void Clear() noexcept {
+        entries_.clear();
+    }
+
+private:
+    struct Entry {
+        std::string variants[3];
+    };
+
+    std::unordered_map<std::string, Entry> entries_;
+};
+
+}  // namespace http_compression
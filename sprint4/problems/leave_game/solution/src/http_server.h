@@ -4,11 +4,13 @@
 #define BOOST_BEAST_USE_STD_STRING_VIEW
 
 #include "boost_logger.h"
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/ip/tcp.hpp>
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <iostream>
+#include <memory>
 
 namespace http_server {
 
@@ -23,6 +25,13 @@ inline void ReportError(beast::error_code ec, std::string_view what) {
   std::cerr << what << ": "sv << ec.message() << std::endl;
 }
 
+// Адрес клиента; пустой адрес, если соединение уже разорвано
+template <typename Socket>
+net::ip::address RemoteAddress(const Socket &socket) {
+  beast::error_code ec;
+  return socket.remote_endpoint(ec).address();
+}
+
 class SessionBase {
 public:
   using HttpRequest = http::request<http::string_body>;
@@ -35,27 +44,40 @@ public:
   void Run();
 
 protected:
-  explicit SessionBase(tcp::socket &&socket) : stream_(std::move(socket)) {}
+  explicit SessionBase(tcp::socket &&socket)
+      : stream_(std::move(socket)), remote_address_(RemoteAddress(stream_.socket())) {}
   // tcp_stream содержит внутри себя сокет и добавляет поддержку таймаутов
   beast::tcp_stream stream_;
+  // Адрес запоминается один раз, чтобы не запрашивать его у ОС на каждый запрос
+  net::ip::address remote_address_;
   beast::flat_buffer buffer_;
   HttpRequest request_;
 
   template <typename Body, typename Fields>
   void Write(http::response<Body, Fields> &&response) {
     // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
-    auto safe_response =
-        std::make_shared<http::response<Body, Fields>>(std::move(response));
+    WriteShared(std::make_shared<http::response<Body, Fields>>(std::move(response)));
+  }
 
-    auto self = GetSharedThis();
-    http::async_write(
-        stream_, *safe_response,
-        [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
-          self->OnWrite(safe_response, ec, bytes_written);
-        });
+  template <typename Body, typename Fields>
+  void Write(std::shared_ptr<const http::response<Body, Fields>> response) {
+    WriteShared(std::move(response));
   }
 
 private:
+  template <typename Message> void WriteShared(std::shared_ptr<Message> safe_response) {
+    // Ответ может прийти из strand игры на другом потоке: запись выполняем в
+    // executor соединения, чтобы оно целиком обслуживалось своим потоком
+    auto self = GetSharedThis();
+    net::dispatch(stream_.get_executor(), [safe_response, self] {
+      http::async_write(
+          self->stream_, *safe_response,
+          [safe_response, self](beast::error_code ec, std::size_t bytes_written) {
+            self->OnWrite(safe_response, ec, bytes_written);
+          });
+    });
+  }
+
   void Read() {
     using namespace std::literals;
     // Очищаем запрос от прежнего значения (метод Read может быть вызван
@@ -81,7 +103,9 @@ private:
       return ReportError(ec, "read"sv);
     }
 
-    std::string IP(stream_.socket().remote_endpoint().address().to_string());
+    response_timer_.Start();
+
+    std::string IP(remote_address_.to_string());
     std::string URL(request_.target());
     std::string method(request_.method_string());
     logger::LogRequestReceived(IP, URL, method);
@@ -100,8 +124,8 @@ private:
     }
   }
 
-  template <typename Body, typename Fields>
-  void OnWrite(std::shared_ptr<http::response<Body, Fields>> safe_response,
+  template <typename Message>
+  void OnWrite(std::shared_ptr<Message> safe_response,
                beast::error_code ec,
                [[maybe_unused]] std::size_t bytes_written) {
     using namespace std::literals;
@@ -151,19 +175,21 @@ private:
     // чтобы продлить время жизни сессии до вызова лямбды.
     // Используется generic-лямбда функция, способная принять response
     // произвольного типа
-    request_handler_(std::move(request),
+    request_handler_(std::move(request), remote_address_,
                      [self = this->shared_from_this()](auto &&response) {
                        self->Write(std::move(response));
                      });
   }
 };
 
-template <typename RequestHandler>
-class Listener : public std::enable_shared_from_this<Listener<RequestHandler>> {
+// SessionT<RequestHandler> создаётся из сокета и обработчика и запускается методом Run
+template <typename RequestHandler,
+          template <typename> class SessionT = Session>
+class Listener : public std::enable_shared_from_this<Listener<RequestHandler, SessionT>> {
 public:
   template <typename Handler>
   Listener(net::io_context &ioc, const tcp::endpoint &endpoint,
-           Handler &&request_handler)
+           Handler &&request_handler, bool reuse_port = false)
       : ioc_(ioc)
         // Обработчики асинхронных операций acceptor_ будут вызываться в своём
         // strand
@@ -180,6 +206,11 @@ public:
     // состоянии. Флаг reuse_address разрешает открыть сокет, когда он
     // "наполовину закрыт"
     acceptor_.set_option(net::socket_base::reuse_address(true));
+    // Несколько acceptor на одном порту (по одному на io_context): ядро само
+    // распределяет между ними входящие соединения
+    if (reuse_port) {
+      acceptor_.set_option(ReusePort(true));
+    }
     // Привязываем acceptor к адресу и порту endpoint
     acceptor_.bind(endpoint);
     // Переводим acceptor в состояние, в котором он способен принимать новые
@@ -191,6 +222,8 @@ public:
   void Run() { DoAccept(); }
 
 private:
+  using ReusePort = net::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
   void DoAccept() {
     acceptor_.async_accept(
         // Передаём последовательный исполнитель, в котором будут вызываться
@@ -223,8 +256,8 @@ private:
   }
 
   void AsyncRunSession(tcp::socket &&socket) {
-    std::make_shared<Session<RequestHandler>>(std::move(socket),
-                                              request_handler_)
+    std::make_shared<SessionT<RequestHandler>>(std::move(socket),
+                                               request_handler_)
         ->Run();
   }
 
@@ -245,4 +278,18 @@ void ServeHttp(net::io_context &ioc, const tcp::endpoint &endpoint,
       ->Run();
 }
 
+// Слушает endpoint на каждом контексте из contexts; при нескольких контекстах
+// каждый получает свой acceptor с SO_REUSEPORT
+template <template <typename> class SessionT = Session, typename Contexts,
+          typename RequestHandler>
+void ServeHttpOnEach(const Contexts &contexts, const tcp::endpoint &endpoint,
+                     const RequestHandler &handler) {
+  using MyListener = Listener<std::decay_t<RequestHandler>, SessionT>;
+
+  const bool reuse_port = contexts.size() > 1;
+  for (const auto &ioc : contexts) {
+    std::make_shared<MyListener>(*ioc, endpoint, handler, reuse_port)->Run();
+  }
+}
+
 } // namespace http_server
\ No newline at end of file
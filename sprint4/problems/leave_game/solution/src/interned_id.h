@@ -0,0 +1,124 @@
+#pragma once
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace util {
+
+/**
+ * Интернированный строковый идентификатор.
+ * Каждое имя один раз заносится в общую для Tag таблицу и получает плотный
+ * номер 0, 1, 2... Сравнение, хеширование и копирование работают с номером,
+ * а строка нужна только для ввода-вывода (API, снимок, метрики).
+ *
+ *  struct MapTag{};
+ *  using MapId = util::InternedId<MapTag>;
+ *
+ *  MapId town{"town"s};                         // заносит имя в таблицу
+ *  std::optional<MapId> id = MapId::Find(name); // только ищет
+ *
+ * Конструктор предназначен для имён из конфигурации. Имена из запросов
+ * нужно искать через Find, иначе таблица будет расти от чужого ввода.
+ * Таблица никогда не уменьшается, поэтому номер и ссылка на имя
+ * действительны до конца программы.
+ */
+template <typename Tag>
+class InternedId {
+public:
+    using IndexType = uint32_t;
+
+    explicit InternedId(std::string_view name)
+        : InternedId(GetTable().Intern(name)) {
+    }
+
+    /* Идентификатор уже занесённого имени; для неизвестного имени - nullopt */
+    static std::optional<InternedId> Find(std::string_view name) {
+        if (const auto* entry = GetTable().Find(name)) {
+            return InternedId(*entry);
+        }
+        return std::nullopt;
+    }
+
+    const std::string& operator*() const noexcept {
+        return *name_;
+    }
+
+    IndexType GetIndex() const noexcept {
+        return index_;
+    }
+
+    bool operator==(const InternedId& other) const noexcept {
+        return index_ == other.index_;
+    }
+
+    // Порядок - порядок занесения в таблицу, а не алфавитный
+    std::strong_ordering operator<=>(const InternedId& other) const noexcept {
+        return index_ <=> other.index_;
+    }
+
+private:
+    using Entry = std::pair<const std::string, IndexType>;
+
+    class Table {
+    public:
+        const Entry& Intern(std::string_view name) {
+            if (const Entry* entry = Find(name)) {
+                return *entry;
+            }
+            std::unique_lock lock{mutex_};
+            return *names_.try_emplace(std::string(name), static_cast<IndexType>(names_.size())).first;
+        }
+
+        // Поиск без копирования строки и под общей блокировкой: читатели не мешают друг другу
+        const Entry* Find(std::string_view name) const {
+            std::shared_lock lock{mutex_};
+            auto it = names_.find(name);
+            return it != names_.end() ? &*it : nullptr;
+        }
+
+    private:
+        // Прозрачный хешер: find принимает string_view наравне со std::string
+        struct NameHasher {
+            using is_transparent = void;
+
+            size_t operator()(std::string_view name) const noexcept {
+                return std::hash<std::string_view>{}(name);
+            }
+        };
+
+        // Узлы unordered_map не перемещаются при рехешировании, поэтому указатель на имя стабилен
+        mutable std::shared_mutex mutex_;
+        std::unordered_map<std::string, IndexType, NameHasher, std::equal_to<>> names_;
+    };
+
+    // Карты строятся из конфигурации в нескольких потоках, поэтому таблица под блокировкой
+    static Table& GetTable() {
+        static Table table;
+        return table;
+    }
+
+    explicit InternedId(const Entry& entry) noexcept
+        : name_(&entry.first)
+        , index_(entry.second) {
+    }
+
+    const std::string* name_;
+    IndexType index_;
+};
+
+// Хешер по номеру: для unordered-контейнеров с InternedId-ключами
+template <typename Id>
+struct InternedIdHasher {
+    size_t operator()(const Id& id) const noexcept {
+        return id.GetIndex();
+    }
+};
+
+}  // namespace util
@@ -0,0 +1,98 @@
+#include "io_context_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "boost_logger.h"
+
+namespace http_server {
+
+namespace {
+
+thread_local net::io_context *current_context = nullptr;
+
+void PinCurrentThread(unsigned index) {
+#ifdef __linux__
+  const unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % cpus, &set);
+  if (int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); err != 0) {
+    logger::LogError(err, std::strerror(err), "PinCurrentThread");
+  }
+#else
+  (void)index;
+#endif
+}
+
+} // namespace
+
+IoMode ParseIoMode(std::string_view mode) {
+  using namespace std::literals;
+  if (mode == "shared"sv) {
+    return IoMode::SHARED;
+  }
+  if (mode == "per-core"sv) {
+    return IoMode::PER_CORE;
+  }
+  throw std::invalid_argument("Unknown io mode: "s + std::string(mode));
+}
+
+IoContextPool::IoContextPool(IoMode mode, unsigned threads)
+    : mode_(mode), threads_(std::max(1u, threads)) {
+  // Подсказка 1 сообщает asio, что контекст обслуживает один поток, и избавляет
+  // от лишних пробуждений других потоков. Блокировки очереди при этом остаются:
+  // отключает их только BOOST_ASIO_CONCURRENCY_HINT_UNSAFE, а он здесь недопустим -
+  // обработчики на чужие контексты кладут другие потоки (strand игры, освобождение
+  // старых карт). Контексту 0 кроме его acceptor достаются strand игры, тикеры
+  // и signal_set, поэтому его поток нагружен сильнее остальных.
+  const unsigned contexts = mode_ == IoMode::SHARED ? 1 : threads_;
+  const int hint = mode_ == IoMode::SHARED ? static_cast<int>(threads_) : 1;
+  contexts_.reserve(contexts);
+  work_guards_.reserve(contexts);
+  for (unsigned i = 0; i < contexts; ++i) {
+    contexts_.push_back(std::make_unique<net::io_context>(hint));
+    // Контекст не должен завершаться, пока на нём временно нет операций
+    work_guards_.push_back(net::make_work_guard(*contexts_.back()));
+  }
+}
+
+net::io_context *IoContextPool::Current() noexcept {
+  return current_context;
+}
+
+void IoContextPool::Run(bool pin_threads) {
+  std::vector<std::jthread> workers;
+  workers.reserve(threads_ - 1);
+  for (unsigned i = 1; i < threads_; ++i) {
+    workers.emplace_back([this, i, pin_threads] { RunWorker(i, pin_threads); });
+  }
+  RunWorker(0, pin_threads);
+}
+
+void IoContextPool::Stop() {
+  work_guards_.clear();
+  for (auto &context : contexts_) {
+    context->stop();
+  }
+}
+
+void IoContextPool::RunWorker(unsigned index, bool pin_threads) {
+  if (pin_threads) {
+    PinCurrentThread(index);
+  }
+  net::io_context &context = *contexts_[index % contexts_.size()];
+  current_context = &context;
+  context.run();
+  current_context = nullptr;
+}
+
+} // namespace http_server
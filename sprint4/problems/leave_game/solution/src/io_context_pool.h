@@ -0,0 +1,67 @@
+#pragma once
+#include "sdk.h"
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace http_server {
+
+namespace net = boost::asio;
+
+enum class IoMode {
+  // Один io_context на все потоки: общая очередь обработчиков
+  SHARED,
+  // Свой io_context на каждый поток; соединение живёт на одном ядре
+  PER_CORE
+};
+
+// "shared" или "per-core"; иначе std::invalid_argument
+IoMode ParseIoMode(std::string_view mode);
+
+/*
+  Набор io_context для рабочих потоков. В режиме SHARED один контекст
+  обслуживают все потоки, в режиме PER_CORE у каждого потока свой контекст,
+  и каждому нужен свой acceptor (SO_REUSEPORT), чтобы ядро ОС распределяло
+  соединения. Контекст 0 - основной: на нём живут strand игры, таймеры и сигналы.
+*/
+class IoContextPool {
+public:
+  IoContextPool(IoMode mode, unsigned threads);
+
+  IoContextPool(const IoContextPool &) = delete;
+  IoContextPool &operator=(const IoContextPool &) = delete;
+
+  IoMode GetMode() const noexcept { return mode_; }
+  unsigned GetThreads() const noexcept { return threads_; }
+
+  net::io_context &GetMain() noexcept { return *contexts_.front(); }
+
+  // Контексты, на каждом из которых нужен свой acceptor
+  const std::vector<std::unique_ptr<net::io_context>> &GetContexts() const noexcept {
+    return contexts_;
+  }
+
+  // Контекст, который обслуживает текущий поток; nullptr вне рабочих потоков пула
+  static net::io_context *Current() noexcept;
+
+  // Запускает рабочие потоки (включая текущий) и ждёт их завершения после Stop.
+  // pin_threads закрепляет поток i за процессором i по модулю числа процессоров
+  void Run(bool pin_threads);
+
+  void Stop();
+
+private:
+  using WorkGuard = net::executor_work_guard<net::io_context::executor_type>;
+
+  void RunWorker(unsigned index, bool pin_threads);
+
+  IoMode mode_;
+  unsigned threads_;
+  std::vector<std::unique_ptr<net::io_context>> contexts_;
+  std::vector<WorkGuard> work_guards_;
+};
+
+} // namespace http_server
@@ -2,8 +2,14 @@
 #include <boost/json.hpp>
 #include <boost/json/array.hpp>
 #include <boost/json/object.hpp>
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <fstream>
-#include <iostream>
+#include <limits>
+#include <optional>
+#include <thread>
+#include <vector>
 
 namespace json_loader {
 
@@ -14,87 +20,378 @@ const std::string Size_H = "h";
 
 namespace json = boost::json;
 
-void LoadingRoadIntoMap(model::Map &map, const json::array &roads_array) {
-  for (const auto &road_item : roads_array) {
-    const auto &road_obj = road_item.as_object();
-    model::Point start{static_cast<int>(road_obj.at("x0").as_int64()),
-                       static_cast<int>(road_obj.at("y0").as_int64())};
-
-    if (road_obj.contains("x1")) {
-      model::Coord end = static_cast<int>(road_obj.at("x1").as_int64());
-      model::Road road(model::Road::HORIZONTAL, start, end);
-      map.AddRoad(road);
-    } else if (road_obj.contains("y1")) {
-      model::Coord end = static_cast<int>(road_obj.at("y1").as_int64());
-      model::Road road(model::Road::VERTICAL, start, end);
-      map.AddRoad(road);
+ConfigError::ConfigError(std::string path, const std::string &message)
+    : std::runtime_error(path + ": " + message), path_(std::move(path)) {}
+
+namespace {
+
+/*
+  Путь к значению внутри конфигурации. Узлы живут на стеке разбора и строка
+  собирается только при ошибке, поэтому корректный файл разбирается без
+  лишних выделений памяти
+*/
+struct JsonPath {
+  const JsonPath *parent = nullptr;
+  std::string_view key;
+  size_t index = 0;
+
+  JsonPath Key(std::string_view child) const { return {this, child, 0}; }
+  JsonPath Index(size_t child) const { return {this, {}, child}; }
+
+  std::string ToString() const {
+    if (parent == nullptr) {
+      return "$";
+    }
+    std::string path = parent->ToString();
+    if (key.empty()) {
+      path += '[' + std::to_string(index) + ']';
+    } else {
+      path += '.';
+      path += key;
+    }
+    return path;
+  }
+
+  [[noreturn]] void Fail(const std::string &message) const {
+    throw ConfigError(ToString(), message);
+  }
+};
+
+const json::object &AsObject(const json::value &value, const JsonPath &path) {
+  if (const json::object *object = value.if_object()) {
+    return *object;
+  }
+  path.Fail("expected an object");
+}
+
+const json::array &AsArray(const json::value &value, const JsonPath &path) {
+  if (const json::array *array = value.if_array()) {
+    return *array;
+  }
+  path.Fail("expected an array");
+}
+
+std::string AsString(const json::value &value, const JsonPath &path) {
+  if (const json::string *str = value.if_string()) {
+    return std::string(*str);
+  }
+  path.Fail("expected a string");
+}
+
+template <typename Number>
+Number AsNumber(const json::value &value, const JsonPath &path) {
+  if (!value.is_number()) {
+    path.Fail("expected a number");
+  }
+  boost::system::error_code ec;
+  const Number number = value.to_number<Number>(ec);
+  if (ec) {
+    path.Fail("number out of range: " + ec.message());
+  }
+  return number;
+}
+
+int AsInt(const json::value &value, const JsonPath &path) {
+  if (value.is_double()) {
+    path.Fail("expected an integer");
+  }
+  return AsNumber<int>(value, path);
+}
+
+// Рюкзак собаки имеет фиксированную ёмкость, поэтому bagCapacity ограничена сверху
+int AsBagCapacity(const json::value &value, const JsonPath &path) {
+  const int capacity = AsInt(value, path);
+  if (capacity < 0 || static_cast<size_t>(capacity) > model::Dog::MAX_BAG_CAPACITY) {
+    path.Fail("bag capacity must be between 0 and " +
+              std::to_string(model::Dog::MAX_BAG_CAPACITY));
+  }
+  return capacity;
+}
+
+const json::value &Required(const json::object &object, std::string_view key,
+                            const JsonPath &path) {
+  if (const json::value *value = object.if_contains(key)) {
+    return *value;
+  }
+  path.Key(key).Fail("required field is missing");
+}
+
+/* Общие настройки из корня конфигурации; читаются один раз до разбора карт */
+struct GlobalSettings {
+  std::optional<double> default_dog_speed;
+  std::optional<int> default_bag_capacity;
+  std::optional<unsigned> dog_retirement_time;
+  std::optional<std::pair<double, double>> loot_generator;
+  std::optional<size_t> max_players_per_session;
+  std::optional<double> interest_radius;
+  std::optional<model::SessionPlacement> session_placement;
+};
+
+model::SessionPlacement ParseSessionPlacement(std::string_view placement,
+                                              const JsonPath &path) {
+  if (placement == "fill") {
+    return model::SessionPlacement::FILL;
+  }
+  if (placement == "leastLoaded") {
+    return model::SessionPlacement::LEAST_LOADED;
+  }
+  path.Fail("unknown sessionPlacement: " + std::string(placement));
+}
+
+GlobalSettings LoadGlobalSettings(const json::object &root, const JsonPath &path) {
+  GlobalSettings settings;
+  if (const json::value *value = root.if_contains("defaultDogSpeed")) {
+    settings.default_dog_speed = AsNumber<double>(*value, path.Key("defaultDogSpeed"));
+  }
+  if (const json::value *value = root.if_contains("dogRetirementTime")) {
+    const JsonPath retirement_path = path.Key("dogRetirementTime");
+    const double seconds = AsNumber<double>(*value, retirement_path);
+    // Время хранится в Game как int секунд
+    if (!(seconds >= 0 && seconds <= std::numeric_limits<int>::max())) {
+      retirement_path.Fail("dog retirement time must be between 0 and " +
+                           std::to_string(std::numeric_limits<int>::max()) + " seconds");
+    }
+    settings.dog_retirement_time = static_cast<unsigned>(seconds);
+  }
+  if (const json::value *value = root.if_contains("defaultBagCapacity")) {
+    settings.default_bag_capacity = AsBagCapacity(*value, path.Key("defaultBagCapacity"));
+  }
+  if (const json::value *value = root.if_contains("lootGeneratorConfig")) {
+    const JsonPath config_path = path.Key("lootGeneratorConfig");
+    const json::object &config = AsObject(*value, config_path);
+    const double period =
+        AsNumber<double>(Required(config, "period", config_path), config_path.Key("period")) * 1000;
+    const double probability = AsNumber<double>(Required(config, "probability", config_path),
+                                                config_path.Key("probability"));
+    settings.loot_generator.emplace(period, probability);
+  }
+  if (const json::value *value = root.if_contains("maxPlayersPerSession")) {
+    settings.max_players_per_session =
+        AsNumber<size_t>(*value, path.Key("maxPlayersPerSession"));
+  }
+  if (const json::value *value = root.if_contains("interestRadius")) {
+    settings.interest_radius = AsNumber<double>(*value, path.Key("interestRadius"));
+  }
+  if (const json::value *value = root.if_contains("sessionPlacement")) {
+    const JsonPath placement_path = path.Key("sessionPlacement");
+    settings.session_placement =
+        ParseSessionPlacement(AsString(*value, placement_path), placement_path);
+  }
+  return settings;
+}
+
+void ApplyGlobalSettings(model::Game &game, const GlobalSettings &settings) {
+  if (settings.default_dog_speed) {
+    game.SetDefaultDogSpeed(*settings.default_dog_speed);
+  }
+  if (settings.dog_retirement_time) {
+    game.SetDogRetirementTime(*settings.dog_retirement_time);
+  }
+  if (settings.default_bag_capacity) {
+    game.SetDefaultBagCapacity(*settings.default_bag_capacity);
+  }
+  if (settings.loot_generator) {
+    game.SetLootGenerator(settings.loot_generator->first, settings.loot_generator->second);
+  }
+  if (settings.max_players_per_session) {
+    game.SetMaxPlayersPerSession(*settings.max_players_per_session);
+  }
+  if (settings.interest_radius) {
+    game.SetInterestRadius(*settings.interest_radius);
+  }
+  if (settings.session_placement) {
+    game.SetSessionPlacement(*settings.session_placement);
+  }
+}
+
+void LoadRoads(model::Map &map, const json::array &roads_array, const JsonPath &path) {
+  for (size_t i = 0; i < roads_array.size(); ++i) {
+    const JsonPath road_path = path.Index(i);
+    const json::object &road_obj = AsObject(roads_array[i], road_path);
+    model::Point start{AsInt(Required(road_obj, "x0", road_path), road_path.Key("x0")),
+                       AsInt(Required(road_obj, "y0", road_path), road_path.Key("y0"))};
+
+    if (const json::value *x1 = road_obj.if_contains("x1")) {
+      map.AddRoad(model::Road(model::Road::HORIZONTAL, start, AsInt(*x1, road_path.Key("x1"))));
+    } else if (const json::value *y1 = road_obj.if_contains("y1")) {
+      map.AddRoad(model::Road(model::Road::VERTICAL, start, AsInt(*y1, road_path.Key("y1"))));
+    } else {
+      road_path.Fail("road must have either x1 or y1");
     }
   }
 }
-void LoadingBuildingsIntoMap(model::Map &map,
-                             const json::array &buildings_array) {
-  for (const auto &building_item : buildings_array) {
-    const auto &building_obj = building_item.as_object();
+
+void LoadBuildings(model::Map &map, const json::array &buildings_array,
+                   const JsonPath &path) {
+  for (size_t i = 0; i < buildings_array.size(); ++i) {
+    const JsonPath building_path = path.Index(i);
+    const json::object &building_obj = AsObject(buildings_array[i], building_path);
     // Point
-    model::Point pos{static_cast<int>(building_obj.at(Point_X).as_int64()),
-                     static_cast<int>(building_obj.at(Point_Y).as_int64())};
+    model::Point pos{
+        AsInt(Required(building_obj, Point_X, building_path), building_path.Key(Point_X)),
+        AsInt(Required(building_obj, Point_Y, building_path), building_path.Key(Point_Y))};
     // Size
-    model::Size size{static_cast<int>(building_obj.at(Size_W).as_int64()),
-                     static_cast<int>(building_obj.at(Size_H).as_int64())};
+    model::Size size{
+        AsInt(Required(building_obj, Size_W, building_path), building_path.Key(Size_W)),
+        AsInt(Required(building_obj, Size_H, building_path), building_path.Key(Size_H))};
 
-    model::Building build(model::Rectangle{pos, size});
-    map.AddBuilding(build);
+    map.AddBuilding(model::Building(model::Rectangle{pos, size}));
   }
 }
 
-void LoadingOfficesIntoMap(model::Map &map, const json::array &offices_array) {
-  for (const auto &offices_item : offices_array) {
-    const auto &office_obj = offices_item.as_object();
+void LoadOffices(model::Map &map, const json::array &offices_array, const JsonPath &path) {
+  for (size_t i = 0; i < offices_array.size(); ++i) {
+    const JsonPath office_path = path.Index(i);
+    const json::object &office_obj = AsObject(offices_array[i], office_path);
     // id
-    model::Office::Id id{office_obj.at("id").as_string().c_str()};
+    model::Office::Id id{
+        AsString(Required(office_obj, "id", office_path), office_path.Key("id"))};
     // Point
-    model::Point pos{static_cast<int>(office_obj.at(Point_X).as_int64()),
-                     static_cast<int>(office_obj.at(Point_Y).as_int64())};
+    model::Point pos{
+        AsInt(Required(office_obj, Point_X, office_path), office_path.Key(Point_X)),
+        AsInt(Required(office_obj, Point_Y, office_path), office_path.Key(Point_Y))};
     // Offset
-    model::Offset offset{static_cast<int>(office_obj.at("offsetX").as_int64()),
-                         static_cast<int>(office_obj.at("offsetY").as_int64())};
+    model::Offset offset{
+        AsInt(Required(office_obj, "offsetX", office_path), office_path.Key("offsetX")),
+        AsInt(Required(office_obj, "offsetY", office_path), office_path.Key("offsetY"))};
 
-    model::Office office(id, pos, offset);
-    map.AddOffice(office);
+    try {
+      map.AddOffice(model::Office(std::move(id), pos, offset));
+    } catch (const std::invalid_argument &ex) {
+      office_path.Key("id").Fail(ex.what());
+    }
   }
 }
 
-void LOadLootTypeIntoMap(model::Map &map, const json::array &loot_array) {
-  for (const json::value &loot_value : loot_array) {
-    json::object loot_type = loot_value.as_object();
+void LoadLootTypes(model::Map &map, const json::array &loot_array, const JsonPath &path) {
+  for (size_t i = 0; i < loot_array.size(); ++i) {
+    const JsonPath loot_path = path.Index(i);
+    const json::object &loot_type = AsObject(loot_array[i], loot_path);
 
     model::LootType loot_t;
-    if (loot_type.contains("name")) {
-      loot_t.name = loot_type.at("name").as_string();
+    if (const json::value *value = loot_type.if_contains("name")) {
+      loot_t.name = AsString(*value, loot_path.Key("name"));
     }
-    if (loot_type.contains("file")) {
-      loot_t.file = loot_type.at("file").as_string();
+    if (const json::value *value = loot_type.if_contains("file")) {
+      loot_t.file = AsString(*value, loot_path.Key("file"));
     }
-    if (loot_type.contains("type")) {
-      loot_t.type = loot_type.at("type").as_string();
+    if (const json::value *value = loot_type.if_contains("type")) {
+      loot_t.type = AsString(*value, loot_path.Key("type"));
     }
-    if (loot_type.contains("rotation")) {
-      loot_t.rotation = loot_type.at("rotation").as_int64();
+    if (const json::value *value = loot_type.if_contains("rotation")) {
+      loot_t.rotation = AsInt(*value, loot_path.Key("rotation"));
     }
-    if (loot_type.contains("color")) {
-      loot_t.color = loot_type.at("color").as_string();
+    if (const json::value *value = loot_type.if_contains("color")) {
+      loot_t.color = AsString(*value, loot_path.Key("color"));
     }
-    if (loot_type.contains("scale")) {
-      loot_t.scale = loot_type.at("scale").as_double();
+    if (const json::value *value = loot_type.if_contains("scale")) {
+      loot_t.scale = AsNumber<double>(*value, loot_path.Key("scale"));
     }
-    if (loot_type.contains("value")) {
-      loot_t.value = loot_type.at("value").as_int64();
+    if (const json::value *value = loot_type.if_contains("value")) {
+      loot_t.value = AsInt(*value, loot_path.Key("value"));
     }
 
-    map.AddLootType(loot_t);
+    map.AddLootType(std::move(loot_t));
+  }
+}
+
+/* Карта строится целиком по своему объекту и общим настройкам, без обращения к Game */
+model::Map LoadMap(const json::value &item, const model::Game &defaults,
+                   const JsonPath &path) {
+  const json::object &map_obj = AsObject(item, path);
+  model::Map::Id id{AsString(Required(map_obj, "id", path), path.Key("id"))};
+  std::string name = AsString(Required(map_obj, "name", path), path.Key("name"));
+  model::Map map(std::move(id), std::move(name));
+
+  LoadRoads(map, AsArray(Required(map_obj, "roads", path), path.Key("roads")),
+            path.Key("roads"));
+  LoadBuildings(map, AsArray(Required(map_obj, "buildings", path), path.Key("buildings")),
+                path.Key("buildings"));
+  LoadOffices(map, AsArray(Required(map_obj, "offices", path), path.Key("offices")),
+              path.Key("offices"));
+  LoadLootTypes(map, AsArray(Required(map_obj, "lootTypes", path), path.Key("lootTypes")),
+                path.Key("lootTypes"));
+
+  // Настройки карты перекрывают общие
+  if (const json::value *value = map_obj.if_contains("dogSpeed")) {
+    map.AddDogSpeed(AsNumber<double>(*value, path.Key("dogSpeed")));
+  } else {
+    map.AddDogSpeed(defaults.GetDefaultDogSpeed());
+  }
+  if (const json::value *value = map_obj.if_contains("bagCapacity")) {
+    map.AddBagCapacity(AsBagCapacity(*value, path.Key("bagCapacity")));
+  } else {
+    map.AddBagCapacity(defaults.GetDefaultBagCapacity());
   }
+  if (const json::value *value = map_obj.if_contains("maxPlayersPerSession")) {
+    map.SetMaxPlayersPerSession(AsNumber<size_t>(*value, path.Key("maxPlayersPerSession")));
+  } else {
+    map.SetMaxPlayersPerSession(defaults.GetMaxPlayersPerSession());
+  }
+  if (const json::value *value = map_obj.if_contains("interestRadius")) {
+    map.SetInterestRadius(AsNumber<double>(*value, path.Key("interestRadius")));
+  } else {
+    map.SetInterestRadius(defaults.GetInterestRadius());
+  }
+  return map;
 }
 
+/*
+  Карты независимы друг от друга, поэтому строятся параллельно: потоки берут
+  следующий индекс из общего счётчика. Запоминается наименьший индекс карты
+  с ошибкой: карты за ним больше не строятся, а карты перед ним достраиваются,
+  так что наружу уходит ошибка карты с наименьшим индексом независимо от
+  расписания потоков
+*/
+std::vector<std::optional<model::Map>> LoadMaps(const json::array &maps_array,
+                                               const model::Game &defaults,
+                                               const JsonPath &path) {
+  const size_t count = maps_array.size();
+  std::vector<std::optional<model::Map>> maps(count);
+  std::vector<std::exception_ptr> errors(count);
+  std::atomic<size_t> next{0};
+  // Наименьший индекс карты с ошибкой; count - ошибок нет
+  std::atomic<size_t> first_failed{count};
+
+  auto work = [&] {
+    // Индексы выдаются по возрастанию, поэтому поток, получивший индекс
+    // не меньше first_failed, дальше получит только ещё большие
+    for (size_t i = next.fetch_add(1, std::memory_order_relaxed);
+         i < first_failed.load(std::memory_order_relaxed);
+         i = next.fetch_add(1, std::memory_order_relaxed)) {
+      try {
+        maps[i].emplace(LoadMap(maps_array[i], defaults, path.Index(i)));
+      } catch (...) {
+        errors[i] = std::current_exception();
+        size_t failed = first_failed.load(std::memory_order_relaxed);
+        while (i < failed && !first_failed.compare_exchange_weak(failed, i, std::memory_order_relaxed)) {
+        }
+      }
+    }
+  };
+
+  const size_t workers = std::clamp<size_t>(
+      (count + MAPS_PER_WORKER - 1) / MAPS_PER_WORKER, 1,
+      std::max(1u, std::thread::hardware_concurrency()));
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(workers - 1);
+    for (size_t i = 1; i < workers; ++i) {
+      threads.emplace_back(work);
+    }
+    work();
+  }
+
+  for (const std::exception_ptr &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return maps;
+}
+
+} // namespace
+
 model::Game LoadGame(const std::filesystem::path &json_path) {
   if (!std::filesystem::exists(json_path)) {
     throw std::runtime_error("Файл не найден: " + json_path.string());
@@ -106,70 +403,34 @@ model::Game LoadGame(const std::filesystem::path &json_path) {
   }
   std::string json_str((std::istreambuf_iterator<char>(file)),
                        std::istreambuf_iterator<char>());
-  // Парсинг строки как json
-  boost::json::value parsed_json = boost::json::parse(json_str);
-
-  model::Game game;
-
-  const auto &maps_array = parsed_json.as_object().at("maps").as_array();
-  for (const auto &item : maps_array) {
-    // Загрузка карты
-    const auto &map_obj = item.as_object();
-    model::Map::Id id{map_obj.at("id").as_string().c_str()};
-    std::string name = json::value_to<std::string>(map_obj.at("name"));
-    model::Map map(id, name);
-    double dog_speed = game.GetDefaultDogSpeed();
-    int bag_cap = game.GetDefaultBagCapacity();
-
-    try {
-      if (auto it = map_obj.find("dogSpeed"); it != map_obj.end()) {
-        dog_speed = it->value().as_double();
-      }
-      json::object attributes = json::parse(json_str).as_object();
-
-      if (auto it = attributes.find("defaultDogSpeed");
-          it != attributes.end()) {
-        game.SetDefaultDogSpeed(it->value().as_double());
-      }
-
-      if (auto it = attributes.find("dogRetirementTime");
-          it != attributes.end()) {
-        game.SetDogRetirementTime(
-            static_cast<unsigned>(it->value().as_double()));
-      }
+  return ParseGame(json_str);
+}
 
-      if (auto it = attributes.find("defaultBagCapacity");
-          it != attributes.end()) {
-        game.SetDefaultBagCapacity(it->value().as_int64());
-      }
+model::Game ParseGame(std::string_view json_str) {
+  // Файл разбирается один раз
+  boost::system::error_code ec;
+  const json::value parsed_json = json::parse(json_str, ec);
+  if (ec) {
+    throw ConfigError("$", "invalid JSON: " + ec.message());
+  }
 
-      if (auto it = attributes.find("lootGeneratorConfig");
-          it != attributes.end()) {
-        json::object loot_gen_config = it->value().as_object();
-        double period = loot_gen_config.at("period").as_double() * 1000;
-        double probability = loot_gen_config.at("probability").as_double();
+  const JsonPath root_path;
+  const json::object &root = AsObject(parsed_json, root_path);
 
-        game.SetLootGenerator(period, probability);
-      }
+  model::Game game;
+  ApplyGlobalSettings(game, LoadGlobalSettings(root, root_path));
 
-      if (auto it = attributes.find("bagCapacity"); it != attributes.end()) {
-        bag_cap = it->value().as_int64();
-      }
+  const JsonPath maps_path = root_path.Key("maps");
+  const json::array &maps_array = AsArray(Required(root, "maps", root_path), maps_path);
+  std::vector<std::optional<model::Map>> maps = LoadMaps(maps_array, game, maps_path);
 
-    } catch (std::exception &ex) {
-      std::cerr << ex.what() << std::endl;
+  for (size_t i = 0; i < maps.size(); ++i) {
+    try {
+      game.AddMap(std::move(*maps[i]));
+    } catch (const std::invalid_argument &ex) {
+      maps_path.Index(i).Key("id").Fail(ex.what());
     }
-
-    LoadingRoadIntoMap(map, map_obj.at("roads").as_array());
-    LoadingBuildingsIntoMap(map, map_obj.at("buildings").as_array());
-    LoadingOfficesIntoMap(map, map_obj.at("offices").as_array());
-    LOadLootTypeIntoMap(map, map_obj.at("lootTypes").as_array());
-    map.AddDogSpeed(dog_speed);
-    map.AddBagCapacity(bag_cap);
-
-    game.AddMap(std::move(map));
   }
-
   return game;
 }
 
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <boost/json.hpp>
+#include <cstddef>
 #include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 
 #include "model.h"
 
@@ -9,13 +13,23 @@ namespace json = boost::json;
 
 namespace json_loader {
 
+/* Ошибка в конфигурации; path - место ошибки в виде JSONPath, например $.maps[3].roads[0].x0 */
+class ConfigError : public std::runtime_error {
+public:
+  ConfigError(std::string path, const std::string &message);
+
+  const std::string &Path() const noexcept { return path_; }
+
+private:
+  std::string path_;
+};
+
+// Сколько карт в среднем достаётся одному потоку при параллельной загрузке
+constexpr size_t MAPS_PER_WORKER = 16;
+
+// Ошибки содержимого файла сообщаются через ConfigError
 model::Game LoadGame(const std::filesystem::path &json_path);
-void LoadingRoadIntoMap(model::Map &map, const boost::json::array &roads_array);
-void LoadingBuildingsIntoMap(model::Map &map,
-                             const boost::json::array &buildings_array);
-void LoadingOfficesIntoMap(model::Map &map,
-                           const boost::json::array &offices_array);
-void LOadLootTypeIntoMap(const json::object& json_map, model::Map& map);
+model::Game ParseGame(std::string_view json_str);
 
 const std::string MapIdName(const model::Game::Maps &maps);
 const std::string MapFullInfo(const model::Map &map);
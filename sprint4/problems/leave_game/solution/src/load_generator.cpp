@@ -0,0 +1,517 @@
+/*
+    Нагрузочный генератор для game_server.
+
+    Виртуальный пользователь проходит сценарий: join -> N раз (action, state) ->
+    records -> снова join. Каждый пользователь держит своё keep-alive соединение
+    и токен между запросами.
+
+    Режимы:
+      closed - N пользователей отправляют запросы друг за другом (замкнутая модель);
+      open   - запросы запускаются с фиксированной частотой RPS независимо от ответов
+               (открытая модель). Задержка отсчитывается от запланированного момента
+               отправки, поэтому отставание генератора не прячет задержки сервера.
+
+    Пример:
+      load_generator --mode open --rps 2000 --duration 30 --threads 4
+*/
+#include "sdk.h"
+//
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/use_future.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/json.hpp>
+#include <boost/program_options.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.h"
+
+using namespace std::literals;
+namespace net = boost::asio;
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace json = boost::json;
+using tcp = net::ip::tcp;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using StringRequest = http::request<http::string_body>;
+using StringResponse = http::response<http::string_body>;
+
+enum class Step { JOIN, ACTION, STATE, RECORDS, COUNT };
+
+constexpr std::array<std::string_view, static_cast<size_t>(Step::COUNT)>
+    STEP_NAMES = {"join"sv, "action"sv, "state"sv, "records"sv};
+
+struct Options {
+  std::string host = "127.0.0.1";
+  std::string port = "8080";
+  std::string mode = "closed";
+  unsigned users = 16;
+  unsigned max_users = 1024;
+  double rps = 1000;
+  double duration_s = 10;
+  unsigned threads = 0;
+  unsigned actions = 20;
+  unsigned think_ms = 0;
+  unsigned timeout_ms = 5000;
+  uint64_t seed = 42;
+};
+
+/* Статистика по шагам сценария. Гистограммы атомарны и общие для всех потоков */
+class Report {
+public:
+  void Observe(Step step, Clock::duration latency, bool ok) {
+    auto &series = steps_[static_cast<size_t>(step)];
+    series.latency.RecordDuration(latency);
+    (ok ? series.ok : series.errors).Increment();
+  }
+
+  void Missed() { missed_.Increment(); }
+
+  void Print(std::ostream &out, double elapsed_s) const {
+    out << std::fixed << std::setprecision(2);
+    out << std::left << std::setw(10) << "step" << std::right << std::setw(10)
+        << "count" << std::setw(9) << "errors" << std::setw(11) << "rps"
+        << std::setw(10) << "p50,ms" << std::setw(10) << "p90,ms"
+        << std::setw(10) << "p99,ms" << std::setw(10) << "p99.9,ms"
+        << std::setw(10) << "max,ms" << '\n';
+
+    metrics::Histogram total;
+    uint64_t total_ok = 0;
+    uint64_t total_errors = 0;
+    for (size_t i = 0; i < steps_.size(); ++i) {
+      const auto &series = steps_[i];
+      PrintRow(out, STEP_NAMES[i], series.ok.Value(), series.errors.Value(),
+               series.latency, elapsed_s);
+      total_ok += series.ok.Value();
+      total_errors += series.errors.Value();
+      total.Merge(series.latency);
+    }
+    PrintRow(out, "total"sv, total_ok, total_errors, total, elapsed_s);
+    out << "missed (no free user in open mode): " << missed_.Value() << '\n';
+  }
+
+private:
+  struct Series {
+    metrics::Counter ok;
+    metrics::Counter errors;
+    metrics::Histogram latency;
+  };
+
+  static void PrintRow(std::ostream &out, std::string_view name, uint64_t ok,
+                       uint64_t errors, const metrics::Histogram &latency,
+                       double elapsed_s) {
+    const auto ms = [&latency](double percentile) {
+      return static_cast<double>(latency.ValueAtPercentile(percentile)) / 1000.0;
+    };
+    out << std::left << std::setw(10) << name << std::right << std::setw(10)
+        << ok + errors << std::setw(9) << errors << std::setw(11)
+        << static_cast<double>(ok + errors) / elapsed_s << std::setw(10)
+        << ms(50) << std::setw(10) << ms(90) << std::setw(10) << ms(99)
+        << std::setw(10) << ms(99.9) << std::setw(10)
+        << static_cast<double>(latency.Max()) / 1000.0 << '\n';
+  }
+
+  std::array<Series, static_cast<size_t>(Step::COUNT)> steps_;
+  metrics::Counter missed_;
+};
+
+/* Keep-alive соединение, переподключается после ошибки или Connection: close */
+class HttpConnection {
+public:
+  HttpConnection(net::any_io_executor executor,
+                 const tcp::resolver::results_type &endpoints,
+                 std::chrono::milliseconds timeout)
+      : stream_(std::move(executor)), endpoints_(endpoints), timeout_(timeout) {}
+
+  net::awaitable<StringResponse> Send(StringRequest &req) {
+    try {
+      if (!stream_.socket().is_open()) {
+        stream_.expires_after(timeout_);
+        co_await stream_.async_connect(endpoints_, net::use_awaitable);
+        stream_.socket().set_option(tcp::no_delay{true});
+      }
+      stream_.expires_after(timeout_);
+      co_await http::async_write(stream_, req, net::use_awaitable);
+      StringResponse res;
+      co_await http::async_read(stream_, buffer_, res, net::use_awaitable);
+      if (res.need_eof()) {
+        Close();
+      }
+      co_return res;
+    } catch (...) {
+      Close();
+      throw;
+    }
+  }
+
+private:
+  void Close() {
+    beast::error_code ec;
+    stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+    stream_.close();
+    buffer_.clear();
+  }
+
+  beast::tcp_stream stream_;
+  beast::flat_buffer buffer_;
+  tcp::resolver::results_type endpoints_;
+  std::chrono::milliseconds timeout_;
+};
+
+/* Состояние одного игрока: токен, позиция в сценарии и соединение */
+class VirtualUser {
+public:
+  VirtualUser(unsigned id, net::any_io_executor executor,
+              const tcp::resolver::results_type &endpoints,
+              const Options &options, const std::vector<std::string> &maps)
+      : id_(id), executor_(executor),
+        connection_(executor, endpoints,
+                    std::chrono::milliseconds{options.timeout_ms}),
+        options_(options), maps_(maps), host_(options.host + ":" + options.port),
+        random_(options.seed + id) {}
+
+  const net::any_io_executor &GetExecutor() const { return executor_; }
+
+  /* Выполняет очередной шаг сценария. intended_start - момент, когда запрос должен был уйти */
+  net::awaitable<void> RunStep(Report &report, Clock::time_point intended_start) {
+    const Step step = NextStep();
+    StringRequest req = MakeRequest(step);
+    bool ok = false;
+    try {
+      StringResponse res = co_await connection_.Send(req);
+      ok = res.result_int() >= 200 && res.result_int() < 300;
+      OnResponse(step, res);
+    } catch (const std::exception &) {
+      token_.clear();
+    }
+    report.Observe(step, Clock::now() - intended_start, ok);
+  }
+
+private:
+  Step NextStep() const {
+    if (token_.empty()) {
+      return Step::JOIN;
+    }
+    if (actions_left_ == 0) {
+      return Step::RECORDS;
+    }
+    return state_pending_ ? Step::STATE : Step::ACTION;
+  }
+
+  StringRequest MakeRequest(Step step) {
+    StringRequest req;
+    req.version(11);
+    req.keep_alive(true);
+    req.set(http::field::host, host_);
+    switch (step) {
+    case Step::JOIN: {
+      std::uniform_int_distribution<size_t> map_index(0, maps_.size() - 1);
+      json::object body;
+      body["userName"] = "load" + std::to_string(id_);
+      body["mapId"] = maps_[map_index(random_)];
+      req.method(http::verb::post);
+      req.target("/api/v1/game/join");
+      req.set(http::field::content_type, "application/json");
+      req.body() = json::serialize(body);
+      break;
+    }
+    case Step::ACTION: {
+      static constexpr std::array MOVES = {"L"sv, "R"sv, "U"sv, "D"sv, ""sv};
+      std::uniform_int_distribution<size_t> move(0, MOVES.size() - 1);
+      req.method(http::verb::post);
+      req.target("/api/v1/game/player/action");
+      req.set(http::field::content_type, "application/json");
+      req.set(http::field::authorization, "Bearer " + token_);
+      req.body() = R"({"move": ")" + std::string(MOVES[move(random_)]) + R"("})";
+      break;
+    }
+    case Step::STATE:
+      req.method(http::verb::get);
+      req.target("/api/v1/game/state");
+      req.set(http::field::authorization, "Bearer " + token_);
+      break;
+    case Step::RECORDS:
+      req.method(http::verb::get);
+      req.target("/api/v1/game/records?start=0&maxItems=100");
+      break;
+    default:
+      break;
+    }
+    req.prepare_payload();
+    return req;
+  }
+
+  void OnResponse(Step step, const StringResponse &res) {
+    switch (step) {
+    case Step::JOIN:
+      if (res.result() == http::status::ok) {
+        token_ = std::string(
+            json::parse(res.body()).as_object().at("authToken").as_string());
+        actions_left_ = options_.actions;
+        state_pending_ = false;
+      }
+      break;
+    case Step::ACTION:
+    case Step::STATE:
+      /* Собака могла уйти на покой - заходим в игру заново */
+      if (res.result() == http::status::unauthorized) {
+        token_.clear();
+        break;
+      }
+      if (step == Step::STATE) {
+        --actions_left_;
+      }
+      state_pending_ = !state_pending_;
+      break;
+    case Step::RECORDS:
+      token_.clear();
+      break;
+    default:
+      break;
+    }
+  }
+
+  unsigned id_;
+  net::any_io_executor executor_;
+  HttpConnection connection_;
+  const Options &options_;
+  const std::vector<std::string> &maps_;
+  std::string host_;
+  std::mt19937_64 random_;
+
+  std::string token_;
+  unsigned actions_left_ = 0;
+  bool state_pending_ = false;
+};
+
+net::awaitable<std::vector<std::string>>
+FetchMapIds(const tcp::resolver::results_type &endpoints,
+            const Options &options) {
+  HttpConnection connection{co_await net::this_coro::executor, endpoints,
+                            std::chrono::milliseconds{options.timeout_ms}};
+  StringRequest req{http::verb::get, "/api/v1/maps", 11};
+  req.set(http::field::host, options.host + ":" + options.port);
+  StringResponse res = co_await connection.Send(req);
+  if (res.result() != http::status::ok) {
+    throw std::runtime_error("GET /api/v1/maps returned " +
+                             std::to_string(res.result_int()));
+  }
+  std::vector<std::string> ids;
+  for (const auto &map : json::parse(res.body()).as_array()) {
+    ids.emplace_back(map.as_object().at("id").as_string());
+  }
+  if (ids.empty()) {
+    throw std::runtime_error("Server has no maps");
+  }
+  co_return ids;
+}
+
+net::awaitable<void> RunClosedUser(VirtualUser &user, Report &report,
+                                   Clock::time_point deadline,
+                                   std::chrono::milliseconds think_time) {
+  net::steady_timer timer{user.GetExecutor()};
+  while (Clock::now() < deadline) {
+    co_await user.RunStep(report, Clock::now());
+    if (think_time.count() > 0) {
+      timer.expires_after(think_time);
+      co_await timer.async_wait(net::use_awaitable);
+    }
+  }
+}
+
+/* Пул свободных пользователей для открытой модели: каждый пользователь занят не более чем одним запросом */
+class UserPool {
+public:
+  UserPool(net::io_context &ioc, const tcp::resolver::results_type &endpoints,
+           const Options &options, const std::vector<std::string> &maps)
+      : ioc_(ioc), endpoints_(endpoints), options_(options), maps_(maps) {}
+
+  VirtualUser *Acquire() {
+    std::lock_guard lock{mutex_};
+    if (!idle_.empty()) {
+      VirtualUser *user = idle_.back();
+      idle_.pop_back();
+      return user;
+    }
+    if (users_.size() >= options_.max_users) {
+      return nullptr;
+    }
+    return users_
+        .emplace_back(std::make_unique<VirtualUser>(
+            static_cast<unsigned>(users_.size()), net::make_strand(ioc_),
+            endpoints_, options_, maps_))
+        .get();
+  }
+
+  void Release(VirtualUser *user) {
+    std::lock_guard lock{mutex_};
+    idle_.push_back(user);
+  }
+
+  size_t Size() {
+    std::lock_guard lock{mutex_};
+    return users_.size();
+  }
+
+private:
+  net::io_context &ioc_;
+  const tcp::resolver::results_type &endpoints_;
+  const Options &options_;
+  const std::vector<std::string> &maps_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<VirtualUser>> users_;
+  std::vector<VirtualUser *> idle_;
+};
+
+net::awaitable<void> RunOpenLoop(UserPool &pool, Report &report,
+                                 const Options &options,
+                                 Clock::time_point start,
+                                 Clock::time_point deadline) {
+  const auto interval = std::chrono::duration_cast<Clock::duration>(
+      std::chrono::duration<double>(1.0 / options.rps));
+  net::steady_timer timer{co_await net::this_coro::executor};
+  for (Clock::time_point next = start; next < deadline; next += interval) {
+    timer.expires_at(next);
+    co_await timer.async_wait(net::use_awaitable);
+
+    VirtualUser *user = pool.Acquire();
+    if (user == nullptr) {
+      report.Missed();
+      continue;
+    }
+    net::co_spawn(
+        user->GetExecutor(),
+        [user, &pool, &report, next]() -> net::awaitable<void> {
+          co_await user->RunStep(report, next);
+          pool.Release(user);
+        },
+        net::detached);
+  }
+}
+
+[[nodiscard]] std::optional<Options> ParseCommandLine(int argc,
+                                                      const char *const argv[]) {
+  namespace po = boost::program_options;
+  Options options;
+  po::options_description desc{"Allowed options"s};
+  desc.add_options()
+  ("help,h", "produce help message")
+  ("host", po::value(&options.host)->value_name("address"s), "Server address")
+  ("port", po::value(&options.port)->value_name("port"s), "Server port")
+  ("mode", po::value(&options.mode)->value_name("closed|open"s), "Load model")
+  ("users,u", po::value(&options.users)->value_name("count"s), "Virtual users in closed mode")
+  ("max-users", po::value(&options.max_users)->value_name("count"s), "Connection limit in open mode")
+  ("rps", po::value(&options.rps)->value_name("requests"s), "Request rate in open mode")
+  ("duration,d", po::value(&options.duration_s)->value_name("seconds"s), "Test duration")
+  ("threads", po::value(&options.threads)->value_name("count"s), "Worker threads (default: hardware concurrency)")
+  ("actions", po::value(&options.actions)->value_name("count"s), "Action/state iterations per game session")
+  ("think-time", po::value(&options.think_ms)->value_name("milliseconds"s), "Pause between requests in closed mode")
+  ("timeout", po::value(&options.timeout_ms)->value_name("milliseconds"s), "Request timeout")
+  ("seed", po::value(&options.seed)->value_name("number"s), "Random seed for scenarios");
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, desc), vm);
+  po::notify(vm);
+
+  if (vm.contains("help"s)) {
+    std::cout << desc;
+    return std::nullopt;
+  }
+  if (options.mode != "closed"s && options.mode != "open"s) {
+    throw std::runtime_error("Mode must be 'closed' or 'open'");
+  }
+  if (options.mode == "open"s && options.rps <= 0) {
+    throw std::runtime_error("RPS must be positive");
+  }
+  if (options.threads == 0) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return options;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+  try {
+    std::optional<Options> options = ParseCommandLine(argc, argv);
+    if (!options) {
+      return EXIT_SUCCESS;
+    }
+
+    net::io_context ioc(static_cast<int>(options->threads));
+    tcp::resolver resolver{ioc};
+    const auto endpoints = resolver.resolve(options->host, options->port);
+
+    std::vector<std::string> maps;
+    {
+      auto future = net::co_spawn(ioc, FetchMapIds(endpoints, *options),
+                                  net::use_future);
+      ioc.run();
+      ioc.restart();
+      maps = future.get();
+    }
+
+    Report report;
+    std::vector<std::unique_ptr<VirtualUser>> closed_users;
+    UserPool pool{ioc, endpoints, *options, maps};
+
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline =
+        start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(options->duration_s));
+
+    if (options->mode == "closed"s) {
+      for (unsigned i = 0; i < options->users; ++i) {
+        auto &user = closed_users.emplace_back(std::make_unique<VirtualUser>(
+            i, net::make_strand(ioc), endpoints, *options, maps));
+        net::co_spawn(user->GetExecutor(),
+                      RunClosedUser(*user, report, deadline,
+                                    std::chrono::milliseconds{options->think_ms}),
+                      net::detached);
+      }
+    } else {
+      net::co_spawn(net::make_strand(ioc),
+                    RunOpenLoop(pool, report, *options, start, deadline),
+                    net::detached);
+    }
+
+    std::vector<std::jthread> workers;
+    for (unsigned i = 1; i < options->threads; ++i) {
+      workers.emplace_back([&ioc] { ioc.run(); });
+    }
+    ioc.run();
+    workers.clear();
+
+    const double elapsed_s =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "mode=" << options->mode << " threads=" << options->threads
+              << " users="
+              << (options->mode == "closed"s ? options->users : pool.Size())
+              << " elapsed=" << elapsed_s << "s\n";
+    report.Print(std::cout, elapsed_s);
+  } catch (const std::exception &ex) {
+    std::cerr << "load_generator: " << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -8,7 +8,9 @@
 #include <thread>
 
 #include "boost_logger.h"
+#include "coro_session.h"
 #include "http_server.h"
+#include "io_context_pool.h"
 #include "json_loader.h"
 #include "request_handler.h"
 #include "request_struct.h"
@@ -41,7 +43,32 @@ ParseCommandLine(int argc, const char *const argv[]) {
       "set file path, which saves a game state in procces, and restore it at ""startup")
       ("save-state-period",
                  po::value(&save_tick_state)->value_name("milliseconds"s),
-                 "set period for automatic saving of game state.");
+                 "set period for automatic saving of game state.")
+  ("admin-api", "Enable diagnostic /admin/ endpoints (tracing, profiling)")
+  ("random-seed", po::value<uint64_t>()->value_name("number"s),
+      "Fix the seed of spawn and loot randomness: each thread draws its own stream derived from it, "
+      "so with a single worker thread the same order of joins and ticks replays the same game")
+  ("compression-threshold", po::value(&args.compression_threshold)->value_name("bytes"s),
+      "Compress API responses of at least this size when Accept-Encoding allows (default 1024)")
+  ("no-compression", "Never compress API responses")
+  ("io-mode", po::value(&args.io_mode)->value_name("shared|per-core"s),
+      "One io_context for all threads, or one per thread with SO_REUSEPORT listeners")
+  ("threads", po::value(&args.threads)->value_name("count"s),
+      "Worker threads (default: hardware concurrency)")
+  ("pin-threads", "Pin worker thread i to CPU i")
+  ("coroutine-sessions", "Serve connections with coroutine sessions that reuse per-connection memory")
+  ("shed-queue-depth", po::value(&args.shed_queue_depth)->value_name("requests"s),
+      "Reject /records, /players and repeated /state polls with 503 while this many requests wait for the game strand (0 disables)")
+  ("shed-queue-delay", po::value(&args.shed_queue_delay)->value_name("milliseconds"s),
+      "Reject the same requests while the average wait for the game strand exceeds this (0 disables)")
+  ("retry-after", po::value(&args.retry_after)->value_name("seconds"s),
+      "Retry-After value of rejected requests (default 1)")
+  ("rate-limit", po::value(&args.rate_limits)->composing()->value_name("class=rps[:burst]"s),
+      "Limit requests per player token (or client address) for a route class: "
+      "join, action, state or read. May be repeated")
+  ("rate-limit-clients-per-address", po::value(&args.rate_limit_clients_per_address)->value_name("count"s),
+      "Requests with a token are also limited per client address, at this many times the "
+      "per-player rate and burst (default 8)");
 
   // variables_map хранит значения опций после разбора
   po::variables_map vm;
@@ -78,21 +105,44 @@ ParseCommandLine(int argc, const char *const argv[]) {
   if (vm.contains("randomize-spawn-points"s)) {
     args.random_spawn = true;
   }
+  if (vm.contains("admin-api"s)) {
+    args.admin_api = true;
+  }
+  if (vm.contains("random-seed"s)) {
+    args.random_seed = vm["random-seed"s].as<uint64_t>();
+  }
+  if (vm.contains("no-compression"s)) {
+    args.compression = false;
+  }
+  if (vm.contains("pin-threads"s)) {
+    args.pin_threads = true;
+  }
+  if (vm.contains("coroutine-sessions"s)) {
+    args.coroutine_sessions = true;
+  }
+  // Проверяем режим сразу, чтобы ошибка в опции не дошла до подключения к БД
+  http_server::ParseIoMode(args.io_mode);
+  http_handler::ParseRateLimits(args.rate_limits);
+  if (args.threads == 0) {
+    args.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
 
   // С опциями программы всё в порядке, возвращаем структуру args
   return args;
 }
 
-// Запускает функцию fn на n потоках, включая текущий
-template <typename Fn> void RunWorkers(int n, const Fn &fn) {
-  n = std::max(1, n);
-  std::vector<std::jthread> workers;
-  workers.reserve(n - 1);
-  // Запускаем n-1 рабочих потоков, выполняющих функцию fn
-  while (--n) {
-    workers.emplace_back(fn);
-  }
-  fn();
+// Каждый SIGHUP перечитывает карты из файла конфигурации; результат и ошибки
+// ReloadMaps пишет в журнал сам
+void ReloadMapsOnSighup(net::signal_set &signals,
+                        std::shared_ptr<http_handler::RequestHandler> handler) {
+  signals.async_wait([&signals, handler](const sys::error_code &ec,
+                                         [[maybe_unused]] int signal_number) {
+    if (ec) {
+      return;
+    }
+    handler->ReloadMaps([](size_t, const std::string &) {});
+    ReloadMapsOnSighup(signals, handler);
+  });
 }
 
 } // namespace
@@ -111,7 +161,7 @@ int main(int argc, const char *argv[]) {
     return EXIT_FAILURE;
   }
   try {
-    const int NUM_THREADS = std::thread::hardware_concurrency();
+    const int NUM_THREADS = static_cast<int>(args->threads);
     const char *DB_URL = std::getenv("GAME_DB_URL");
     if (!DB_URL) {
       throw std::runtime_error("GAME_DB_URL is not specified");
@@ -122,15 +172,20 @@ int main(int argc, const char *argv[]) {
 
     // 1. Загружаем карту из файла и построить модель игры
     model::Game game = json_loader::LoadGame((*args).config);
-    // 2. Инициализируем io_context
-    net::io_context ioc(NUM_THREADS);
+    if (args->random_seed) {
+      model::SetRandomSeed(*args->random_seed);
+    }
+    // 2. Инициализируем io_context: общий или по одному на поток
+    http_server::IoContextPool pool(http_server::ParseIoMode(args->io_mode),
+                                    args->threads);
+    net::io_context &ioc = pool.GetMain();
 
     // 3. Добавляем асинхронный обработчик сигналов SIGINT и SIGTERM
     net::signal_set signals(ioc, SIGINT, SIGTERM);
     signals.async_wait(
-        [&ioc](const sys::error_code &ec, [[maybe_unused]] int signal_number) {
+        [&pool](const sys::error_code &ec, [[maybe_unused]] int signal_number) {
           if (!ec) {
-            ioc.stop();
+            pool.Stop();
           }
         });
 
@@ -142,21 +197,29 @@ int main(int argc, const char *argv[]) {
 
     handler->LoadState();
 
+    net::signal_set reload_signals(ioc, SIGHUP);
+    ReloadMapsOnSighup(reload_signals, handler);
+
     // 5. Запустить обработчик HTTP-запросов, делегируя их обработчику запросов
     const auto address = net::ip::make_address("0.0.0.0");
     constexpr net::ip::port_type port = 8080;
-    http_server::ServeHttp(ioc, {address, port},
-                           [&handler](auto &&req, auto &&send) {
-                             (*handler)(std::forward<decltype(req)>(req),
-                                        std::forward<decltype(send)>(send));
-                           });
+    auto serve = [&handler](auto &&req, const net::ip::address &remote, auto &&send) {
+      (*handler)(std::forward<decltype(req)>(req), remote,
+                 std::forward<decltype(send)>(send));
+    };
+    if (args->coroutine_sessions) {
+      http_server::ServeHttpOnEach<http_server::CoroSession>(
+          pool.GetContexts(), {address, port}, serve);
+    } else {
+      http_server::ServeHttpOnEach(pool.GetContexts(), {address, port}, serve);
+    }
 
     // Эта надпись сообщает тестам о том, что сервер запущен и готов
     // обрабатывать запросы
     logger::LogServerStart(port, address.to_string());
 
     // 6. Запускаем обработку асинхронных операций
-    RunWorkers(std::max(1, NUM_THREADS), [&ioc] { ioc.run(); });
+    pool.Run(args->pin_threads);
 
     handler->SaveState();
 
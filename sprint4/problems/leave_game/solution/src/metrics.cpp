@@ -0,0 +1,225 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <sstream>
+
+namespace metrics {
+
+namespace {
+
+/* Экспортируем в Prometheus только границы степеней двойки до ~134 с, остальное уходит в +Inf */
+constexpr unsigned MAX_EXPORTED_EXPONENT = 27;
+constexpr double MICROSECONDS_IN_SECOND = 1'000'000.0;
+
+std::string EscapeLabelValue(const std::string& value) {
+    std::string result;
+    result.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            result.push_back('\\');
+            result.push_back(c);
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result.push_back(c);
+        }
+    }
+    return result;
+}
+
+/* Формирует строку вида {route="state",status="200"} с возможной дополнительной меткой */
+std::string FormatLabels(const std::vector<std::string>& names, const LabelValues& values,
+                         const std::string& extra_name = {}, const std::string& extra_value = {}) {
+    std::string result;
+    for (size_t i = 0; i < names.size() && i < values.size(); ++i) {
+        result += result.empty() ? "{" : ",";
+        result += names[i] + "=\"" + EscapeLabelValue(values[i]) + "\"";
+    }
+    if (!extra_name.empty()) {
+        result += result.empty() ? "{" : ",";
+        result += extra_name + "=\"" + extra_value + "\"";
+    }
+    if (!result.empty()) {
+        result += "}";
+    }
+    return result;
+}
+
+void WriteHeader(std::ostream& out, const std::string& name, const std::string& help, std::string_view type) {
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+}
+
+std::string FormatSeconds(uint64_t microseconds) {
+    std::ostringstream out;
+    out << static_cast<double>(microseconds) / MICROSECONDS_IN_SECOND;
+    return out.str();
+}
+
+} // namespace
+
+/* ------------------------ Histogram ----------------------------------- */
+
+size_t Histogram::BucketIndex(uint64_t value) noexcept {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    const unsigned exponent = std::bit_width(value) - 1;
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+    const unsigned shift = exponent - SUB_BUCKET_BITS;
+    const uint64_t sub_bucket = (value >> shift) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>((shift + 1) * SUB_BUCKETS + sub_bucket);
+}
+
+uint64_t Histogram::BucketLowerBound(size_t index) noexcept {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const uint64_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t sub_bucket = index % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub_bucket) << shift;
+}
+
+uint64_t Histogram::BucketUpperBound(size_t index) noexcept {
+    if (index < SUB_BUCKETS) {
+        return index + 1;
+    }
+    const uint64_t shift = index / SUB_BUCKETS - 1;
+    const uint64_t sub_bucket = index % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub_bucket + 1) << shift;
+}
+
+void Histogram::Record(uint64_t value) noexcept {
+    buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t current_max = max_.load(std::memory_order_relaxed);
+    while (value > current_max
+           && !max_.compare_exchange_weak(current_max, value, std::memory_order_relaxed)) {
+    }
+}
+
+void Histogram::RecordDuration(Clock::duration duration) noexcept {
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    Record(static_cast<uint64_t>(std::max<int64_t>(microseconds, 0)));
+}
+
+void Histogram::Merge(const Histogram& other) noexcept {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        if (const uint64_t value = other.BucketValue(i)) {
+            buckets_[i].fetch_add(value, std::memory_order_relaxed);
+        }
+    }
+    count_.fetch_add(other.Count(), std::memory_order_relaxed);
+    sum_.fetch_add(other.Sum(), std::memory_order_relaxed);
+
+    const uint64_t other_max = other.Max();
+    uint64_t current_max = max_.load(std::memory_order_relaxed);
+    while (other_max > current_max
+           && !max_.compare_exchange_weak(current_max, other_max, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t Histogram::ValueAtPercentile(double percentile) const noexcept {
+    const uint64_t total = Count();
+    if (total == 0) {
+        return 0;
+    }
+    const double clamped = std::clamp(percentile, 0.0, 100.0);
+    const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * total)));
+
+    uint64_t accumulated = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        accumulated += BucketValue(i);
+        if (accumulated >= target) {
+            return std::min(BucketUpperBound(i) - 1, Max());
+        }
+    }
+    return Max();
+}
+
+/* ------------------------ Registry ----------------------------------- */
+
+Family<Counter>& Registry::AddCounter(std::string name, std::string help,
+                                      std::vector<std::string> label_names) {
+    std::lock_guard lock{mutex_};
+    return counters_.emplace_back(std::move(name), std::move(help), std::move(label_names));
+}
+
+Family<Gauge>& Registry::AddGauge(std::string name, std::string help,
+                                  std::vector<std::string> label_names) {
+    std::lock_guard lock{mutex_};
+    return gauges_.emplace_back(std::move(name), std::move(help), std::move(label_names));
+}
+
+Family<Histogram>& Registry::AddHistogram(std::string name, std::string help,
+                                          std::vector<std::string> label_names) {
+    std::lock_guard lock{mutex_};
+    return histograms_.emplace_back(std::move(name), std::move(help), std::move(label_names));
+}
+
+std::string Registry::RenderPrometheus() const {
+    std::lock_guard lock{mutex_};
+    std::ostringstream out;
+
+    for (const auto& family : counters_) {
+        WriteHeader(out, family.GetName(), family.GetHelp(), "counter");
+        family.ForEach([&](const LabelValues& values, const Counter& counter) {
+            out << family.GetName() << FormatLabels(family.GetLabelNames(), values)
+                << ' ' << counter.Value() << '\n';
+        });
+    }
+
+    for (const auto& family : gauges_) {
+        WriteHeader(out, family.GetName(), family.GetHelp(), "gauge");
+        family.ForEach([&](const LabelValues& values, const Gauge& gauge) {
+            out << family.GetName() << FormatLabels(family.GetLabelNames(), values)
+                << ' ' << gauge.Value() << '\n';
+        });
+    }
+
+    for (const auto& family : histograms_) {
+        WriteHeader(out, family.GetName(), family.GetHelp(), "histogram");
+        const auto& names = family.GetLabelNames();
+        family.ForEach([&](const LabelValues& values, const Histogram& histogram) {
+            if (histogram.Count() == 0) {
+                return;
+            }
+            uint64_t cumulative = 0;
+            for (size_t i = 0; i < Histogram::BUCKET_COUNT; ++i) {
+                cumulative += histogram.BucketValue(i);
+                /* Корзины заканчиваются перед степенью двойки. Корзина - полуинтервал целых микросекунд,
+                   а le в Prometheus включает границу, поэтому метка - последнее значение корзины */
+                const bool power_of_two_bound = i % Histogram::SUB_BUCKETS == Histogram::SUB_BUCKETS - 1
+                    && i >= 2 * Histogram::SUB_BUCKETS - 1;
+                if (power_of_two_bound
+                    && Histogram::BucketUpperBound(i) <= (uint64_t{1} << MAX_EXPORTED_EXPONENT)) {
+                    out << family.GetName() << "_bucket"
+                        << FormatLabels(names, values, "le", FormatSeconds(Histogram::BucketUpperBound(i) - 1))
+                        << ' ' << cumulative << '\n';
+                }
+            }
+            /* Запись идёт параллельно, поэтому общее число берём из просуммированных корзин */
+            out << family.GetName() << "_bucket" << FormatLabels(names, values, "le", "+Inf")
+                << ' ' << cumulative << '\n';
+            out << family.GetName() << "_sum" << FormatLabels(names, values)
+                << ' ' << FormatSeconds(histogram.Sum()) << '\n';
+            out << family.GetName() << "_count" << FormatLabels(names, values)
+                << ' ' << cumulative << '\n';
+        });
+    }
+
+    return out.str();
+}
+
+Registry& DefaultRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+} // namespace metrics
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace metrics {
+
+using Clock = std::chrono::steady_clock;
+using LabelValues = std::vector<std::string>;
+
+/*
+    Монотонно растущий счётчик.
+    Запись - один relaxed fetch_add, без блокировок.
+*/
+class Counter {
+public:
+    void Increment(uint64_t value = 1) noexcept {
+        value_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t Value() const noexcept {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/*
+    Мгновенное значение, которое может как расти, так и уменьшаться
+*/
+class Gauge {
+public:
+    void Set(int64_t value) noexcept {
+        value_.store(value, std::memory_order_relaxed);
+    }
+
+    void Add(int64_t delta) noexcept {
+        value_.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    int64_t Value() const noexcept {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+/*
+    Гистограмма с фиксированной логарифмически-линейной сеткой корзин (как в HDR Histogram).
+    Каждая степень двойки делится на SUB_BUCKETS равных корзин, поэтому относительная
+    погрешность не превышает 1/SUB_BUCKETS. Индекс корзины вычисляется битовыми операциями,
+    а запись - несколько relaxed атомарных операций, без блокировок и выделений памяти.
+    Значения хранятся в микросекундах.
+*/
+class Histogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 3;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t{1} << SUB_BUCKET_BITS;
+    /* Значения больше 2^MAX_EXPONENT мкс (~12 суток) попадают в последнюю корзину */
+    static constexpr unsigned MAX_EXPONENT = 40;
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    void Record(uint64_t value) noexcept;
+
+    void RecordDuration(Clock::duration duration) noexcept;
+
+    /* Добавляет записи другой гистограммы (например, для итоговой строки отчёта) */
+    void Merge(const Histogram& other) noexcept;
+
+    uint64_t Count() const noexcept {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Sum() const noexcept {
+        return sum_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Max() const noexcept {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    uint64_t BucketValue(size_t index) const noexcept {
+        return buckets_[index].load(std::memory_order_relaxed);
+    }
+
+    /* Верхняя граница значений, не превышаемая долей percentile (0..100) записей */
+    uint64_t ValueAtPercentile(double percentile) const noexcept;
+
+    static size_t BucketIndex(uint64_t value) noexcept;
+
+    /* Значения корзины index лежат в полуинтервале [BucketLowerBound, BucketUpperBound) */
+    static uint64_t BucketLowerBound(size_t index) noexcept;
+
+    static uint64_t BucketUpperBound(size_t index) noexcept;
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/*
+    Семейство метрик с одинаковым именем и набором меток.
+    Поиск дочерней метрики по значениям меток выполняется под мьютексом,
+    поэтому на горячем пути ссылку на неё следует сохранить заранее.
+    Адреса дочерних метрик стабильны всё время жизни семейства.
+*/
+template <typename Metric>
+class Family {
+public:
+    Family(std::string name, std::string help, std::vector<std::string> label_names)
+        : name_(std::move(name))
+        , help_(std::move(help))
+        , label_names_(std::move(label_names)) {
+    }
+
+    Metric& WithLabels(const LabelValues& label_values) {
+        std::lock_guard lock{mutex_};
+        auto& child = children_[label_values];
+        if (!child) {
+            child = std::make_unique<Metric>();
+        }
+        return *child;
+    }
+
+    /* Убирает ребёнка из вывода; ссылки, полученные от WithLabels, становятся недействительными */
+    void Remove(const LabelValues& label_values) {
+        std::lock_guard lock{mutex_};
+        children_.erase(label_values);
+    }
+
+    const std::string& GetName() const noexcept {
+        return name_;
+    }
+
+    const std::string& GetHelp() const noexcept {
+        return help_;
+    }
+
+    const std::vector<std::string>& GetLabelNames() const noexcept {
+        return label_names_;
+    }
+
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+        std::lock_guard lock{mutex_};
+        for (const auto& [label_values, metric] : children_) {
+            fn(label_values, *metric);
+        }
+    }
+
+private:
+    std::string name_;
+    std::string help_;
+    std::vector<std::string> label_names_;
+    mutable std::mutex mutex_;
+    std::map<LabelValues, std::unique_ptr<Metric>> children_;
+};
+
+/*
+    Реестр метрик процесса. Умеет выводить все метрики в текстовом формате Prometheus.
+*/
+class Registry {
+public:
+    Family<Counter>& AddCounter(std::string name, std::string help,
+                                std::vector<std::string> label_names = {});
+
+    Family<Gauge>& AddGauge(std::string name, std::string help,
+                            std::vector<std::string> label_names = {});
+
+    Family<Histogram>& AddHistogram(std::string name, std::string help,
+                                    std::vector<std::string> label_names = {});
+
+    std::string RenderPrometheus() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::deque<Family<Counter>> counters_;
+    std::deque<Family<Gauge>> gauges_;
+    std::deque<Family<Histogram>> histograms_;
+};
+
+/* Реестр, в который пишут все подсистемы сервера */
+Registry& DefaultRegistry();
+
+/* Замеряет время жизни объекта и записывает его в гистограмму */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram) noexcept
+        : histogram_(histogram) {
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    ~ScopedTimer() {
+        histogram_.RecordDuration(Clock::now() - start_);
+    }
+
+private:
+    Histogram& histogram_;
+    Clock::time_point start_ = Clock::now();
+};
+
+} // namespace metrics
@@ -1,6 +1,9 @@
 #include "model.h"
+#include "tracing.h"
 
+#include <cmath>
 #include <exception>
+#include <memory_resource>
 #include <stdexcept>
 #include <set>
 
@@ -15,36 +18,12 @@ static const double LOOT_WIDTH = 0;
 static const double DOG_WIDTH = 0.6;
 static const double OFFICE_WIDTH = 0.5;
 
-class ObjectsAndDogsProvider : public ItemGathererProvider{
-public:
-    using Objects = std::vector<Item>;
-    using Dogs = std::vector<Gatherer>;
+using Objects = std::pmr::vector<Item>;
+using Dogs = std::pmr::vector<Gatherer>;
 
-    ObjectsAndDogsProvider(Objects objects, Dogs dogs)
-    : objects_(std::move(objects)), dogs_(std::move(dogs)){}
-
-    size_t ItemsCount() const override{
-        return objects_.size();
-    }
-
-    Item GetItem(size_t idx) const override{
-        return objects_[idx];
-    }
-
-    size_t GatherersCount() const override{
-        return dogs_.size();
-    }
-
-    Gatherer GetGatherer(size_t idx) const override{
-        return dogs_[idx];
-    }
-private:
-    Objects objects_;
-    Dogs dogs_;
-};
-
-ObjectsAndDogsProvider::Objects MakeLoot(const std::list<Loot>& loots){
-    ObjectsAndDogsProvider::Objects result;
+Objects MakeLoot(const GameSession::LootObjects& loots, std::pmr::memory_resource* memory){
+    Objects result{memory};
+    result.reserve(loots.size());
 
     for(const Loot& loot : loots){
         result.emplace_back(loot.pos, LOOT_WIDTH);
@@ -53,8 +32,9 @@ ObjectsAndDogsProvider::Objects MakeLoot(const std::list<Loot>& loots){
     return result;
 }
 
-ObjectsAndDogsProvider::Objects MakeOffices(const std::deque<Office>& offices){
-    ObjectsAndDogsProvider::Objects result;
+Objects MakeOffices(const std::deque<Office>& offices, std::pmr::memory_resource* memory){
+    Objects result{memory};
+    result.reserve(offices.size());
 
     for(const Office& office : offices){
         Point2D pos = {
@@ -67,13 +47,14 @@ ObjectsAndDogsProvider::Objects MakeOffices(const std::deque<Office>& offices){
     return result;
 }
 
-ObjectsAndDogsProvider::Dogs MakeDogs(const std::list<Dog>& dogs, double delta){
-    ObjectsAndDogsProvider::Dogs result;
+Dogs MakeDogs(const std::vector<Dog*>& dogs, double delta, std::pmr::memory_resource* memory){
+    Dogs result{memory};
+    result.reserve(dogs.size());
 
-    for(const Dog& dog : dogs){
-        PairDouble speed = *(dog.GetSpeed());
+    for(const Dog* dog : dogs){
+        PairDouble speed = *(dog->GetSpeed());
 
-        Point2D start_pos = *(dog.GetPosition());
+        Point2D start_pos = *(dog->GetPosition());
         Point2D end_pos = {start_pos.x + speed.x * delta, start_pos.y + speed.y * delta};
 
         result.emplace_back(start_pos, end_pos, DOG_WIDTH);
@@ -91,8 +72,10 @@ enum class GatheringEventType{
     Смешивает события столкновений в хронологическом порядке
 */
 using Event = std::pair<GatheringEvent, GatheringEventType>;
-std::vector<Event> MixEvents(std::vector<GatheringEvent> collectings, std::vector<GatheringEvent> deliverings){
-    std::vector<Event> result;
+std::pmr::vector<Event> MixEvents(const std::pmr::vector<GatheringEvent>& collectings,
+                                  const std::pmr::vector<GatheringEvent>& deliverings,
+                                  std::pmr::memory_resource* memory){
+    std::pmr::vector<Event> result{memory};
     size_t collectings_count = collectings.size();
     size_t deliverings_count = deliverings.size();
     
@@ -118,6 +101,35 @@ std::vector<Event> MixEvents(std::vector<GatheringEvent> collectings, std::vecto
 
 } // namespace detail
 
+/* ------------------------ Dog ----------------------------------- */
+
+int Dog::CheckBagCapacity(int capacity){
+    if (capacity < 0 || static_cast<size_t>(capacity) > MAX_BAG_CAPACITY) {
+        throw std::invalid_argument("Bag capacity "s + std::to_string(capacity) + " is out of [0, "s
+                                    + std::to_string(MAX_BAG_CAPACITY) + "]"s);
+    }
+    return capacity;
+}
+
+void Dog::SetSpeed(const Speed& new_speed){
+    const bool was_stopped = IsStopped();
+    speed_ = new_speed;
+    if(was_stopped == IsStopped()){
+        return;
+    }
+
+    if(session_ != nullptr){
+        session_->OnDogMovementChanged(*this);
+    }
+    if(activity_listener_ != nullptr){
+        if(was_stopped){
+            activity_listener_->OnDogStartedMoving(*this);
+        } else {
+            activity_listener_->OnDogStopped(*this);
+        }
+    }
+}
+
 /* ------------------------ Map ----------------------------------- */
 
 const Map::Id& Map::GetId() const noexcept {
@@ -145,12 +157,15 @@ const Map::LootTypes& Map::GetLootTypes() const noexcept{
 }
 
 int Map::GetRandomLootType() const{
-    return GetRandomNumber(0, loot_types_.size() - 1);
+    return static_cast<int>(RandomIndex(loot_types_.size()));
 }
 
 void Map::AddRoad(const Road& road) {
     const Road& added_road = roads_.emplace_back(road);
 
+    const double length = std::abs(road.GetEnd().x - road.GetStart().x) + std::abs(road.GetEnd().y - road.GetStart().y);
+    road_length_prefix_.push_back((road_length_prefix_.empty() ? 0. : road_length_prefix_.back()) + length);
+
     if(added_road.IsVertical()){
         road_map_[Map::RoadTag::VERTICAL].insert({road.GetStart().x, added_road});
     } else{
@@ -158,8 +173,8 @@ void Map::AddRoad(const Road& road) {
     }
 }
 
-std::vector<const Road*> Map::FindRoadsByCoords(const Dog::Position& pos) const{
-    std::vector<const Road*> result;
+Map::RoadsNearby Map::FindRoadsByCoords(const Dog::Position& pos) const{
+    RoadsNearby result;
     FindInVerticals(pos, result);
     FindInHorizontals(pos, result);
 
@@ -199,35 +214,62 @@ double Map::GetDogSpeed() const{
 }
 
 void Map::AddBagCapacity(int new_cap){
-    bag_capacity_ = new_cap;
+    bag_capacity_ = Dog::CheckBagCapacity(new_cap);
 }
 
 int Map::GetBagCapacity() const{
     return bag_capacity_;
 }
 
+void Map::SetMaxPlayersPerSession(size_t max_players){
+    max_players_per_session_ = max_players;
+}
+
+size_t Map::GetMaxPlayersPerSession() const{
+    return max_players_per_session_;
+}
+
+void Map::SetInterestRadius(double radius){
+    interest_radius_ = radius;
+}
+
+double Map::GetInterestRadius() const{
+    return interest_radius_;
+}
+
 PairDouble Map::GetFirstPos(const model::Map::Roads& roads){
     const Point& pos = roads.begin()->GetStart();
     return {static_cast<double>(pos.x), static_cast<double>(pos.y)};
 }
 
-PairDouble Map::GetRandomPos(const model::Map::Roads& roads){
-    model::Map::RoadTag tag = model::Map::RoadTag(GetRandomNumber(0, 2));
-    size_t road_index = GetRandomNumber(0, roads.size());
-    const model::Road& road = *(roads.begin());
-    double x = 0;
-    double y = 0;
+PairDouble Map::GetRandomPos() const{
+    if(roads_.empty()){
+        throw std::logic_error("Map "s + *id_ + " has no roads"s);
+    }
+    const double total_length = road_length_prefix_.back();
+    if(total_length <= 0){
+        return GetFirstPos(roads_);
+    }
+
+    const double offset = RandomDouble(0, total_length);
+    auto it = std::upper_bound(road_length_prefix_.begin(), road_length_prefix_.end(), offset);
+    if(it == road_length_prefix_.end()){
+        it = std::prev(it);
+    }
+    const size_t road_index = std::distance(road_length_prefix_.begin(), it);
+    const double road_start_offset = road_index == 0 ? 0. : road_length_prefix_[road_index - 1];
+
+    const Road& road = roads_[road_index];
+    const Point start = road.GetStart();
+    const Point end = road.GetEnd();
+    const double along = offset - road_start_offset;
     if(road.IsHorizontal()){
-        x = GetRandomNumber(road.GetStart().x, road.GetEnd().x);
-        y = road.GetStart().y;
-    } else if(road.IsVertical()){
-        x = road.GetStart().x;
-        y = GetRandomNumber(road.GetStart().y, road.GetEnd().y);
+        return {start.x + (end.x > start.x ? along : -along), static_cast<double>(start.y)};
     }
-    return {x,y};
+    return {static_cast<double>(start.x), start.y + (end.y > start.y ? along : -along)};
 }
 
-void Map::FindInVerticals(const Dog::Position& pos, std::vector<const Road*>& roads) const{
+void Map::FindInVerticals(const Dog::Position& pos, RoadsNearby& roads) const{
     const auto& v_roads = road_map_.at(Map::RoadTag::VERTICAL);
     ConstRoadIt it_x = v_roads.lower_bound((*pos).x);          /* Ищем ближайшую дорогу по полученной координате */
 
@@ -250,7 +292,7 @@ void Map::FindInVerticals(const Dog::Position& pos, std::vector<const Road*>& ro
     }
 }
 
-void Map::FindInHorizontals(const Dog::Position& pos, std::vector<const Road*>& roads) const{
+void Map::FindInHorizontals(const Dog::Position& pos, RoadsNearby& roads) const{
     const auto& h_roads = road_map_.at(Map::RoadTag::HORIZONTAl);
     ConstRoadIt it_y = h_roads.lower_bound((*pos).y);          /* Ищем ближайшую дорогу по полученной координате */
 
@@ -287,17 +329,90 @@ bool Map::CheckBounds(ConstRoadIt it, const Dog::Position& pos) const{
 Dog* GameSession::AddDog(int id, const Dog::Name& name, 
                     const Dog::Position& pos, const Dog::Speed& vel, 
                     Direction dir){
-    dogs_.emplace_back(id, name, pos, vel, dir);
-    return &dogs_.back();
+    return AttachDog(dogs_.emplace_back(id, name, pos, vel, dir));
 }
 
 Dog* GameSession::AddCreatedDog(Dog new_dog){
-    dogs_.emplace_back(std::move(new_dog));
-    return &dogs_.back();
+    return AttachDog(dogs_.emplace_back(std::move(new_dog)));
+}
+
+Dog* GameSession::AttachDog(Dog& dog){
+    interest_grid_dirty_ = true;
+    dog.session_ = this;
+    if(!dog.IsStopped()){
+        AddMovingDog(dog);
+    }
+    return &dog;
+}
+
+void GameSession::OnDogMovementChanged(Dog& dog){
+    if(dog.IsStopped()){
+        RemoveMovingDog(dog);
+    } else {
+        AddMovingDog(dog);
+    }
+}
+
+void GameSession::AddMovingDog(Dog& dog){
+    dog.moving_slot_ = moving_dogs_.size();
+    moving_dogs_.push_back(&dog);
+}
+
+void GameSession::RemoveMovingDog(Dog& dog){
+    const size_t slot = dog.moving_slot_;
+    if(slot >= moving_dogs_.size() || moving_dogs_[slot] != &dog){
+        return;
+    }
+    moving_dogs_[slot] = moving_dogs_.back();
+    moving_dogs_[slot]->moving_slot_ = slot;
+    moving_dogs_.pop_back();
+}
+
+const std::vector<Dog*>& GameSession::GetMovingDogs() const{
+    return moving_dogs_;
+}
+
+void GameSession::UpdateInterestGrid() const{
+    const double radius = map_->GetInterestRadius();
+    if(radius <= 0 || !interest_grid_dirty_){
+        return;
+    }
+    TRACE_SCOPE("GameSession::UpdateInterestGrid");
+
+    /* Ячейка размером с радиус: запрос затрагивает не больше 3x3 ячеек */
+    dogs_grid_.Reset(radius);
+    for(const Dog& dog : dogs_){
+        dogs_grid_.Insert(*dog.GetPosition(), &dog);
+    }
+    dogs_grid_.Build();
+
+    loot_grid_.Reset(radius);
+    for(const Loot& loot : loot_){
+        loot_grid_.Insert(loot.pos, loot.id);
+    }
+    loot_grid_.Build();
+
+    interest_grid_dirty_ = false;
+}
+
+void GameSession::FindDogsInRadius(PairDouble center, double radius, std::vector<const Dog*>& dogs) const{
+    UpdateInterestGrid();
+    dogs.clear();
+    dogs_grid_.ForEachInRadius(center, radius, [&dogs](const Dog* dog){
+        dogs.push_back(dog);
+    });
+}
+
+void GameSession::FindLootInRadius(PairDouble center, double radius, std::vector<const Loot*>& loot) const{
+    UpdateInterestGrid();
+    loot.clear();
+    loot_grid_.ForEachInRadius(center, radius, [this, &loot](int id){
+        loot.push_back(loot_.Find(id));
+    });
 }
 
 const Map* GameSession::GetMap() const {
-    return map_;
+    return map_.get();
 }
 
 std::list<Dog>& GameSession::GetDogs(){
@@ -311,30 +426,37 @@ const std::list<Dog>& GameSession::GetDogs() const{
 void GameSession::UpdateLoot(int loot_count){
     for(int i = 0; i < loot_count; ++i){
         int type = map_->GetRandomLootType();
-        PairDouble pos = Map::GetRandomPos(map_->GetRoads());
+        PairDouble pos = map_->GetRandomPos();
         int value = 1;
 
         const LootType& loot_type = map_->GetLootTypes().at(type);
         if(loot_type.value.has_value()){
             value = map_->GetLootTypes().at(type).value.value();
         }
-        loot_.emplace_back(++auto_loot_counter_, type, value, pos);
+        loot_.Insert(Loot{++auto_loot_counter_, type, value, pos});
     }
+    interest_grid_dirty_ |= loot_count > 0;
 }
 
-void GameSession::SetLootObjects(std::list<Loot> new_loot){
-    loot_ = std::move(new_loot);
+void GameSession::SetLootObjects(const std::list<Loot>& new_loot){
+    interest_grid_dirty_ = true;
+    loot_.Clear();
+    loot_.Reserve(new_loot.size());
+    for(const Loot& loot : new_loot){
+        loot_.Insert(loot);
+        auto_loot_counter_ = std::max(auto_loot_counter_, loot.id);
+    }
 }
 
-const std::list<Loot>& GameSession::GetLootObjects() const{
+const GameSession::LootObjects& GameSession::GetLootObjects() const{
     return loot_;
 }
 
-void GameSession::DeleteCollectedLoot(const std::set<size_t>& collected_items){
-    for(auto collect_id = collected_items.rbegin(); collect_id != collected_items.rend(); std::advance(collect_id, 1)){
-        auto it = std::next(loot_.begin(), *collect_id);
-        loot_.erase(it);
+void GameSession::DeleteCollectedLoot(std::span<const int> collected_ids){
+    for(int id : collected_ids){
+        loot_.Erase(id);
     }
+    interest_grid_dirty_ |= !collected_ids.empty();
 }
 
 void GameSession::DeleteDog(const Dog* erasing_dog){
@@ -342,47 +464,81 @@ void GameSession::DeleteDog(const Dog* erasing_dog){
         return &dog == erasing_dog;
     });
 
+    RemoveMovingDog(*it);
     dogs_.erase(it);
+    interest_grid_dirty_ = true;
 }
 
 /* ------------------------ Game ----------------------------------- */
 
 void Game::AddMap(Map&& map) {
-    const size_t index = maps_.size();
-    if (auto [it, inserted] = map_id_to_index_.emplace(map.GetId(), index); !inserted) {
+    const size_t id_index = map.GetId().GetIndex();
+    if (FindMap(map.GetId()) != nullptr) {
         throw std::invalid_argument("Map with id "s + *map.GetId() + " already exists"s);
-    } else {
-        try {
-            maps_.emplace_back(std::move(map));
-        } catch (std::exception& ex) {
-            map_id_to_index_.erase(it);
-            throw ex;
-        }
     }
+    if (id_index >= maps_->index.size()) {
+        maps_->index.resize(id_index + 1, NO_MAP);
+    }
+    maps_->maps.emplace_back(std::move(map));
+    maps_->index[id_index] = maps_->maps.size() - 1;
+}
+
+std::shared_ptr<const Game::MapVersion> Game::ReplaceMaps(const Game& loaded) {
+    std::shared_ptr<const MapVersion> previous = std::move(maps_);
+    maps_ = loaded.maps_;
+    return previous;
+}
+
+std::shared_ptr<const Map> Game::ShareMap(const Map* map) const {
+    return std::shared_ptr<const Map>(maps_, map);
 }
 
 GameSession* Game::AddSession(const Map::Id& map_id){
     if(const Map* map = FindMap(map_id); map != nullptr){
-        GameSession* session = &(map_id_to_sessions_[map_id].emplace_back(map));
+        GameSession* session = &(map_id_to_sessions_[map_id].emplace_back(ShareMap(map)));
         return session;
     }
     return nullptr;
 }
 
-GameSession* Game::SessionIsExists(const Map::Id& map_id){
-    if(const Map* map = FindMap(map_id); map != nullptr){
-        if(!map_id_to_sessions_[map_id].empty()){
-            GameSession* session = &(map_id_to_sessions_[map_id].back());
-            return session;
+GameSession* Game::FindSessionForNewDog(const Map::Id& map_id){
+    const Map* map = FindMap(map_id);
+    if(map == nullptr){
+        return nullptr;
+    }
+
+    std::list<GameSession>& sessions = map_id_to_sessions_[map_id];
+    const size_t capacity = map->GetMaxPlayersPerSession();
+    GameSession* found = nullptr;
+    for(GameSession& session : sessions){
+        const size_t dogs_count = session.GetDogs().size();
+        /* Сессии прежней версии карты доигрываются без новых игроков */
+        if(session.GetMap() != map || (capacity != 0 && dogs_count >= capacity)){
+            continue;
+        }
+        if(session_placement_ == SessionPlacement::FILL){
+            found = &session;
+            break;
+        }
+        if(found == nullptr || dogs_count < found->GetDogs().size()){
+            found = &session;
         }
     }
-    return nullptr;
+
+    if(found == nullptr){
+        found = &sessions.emplace_back(ShareMap(map));
+    }
+    return found;
 }
 
 const Game::SessionsByMapId& Game::GetAllSessions() const{
     return map_id_to_sessions_;
 }
 
+Game::SessionsByMapId& Game::GetAllSessions(){
+    return map_id_to_sessions_;
+}
+
 void Game::SetLootGenerator(double period, double probability){
     loot_generator_.emplace(detail::FromDouble(period), probability);
 }
@@ -396,7 +552,7 @@ double Game::GetDefaultDogSpeed() const{
 }
 
 void Game::SetDefaultBagCapacity(int new_cap){
-    default_bag_capacity_ = new_cap;
+    default_bag_capacity_ = Dog::CheckBagCapacity(new_cap);
 }
 
 int Game::GetDefaultBagCapacity() const{
@@ -411,13 +567,38 @@ int Game::GetDogRetirementTime() const{
     return dog_retirement_time_;
 }
 
+void Game::SetMaxPlayersPerSession(size_t max_players){
+    max_players_per_session_ = max_players;
+}
+
+size_t Game::GetMaxPlayersPerSession() const{
+    return max_players_per_session_;
+}
+
+void Game::SetSessionPlacement(SessionPlacement placement){
+    session_placement_ = placement;
+}
+
+SessionPlacement Game::GetSessionPlacement() const{
+    return session_placement_;
+}
+
+void Game::SetInterestRadius(double radius){
+    interest_radius_ = radius;
+}
+
+double Game::GetInterestRadius() const{
+    return interest_radius_;
+}
+
 const Game::Maps& Game::GetMaps() const noexcept {
-    return maps_;
+    return maps_->maps;
 }
 
 const Map* Game::FindMap(const Map::Id& id) const noexcept {
-    if (auto it = map_id_to_index_.find(id); it != map_id_to_index_.end()) {
-        return &maps_.at(it->second);
+    const size_t id_index = id.GetIndex();
+    if (id_index < maps_->index.size() && maps_->index[id_index] != NO_MAP) {
+        return &maps_->maps[maps_->index[id_index]];
     }
     return nullptr;
 }
@@ -427,6 +608,7 @@ detail::Milliseconds Game::GetLootGeneratePeriod() const{
 }
 
 void Game::GenerateLootInSessions(detail::Milliseconds delta){
+    TRACE_SCOPE("Game::GenerateLootInSessions");
     for(auto& [map_id, sessions] : map_id_to_sessions_){
         for(GameSession& session : sessions){
             int current_loot_count = session.GetLootObjects().size();
@@ -437,35 +619,52 @@ void Game::GenerateLootInSessions(detail::Milliseconds delta){
 }
 
 void Game::UpdateGameState(int delta){
+    TRACE_SCOPE("Game::UpdateGameState");
     double delta_in_seconds = static_cast<double>(delta) / 1000;
     for(auto& [map_id, sessions] : map_id_to_sessions_){
         for(GameSession& session : sessions){
-            UpdateDogsLoot(session, delta_in_seconds);
-            UpdateAllDogsPositions(session.GetDogs(), session.GetMap(), delta_in_seconds);
+            /* Стоящие собаки ничего не подбирают и не перемещаются */
+            if(!session.GetMovingDogs().empty()){
+                UpdateDogsLoot(session, delta_in_seconds);
+                UpdateAllDogsPositions(session.GetMovingDogs(), session.GetMap(), delta_in_seconds);
+                session.interest_grid_dirty_ = true;
+            }
+            session.UpdateInterestGrid();
         }
     }
+    tick_arena_->Reset();
 }
 
-void Game::DisconnectDogFromSession(const GameSession* player_session, const Dog* erasing_dog){
-    Map::Id map_id = player_session->GetMap()->GetId();
+const util::TickArena::Stats& Game::GetTickArenaStats() const{
+    return tick_arena_->GetLastTickStats();
+}
 
-    std::deque<GameSession>& sessions = map_id_to_sessions_.at(map_id);
+void Game::DisconnectDogFromSession(const GameSession* player_session, const Dog* erasing_dog){
+    std::list<GameSession>& sessions = map_id_to_sessions_.at(player_session->GetMap()->GetId());
     auto it = std::find_if(sessions.begin(), sessions.end(), [player_session](const GameSession& session){
         return &session == player_session;
     });
 
     GameSession& found_session = *it;
     found_session.DeleteDog(erasing_dog);
+    if(found_session.GetDogs().empty()){
+        sessions.erase(it);
+    }
 }
 
-void Game::UpdateAllDogsPositions(std::list<Dog>& dogs, const Map* map, double delta){
-    for(Dog& dog : dogs){
-        std::vector<const Road*> roads = map->FindRoadsByCoords(dog.GetPosition());
-        UpdateDogPos(dog, roads, delta);
+void Game::UpdateAllDogsPositions(const std::vector<Dog*>& moving_dogs, const Map* map, double delta){
+    TRACE_SCOPE("Game::UpdateAllDogsPositions");
+    /*
+        Остановившаяся собака удаляется из moving_dogs перестановкой последней
+        на её место, поэтому обход идёт с конца: переставленная уже обработана
+    */
+    for(size_t i = moving_dogs.size(); i-- > 0;){
+        Dog& dog = *moving_dogs[i];
+        UpdateDogPos(dog, map->FindRoadsByCoords(dog.GetPosition()), delta);
     }
 }
 
-void Game::UpdateDogPos(Dog& dog, const std::vector<const Road*>& roads, double delta){
+void Game::UpdateDogPos(Dog& dog, const Map::RoadsNearby& roads, double delta){
     const auto [x, y] = *(dog.GetPosition());
     const auto [vx, vy] = *(dog.GetSpeed());
 
@@ -475,7 +674,7 @@ void Game::UpdateDogPos(Dog& dog, const std::vector<const Road*>& roads, double
     PairDouble result_pos(getting_pos);
     PairDouble result_speed(getting_speed);
 
-    std::set<PairDouble> collisions;
+    std::pmr::set<PairDouble> collisions{tick_arena_->Resource()};
 
     for(const Road* road : roads){
         Point start = road->GetStart();
@@ -516,33 +715,42 @@ void Game::UpdateDogPos(Dog& dog, const std::vector<const Road*>& roads, double
 }   
 
 void Game::UpdateDogsLoot(GameSession& session, double delta) {
+    TRACE_SCOPE("Game::UpdateDogsLoot");
     using namespace collision_detector;
-    std::list<Dog>& dogs = session.GetDogs();
-    const std::list<Loot>& all_loots = session.GetLootObjects();
+    const std::vector<Dog*>& dogs = session.GetMovingDogs();
+    const GameSession::LootObjects& all_loots = session.GetLootObjects();
     int max_bag_capacity = session.GetMap()->GetBagCapacity();
     const std::deque<Office>& offices = session.GetMap()->GetOffices();
 
-    /* Провайдер для предоставления событий при подборе предметов*/
-    detail::ObjectsAndDogsProvider loots_provider(detail::MakeLoot(all_loots), detail::MakeDogs(dogs, delta));
+    /* Временные векторы тика берутся из арены и освобождаются разом в конце тика */
+    std::pmr::memory_resource* memory = tick_arena_->Resource();
+    const auto gatherers = detail::MakeDogs(dogs, delta, memory);
+    const auto loot_items = detail::MakeLoot(all_loots, memory);
+    const auto office_items = detail::MakeOffices(offices, memory);
+
+    /* События подбора предметов и доставки в офис; собаки одни и те же */
+    auto events = detail::MixEvents(FindGatherEvents(loot_items, gatherers, memory),
+                                    FindGatherEvents(office_items, gatherers, memory), memory);
+    if(events.empty()){
+        return;
+    }
 
-    /* Провайдер для предоставления событий при доставке в офис */
-    detail::ObjectsAndDogsProvider offices_provider(detail::MakeOffices(offices), detail::MakeDogs(dogs, delta));
-    auto events = detail::MixEvents(FindGatherEvents(loots_provider), FindGatherEvents(offices_provider));
-    std::set<size_t> collected_loot;
+    std::pmr::vector<bool> collected_slots(all_loots.size(), false, memory);
+    std::pmr::vector<int> collected_loot{memory};
     for(const auto& [event, event_type] : events){
-        auto dog_it = std::next(dogs.begin(), event.gatherer_id);
-        Dog& dog = *dog_it;
+        /* Индексы событий - позиции в списке движущихся собак и в хранилище трофеев */
+        Dog& dog = *dogs[event.gatherer_id];
         switch (event_type){
             case detail::GatheringEventType::DOG_COLLECT_ITEM:
                 // Собака подбирает предмет
                 // если её рюкзак не полон
                 if((*dog.GetBag()).size() < max_bag_capacity){
                     // если до этого этот предмет не подбирали
-                    if(!collected_loot.count(event.item_id)){
-                        auto loot_it = std::next(all_loots.begin(), event.item_id);
-                        const Loot& loot = *loot_it;
+                    if(!collected_slots[event.item_id]){
+                        const Loot& loot = all_loots[event.item_id];
                         dog.CollectItem(loot);
-                        collected_loot.insert(event.item_id);
+                        collected_slots[event.item_id] = true;
+                        collected_loot.push_back(loot.id);
                     }
                 }
                 break;
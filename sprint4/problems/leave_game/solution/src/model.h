@@ -9,19 +9,25 @@
 #include <vector>
 #include <deque>
 #include <list>
+#include <memory>
 #include <iostream>
+#include <limits>
 #include <optional>
-#include <boost/signals2.hpp>
+#include <span>
 
 #include "geom.h"
 #include "tagged.h"
+#include "interned_id.h"
 #include "loot_generator.h"
 #include "collision_detector.h"
+#include "random.h"
+#include "slot_map.h"
+#include "static_vector.h"
+#include "tick_arena.h"
+#include "spatial_grid.h"
 
 namespace model {
 
-namespace sig = boost::signals2;
-    
 namespace detail{
 
 using Milliseconds = std::chrono::milliseconds;
@@ -47,6 +53,14 @@ struct Loot{
     int type;
     int value;
     PairDouble pos;
+
+    bool operator==(const Loot&) const = default;
+};
+
+struct LootIdOf{
+    int operator()(const Loot& loot) const{
+        return loot.id;
+    }
 };
 
 
@@ -123,7 +137,7 @@ private:
 
 class Office {
 public:
-    using Id = util::Tagged<std::string, Office>;
+    using Id = util::InternedId<Office>;
 
     Office(Id id, Point position, Offset offset) noexcept
         : id_{std::move(id)}
@@ -161,13 +175,33 @@ struct LootType{
 
 
 
+class Dog;
+class GameSession;
+
+/*
+    Наблюдатель за подвижностью собаки. Вызывается напрямую, без выделения памяти,
+    и только когда собака останавливается или трогается с места,
+    а не при каждой установке скорости.
+*/
+class DogActivityListener{
+public:
+    virtual void OnDogStopped(const Dog& dog) = 0;
+    virtual void OnDogStartedMoving(const Dog& dog) = 0;
+protected:
+    ~DogActivityListener() = default;
+};
+
 class Dog{
 public:
     using Name = util::Tagged<std::string, Dog>;
     using Position = util::Tagged<PairDouble, Dog>;
     using Speed = util::Tagged<PairDouble, Dog>;
-    using SpeedSignal = sig::signal<void(Speed new_speed)>;
-    using Bag = util::Tagged<std::deque<Loot>, Dog>;
+    /* Верхняя граница bagCapacity в конфигурации: рюкзак лежит внутри собаки, без кучи */
+    static constexpr size_t MAX_BAG_CAPACITY = 16;
+    using Bag = util::Tagged<util::StaticVector<Loot, MAX_BAG_CAPACITY>, Dog>;
+
+    /* Вместимость вне [0, MAX_BAG_CAPACITY] - std::invalid_argument: иначе переполнится Bag */
+    static int CheckBagCapacity(int capacity);
 
     Dog(int id, Name name, Position pos, Speed speed, Direction dir) noexcept
         : id_(id), name_(name)
@@ -191,13 +225,15 @@ public:
         return pos_;
     }
 
-    void SetSlotSpeed(const SpeedSignal::slot_type& slot) const{
-        speed_signal_.connect(slot);
+    /* Один наблюдатель на собаку; nullptr отключает уведомления */
+    void SetActivityListener(DogActivityListener* listener){
+        activity_listener_ = listener;
     }
 
-    void SetSpeed(const Speed& new_speed){
-        speed_signal_(new_speed);
-        speed_ = new_speed;
+    void SetSpeed(const Speed& new_speed);
+
+    bool IsStopped() const{
+        return (*speed_).x == 0 && (*speed_).y == 0;
     }
 
     const Speed& GetSpeed() const{
@@ -229,11 +265,11 @@ public:
      score_ = std::accumulate(
         bag_.get().begin(), bag_.get().end(), 0,
         [](int sum, const Loot &loot) { return sum + loot.value; });
-        (*bag_).resize(0);
+        (*bag_).clear();
     }
 
     void SetBagCapacity(int new_bag_capacity){
-        bag_capacity_ = new_bag_capacity;
+        bag_capacity_ = CheckBagCapacity(new_bag_capacity);
     }
 
     int GetBagCapacity() const{
@@ -256,7 +292,11 @@ private:
     Name name_;
     Position pos_;
     Speed speed_;
-    mutable SpeedSignal speed_signal_;
+    DogActivityListener* activity_listener_ = nullptr;
+    /* Сессия, в списке движущихся собак которой стоит собака, и позиция в этом списке */
+    friend GameSession;
+    GameSession* session_ = nullptr;
+    size_t moving_slot_ = 0;
     Direction dir_;
     Bag bag_;
     int bag_capacity_ = 0;
@@ -265,7 +305,8 @@ private:
 
 class Map {
 public:
-    using Id = util::Tagged<std::string, Map>;
+    /* Имя карты интернируется при загрузке; внутри игры карты сравниваются по номеру */
+    using Id = util::InternedId<Map>;
     enum class RoadTag{
         VERTICAL,
         HORIZONTAl
@@ -277,6 +318,8 @@ public:
     using Buildings = std::deque<Building>;
     using Offices = std::deque<Office>;
     using LootTypes = std::deque<LootType>;
+    /* Точка лежит не больше чем на двух вертикальных и двух горизонтальных дорогах */
+    using RoadsNearby = util::StaticVector<const Road*, 4>;
 
     Map(Id id, std::string name) noexcept
         : id_(std::move(id))
@@ -299,7 +342,7 @@ public:
 
     void AddRoad(const Road& road);
 
-    std::vector<const Road*> FindRoadsByCoords(const Dog::Position& pos) const;
+    RoadsNearby FindRoadsByCoords(const Dog::Position& pos) const;
 
     void AddBuilding(const Building& building);
 
@@ -315,34 +358,39 @@ public:
 
     int GetBagCapacity() const;
 
-    static PairDouble GetFirstPos(const model::Map::Roads& roads);
+    /* 0 - без ограничения */
+    void SetMaxPlayersPerSession(size_t max_players);
 
-    static PairDouble GetRandomPos(const model::Map::Roads& roads);
-private:
-    static int GetRandomNumber(int first, int second){
-        std::minstd_rand generator(static_cast<unsigned>(
-            std::chrono::system_clock::now().time_since_epoch().count()));
+    size_t GetMaxPlayersPerSession() const;
 
-        std::uniform_int_distribution<int> distribution(first, second);
+    /* Радиус области интереса игрока в ответе о состоянии; 0 - видна вся сессия */
+    void SetInterestRadius(double radius);
 
-        double random_number = distribution(generator);
+    double GetInterestRadius() const;
 
-        return random_number;
-    }
+    static PairDouble GetFirstPos(const model::Map::Roads& roads);
 
-    using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::TaggedHasher<Office::Id>>;
+    /*
+        Равномерно распределённая точка на всей дорожной сети: дорога выбирается
+        с вероятностью, пропорциональной длине, бинарным поиском по префиксным суммам.
+    */
+    PairDouble GetRandomPos() const;
+private:
+    using OfficeIdToIndex = std::unordered_map<Office::Id, size_t, util::InternedIdHasher<Office::Id>>;
 
     /* Поиск вертикальных дорог по x координате*/
-    void FindInVerticals(const Dog::Position& pos, std::vector<const Road*>& roads) const;
+    void FindInVerticals(const Dog::Position& pos, RoadsNearby& roads) const;
 
     /* Поиск горизонтальных дорог по y координате*/
-    void FindInHorizontals(const Dog::Position& pos, std::vector<const Road*>& roads) const;
+    void FindInHorizontals(const Dog::Position& pos, RoadsNearby& roads) const;
 
     bool CheckBounds(ConstRoadIt it, const Dog::Position& pos) const;
 
     Id id_;
     std::string name_;
     Roads roads_;
+    /* road_length_prefix_[i] - суммарная длина дорог с 0 по i включительно */
+    std::vector<double> road_length_prefix_;
     RoadMap road_map_;
     Buildings buildings_;
     LootTypes loot_types_;
@@ -351,14 +399,24 @@ private:
     Offices offices_;
     double dog_speed_ = 0;
     int bag_capacity_;
+    size_t max_players_per_session_ = 0;
+    double interest_radius_ = 0;
 };
 
 class GameSession{
 public:
-    explicit GameSession(const Map* map)
-        : map_(map){
+    /* Трофеи лежат плотно; позиция в обходе совпадает с индексом предмета для детектора столкновений */
+    using LootObjects = util::SlotMap<Loot, int, LootIdOf>;
+
+    /* Сессия держит свою версию карты: после перезагрузки конфигурации она доигрывается на старой */
+    explicit GameSession(std::shared_ptr<const Map> map)
+        : map_(std::move(map)){
     }
 
+    /* Собаки ссылаются на сессию, а список движущихся собак - на собак */
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
     Dog* AddDog(int id, const Dog::Name& name, const Dog::Position& pos, const Dog::Speed& vel, Direction dir);
 
     Dog* AddCreatedDog(Dog new_dog);
@@ -371,35 +429,101 @@ public:
 
     void UpdateLoot(int loot_count);
 
-    void SetLootObjects(std::list<Loot> new_loot);
+    /* Восстановление из снимка: следующий трофей получит id больше всех загруженных */
+    void SetLootObjects(const std::list<Loot>& new_loot);
 
-    const std::list<Loot>& GetLootObjects() const;
+    const LootObjects& GetLootObjects() const;
 
-    void DeleteCollectedLoot(const std::set<size_t>& collected_items);
+    void DeleteCollectedLoot(std::span<const int> collected_ids);
 
     void DeleteDog(const Dog* erasing_dog);
+
+    /* Собаки с ненулевой скоростью: только они перемещаются и вызывают события сбора */
+    const std::vector<Dog*>& GetMovingDogs() const;
+
+    /* Пересобирает сетку области интереса, если состав или позиции объектов изменились */
+    void UpdateInterestGrid() const;
+
+    /* Объекты не дальше radius от center; выходные векторы очищаются */
+    void FindDogsInRadius(PairDouble center, double radius, std::vector<const Dog*>& dogs) const;
+
+    void FindLootInRadius(PairDouble center, double radius, std::vector<const Loot*>& loot) const;
 private:
+    friend Dog;
+    friend class Game;
+
+    Dog* AttachDog(Dog& dog);
+
+    void OnDogMovementChanged(Dog& dog);
+
+    void AddMovingDog(Dog& dog);
+
+    void RemoveMovingDog(Dog& dog);
+
     int auto_loot_counter_ = 0;
-    std::list<Loot> loot_;
+    LootObjects loot_;
     std::list<Dog> dogs_;
-    const Map* map_;
+    std::vector<Dog*> moving_dogs_;
+    std::shared_ptr<const Map> map_;
+
+    /*
+        Сетка - кэш, производный от собак и трофеев: пересобирается в конце тика,
+        а изменения между тиками (вход игрока, новые трофеи) учитываются при первом запросе
+    */
+    mutable SpatialGrid<const Dog*> dogs_grid_;
+    mutable SpatialGrid<int> loot_grid_;
+    mutable bool interest_grid_dirty_ = true;
+};
+
+/*
+    Выбор сессии для нового игрока среди неполных сессий карты:
+    FILL - самая старая неполная сессия, новые открываются, когда все заполнены;
+    LEAST_LOADED - сессия с наименьшим числом собак.
+*/
+enum class SessionPlacement{
+    FILL,
+    LEAST_LOADED
 };
 
 class Game {
 public:
-    using MapIdHasher = util::TaggedHasher<Map::Id>;
-    using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
-    using SessionsByMapId = std::unordered_map<Map::Id, std::deque<GameSession>, MapIdHasher>;
+    using MapIdHasher = util::InternedIdHasher<Map::Id>;
+    /* Позиция карты в Maps по номеру её id; NO_MAP - карты с таким id в версии нет */
+    using MapIdToIndex = std::vector<size_t>;
+    static constexpr size_t NO_MAP = std::numeric_limits<size_t>::max();
+    /* list: пустые сессии удаляются, а указатели на остальные должны оставаться действительными */
+    using SessionsByMapId = std::unordered_map<Map::Id, std::list<GameSession>, MapIdHasher>;
     using Maps = std::deque<Map>;
 
+    /*
+        Набор карт одной версии конфигурации. Сессии ссылаются на карты своей
+        версии через shared_ptr, поэтому версия освобождается, когда
+        опустеет последняя сессия, созданная до перезагрузки.
+    */
+    struct MapVersion {
+        Maps maps;
+        MapIdToIndex index;
+    };
+
     void AddMap(Map&& map);
 
+    /*
+        Подменяет карты картами loaded (вызывается внутри strand). Новые игроки
+        попадают в сессии новой версии; сессии старой версии больше не
+        пополняются и удаляются, когда из них уйдут все собаки.
+        Возвращает прежнюю версию, чтобы её освобождение можно было вынести из strand.
+    */
+    std::shared_ptr<const MapVersion> ReplaceMaps(const Game& loaded);
+
     GameSession* AddSession(const Map::Id& map_id);
 
-    GameSession* SessionIsExists(const Map::Id& map_id);
+    /* Сессия для нового игрока по политике размещения; если все сессии карты заполнены, открывается новая */
+    GameSession* FindSessionForNewDog(const Map::Id& map_id);
 
     const SessionsByMapId& GetAllSessions() const;
 
+    SessionsByMapId& GetAllSessions();
+
     void SetLootGenerator(double period, double probability);
 
     void SetDefaultDogSpeed(double new_speed);
@@ -413,6 +537,20 @@ public:
     void SetDogRetirementTime(int dog_retirement_time);
     
     int GetDogRetirementTime() const;
+
+    /* Значение по умолчанию для карт; 0 - без ограничения */
+    void SetMaxPlayersPerSession(size_t max_players);
+
+    size_t GetMaxPlayersPerSession() const;
+
+    void SetSessionPlacement(SessionPlacement placement);
+
+    SessionPlacement GetSessionPlacement() const;
+
+    /* Значение по умолчанию для карт; 0 - область интереса не ограничена */
+    void SetInterestRadius(double radius);
+
+    double GetInterestRadius() const;
     
     const Maps& GetMaps() const noexcept;
 
@@ -422,26 +560,38 @@ public:
 
     void GenerateLootInSessions(detail::Milliseconds delta);
 
+    /* Временные контейнеры тика живут в арене, которая освобождается в конце вызова */
     void UpdateGameState(int delta);
 
+    /* Счётчики арены последнего тика; heap_allocations == 0 - тик прошёл без обращений к куче */
+    const util::TickArena::Stats& GetTickArenaStats() const;
+
+    /* Сессия, в которой не осталось собак, удаляется */
     void DisconnectDogFromSession(const GameSession* player_session, const Dog* erasing_dog);
 private:
-    void UpdateAllDogsPositions(std::list<Dog>& dogs, const Map* map, double delta);
+    void UpdateAllDogsPositions(const std::vector<Dog*>& moving_dogs, const Map* map, double delta);
 
-    void UpdateDogPos(Dog& dog, const std::vector<const Road*>& roads, double delta);
+    void UpdateDogPos(Dog& dog, const Map::RoadsNearby& roads, double delta);
 
     void UpdateDogsLoot(GameSession& session, double delta);
 
     static bool IsInsideRoad(const PairDouble& getting_pos, const Point& start, const Point& end);
 
-    Maps maps_;
+    /* Ссылка на карту, продлевающая жизнь всей её версии */
+    std::shared_ptr<const Map> ShareMap(const Map* map) const;
+
+    std::shared_ptr<MapVersion> maps_ = std::make_shared<MapVersion>();
     SessionsByMapId map_id_to_sessions_;
-    MapIdToIndex map_id_to_index_;
     std::optional<loot_gen::LootGenerator> loot_generator_;
     double default_dog_speed_ = 1.0;
     double default_bag_capacity_ = 3;
     static constexpr double road_offset_ = 0.4;
     int dog_retirement_time_ = 60;
+    size_t max_players_per_session_ = 0;
+    SessionPlacement session_placement_ = SessionPlacement::FILL;
+    double interest_radius_ = 0;
+    /* unique_ptr: арена неперемещаема, а Game возвращается из загрузчика по значению */
+    std::unique_ptr<util::TickArena> tick_arena_ = std::make_unique<util::TickArena>();
 };
 
 }  // namespace model
\ No newline at end of file
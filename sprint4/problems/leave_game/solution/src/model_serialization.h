@@ -5,6 +5,7 @@
 #include <boost/serialization/deque.hpp>
 #include <boost/serialization/list.hpp>
 #include <boost/serialization/unordered_map.hpp>
+#include <boost/serialization/version.hpp>
 
 
 #include "players.h"
@@ -25,11 +26,6 @@ void serialize(Archive& ar, Loot& obj, [[maybe_unused]] const unsigned version)
     ar&(obj.pos);
 }
 
-template <typename Archive>
-void serialize(Archive& ar, Map::Id& map_id, [[maybe_unused]] const int version) {
-    ar&(*map_id);
-}
-
 }  // namespace model
 
 namespace serialization {
@@ -79,7 +75,8 @@ public:
         , speed_(*(dog.GetSpeed()))
         , direction_(dog.GetDirection())
         , score_(dog.GetScore())
-        , bag_(*(dog.GetBag()))
+        , bag_((*dog.GetBag()).begin(), (*dog.GetBag()).end())
+        , bag_capacity_(dog.GetBagCapacity())
         , player_repr_(){
     }
 
@@ -93,11 +90,17 @@ public:
 
     [[nodiscard]] Dog Restore() const {
         Dog dog(id_, Dog::Name(name_), Dog::Position(pos_), Dog::Speed(speed_), direction_);
+        dog.SetScore(score_);
+        dog.SetBagCapacity(bag_capacity_);
+        for (const Loot& loot : bag_) {
+            dog.CollectItem(loot);
+        }
         return dog;
     }
 
+    // Версия 1 добавила вместимость рюкзака; в снимках версии 0 её нет, остаётся 0
     template <typename Archive>
-    void serialize(Archive& ar, [[maybe_unused]] const int version) {
+    void serialize(Archive& ar, const unsigned version) {
         ar& id_;
         ar& name_;
         ar& pos_;
@@ -106,6 +109,9 @@ public:
         ar& score_;
         ar& bag_;
         ar& player_repr_;
+        if (version >= 1) {
+            ar& bag_capacity_;
+        }
     }
 
 private:
@@ -116,6 +122,7 @@ private:
     Direction direction_ = Direction::NORTH;
     int score_ = 0;
     std::deque<Loot> bag_;
+    int bag_capacity_ = 0;
     PlayerRepr player_repr_;
 };
 
@@ -157,25 +164,25 @@ public:
 
     GameStateRepr(const Game::SessionsByMapId& sessions_by_map, const players::Players& players){
         for(const auto& [map_id, sessions] : sessions_by_map){
-            std::list<Loot> loot;
-            std::list<DogRepr> dogs_repr;
+            // Каждая сессия сохраняется отдельно: при восстановлении игроки не должны оказаться в одной
             for(const auto& session : sessions){
-                loot = session.GetLootObjects();
+                std::list<Loot> loot(session.GetLootObjects().begin(), session.GetLootObjects().end());
+                std::list<DogRepr> dogs_repr;
                 for(const auto& dog : session.GetDogs()){
                     dogs_repr.emplace_back(DogRepr(dog));
 
-                    players::SharedPlayer player = players.FindByDogIdAndMapId(dog.GetId(), *map_id);
+                    players::SharedPlayer player = players.FindByDogIdAndMapId(dog.GetId(), map_id);
                     players::Token token = players.FindByPlayer(player);
                     PlayerRepr player_repr(player, token);
                     dogs_repr.back().AddPlayerRepr(player_repr);
                 }
-            }
 
-            SessionRepr session_repr;
-            session_repr.AddLoots(loot);
-            session_repr.AddDogsRepr(dogs_repr);
+                SessionRepr session_repr;
+                session_repr.AddLoots(loot);
+                session_repr.AddDogsRepr(std::move(dogs_repr));
 
-            all_sessions_[*map_id].emplace_back(std::move(session_repr));
+                all_sessions_[*map_id].emplace_back(std::move(session_repr));
+            }
         }
     }
 
@@ -192,4 +199,6 @@ private:
     SessionsByMapId all_sessions_;
 };
 
-}  // namespace serialization
\ No newline at end of file
+}  // namespace serialization
+
+BOOST_CLASS_VERSION(::serialization::DogRepr, 1)
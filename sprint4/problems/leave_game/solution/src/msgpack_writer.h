@@ -0,0 +1,124 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace msgpack {
+
+/**
+ * Минимальный кодировщик MessagePack (https://msgpack.org/) в std::string.
+ * Поддерживает то, что нужно ответам сервера: словари, массивы, строки,
+ * целые, double и nil. Целые кодируются в самой короткой форме,
+ * многобайтные значения - в сетевом порядке байт, как требует формат.
+ */
+class Writer {
+public:
+    explicit Writer(std::string& out) : out_(out) {
+    }
+
+    void MapHeader(uint32_t size) {
+        if (size < 16) {
+            Byte(0x80 | size);
+        } else if (size <= UINT16_MAX) {
+            Byte(0xde);
+            BigEndian(static_cast<uint16_t>(size));
+        } else {
+            Byte(0xdf);
+            BigEndian(size);
+        }
+    }
+
+    void ArrayHeader(uint32_t size) {
+        if (size < 16) {
+            Byte(0x90 | size);
+        } else if (size <= UINT16_MAX) {
+            Byte(0xdc);
+            BigEndian(static_cast<uint16_t>(size));
+        } else {
+            Byte(0xdd);
+            BigEndian(size);
+        }
+    }
+
+    void String(std::string_view str) {
+        const size_t size = str.size();
+        if (size < 32) {
+            Byte(0xa0 | size);
+        } else if (size <= UINT8_MAX) {
+            Byte(0xd9);
+            Byte(size);
+        } else if (size <= UINT16_MAX) {
+            Byte(0xda);
+            BigEndian(static_cast<uint16_t>(size));
+        } else {
+            Byte(0xdb);
+            BigEndian(static_cast<uint32_t>(size));
+        }
+        out_.append(str);
+    }
+
+    void Int(int64_t value) {
+        if (value >= 0) {
+            UInt(static_cast<uint64_t>(value));
+        } else if (value >= -32) {
+            Byte(static_cast<uint8_t>(value));
+        } else if (value >= INT8_MIN) {
+            Byte(0xd0);
+            Byte(static_cast<uint8_t>(value));
+        } else if (value >= INT16_MIN) {
+            Byte(0xd1);
+            BigEndian(static_cast<uint16_t>(value));
+        } else if (value >= INT32_MIN) {
+            Byte(0xd2);
+            BigEndian(static_cast<uint32_t>(value));
+        } else {
+            Byte(0xd3);
+            BigEndian(static_cast<uint64_t>(value));
+        }
+    }
+
+    void UInt(uint64_t value) {
+        if (value < 128) {
+            Byte(value);
+        } else if (value <= UINT8_MAX) {
+            Byte(0xcc);
+            Byte(value);
+        } else if (value <= UINT16_MAX) {
+            Byte(0xcd);
+            BigEndian(static_cast<uint16_t>(value));
+        } else if (value <= UINT32_MAX) {
+            Byte(0xce);
+            BigEndian(static_cast<uint32_t>(value));
+        } else {
+            Byte(0xcf);
+            BigEndian(value);
+        }
+    }
+
+    /* float 64: координаты передаются без потери точности, как в JSON */
+    void Double(double value) {
+        Byte(0xcb);
+        BigEndian(std::bit_cast<uint64_t>(value));
+    }
+
+    void Nil() {
+        Byte(0xc0);
+    }
+
+private:
+    void Byte(uint64_t byte) {
+        out_.push_back(static_cast<char>(static_cast<uint8_t>(byte)));
+    }
+
+    template <typename UInt>
+    void BigEndian(UInt value) {
+        for (int shift = (sizeof(UInt) - 1) * 8; shift >= 0; shift -= 8) {
+            Byte(static_cast<uint8_t>(value >> shift));
+        }
+    }
+
+    std::string& out_;
+};
+
+}  // namespace msgpack
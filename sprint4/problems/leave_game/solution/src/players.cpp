@@ -1,16 +1,16 @@
 #include "players.h"
 #include <cstddef>
+#include <cstdint>
 #include <exception>
 #include <stdexcept>
 
 namespace players {
 
 size_t Players::DogMapKeyHasher::operator()(const DogMapId &value) const {
-  size_t x = static_cast<size_t>(value.first);
-  size_t y = util::TaggedHasher<Map::Id>()(value.second);
-
-  // Для уменьшения коллизий значения x и y умножаются на 2
-  return x * 2 + y * 2 * 2;
+  // Номер карты и id собаки занимают разные половины 64-битного ключа
+  uint64_t key = (static_cast<uint64_t>(value.second.GetIndex()) << 32) |
+                 static_cast<uint32_t>(value.first);
+  return std::hash<uint64_t>{}(key);
 }
 
 std::pair<Token, SharedPlayer>
@@ -31,9 +31,9 @@ Players::AddPlayer(int id, const std::string &name, Dog *dog,
 }
 
 SharedPlayer Players::FindByDogIdAndMapId(int dog_id,
-                                                     std::string map_id) const {
+                                          const Map::Id &map_id) const {
   try {
-    return dog_map_players_.at(DogMapId(std::make_pair(dog_id, map_id)));
+    return dog_map_players_.at(DogMapId(dog_id, map_id));
   } catch (std::exception &ex) {
     std::cerr << ex.what() << std::endl;
     return nullptr;
@@ -95,6 +95,13 @@ void Players::DeletePlayer(const SharedPlayer erasing_player) {
                                         return player == erasing_player;});
 
     players_in_session.erase(session_it);
+    // Опустевшая сессия удаляется из игры, поэтому её ключ здесь больше не нужен
+    if (players_in_session.empty()) {
+      session_players_.erase(erasing_player->GetGameSession());
+    }
+
+    dog_map_players_.erase(DogMapId(erasing_player->GetDog()->GetId(),
+                                    erasing_player->GetGameSession()->GetMap()->GetId()));
 }
 
 } // namespace players
\ No newline at end of file
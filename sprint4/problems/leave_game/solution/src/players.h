@@ -32,10 +32,6 @@ public:
 
   const GameSession *GetGameSession() const { return session_; }
 
-  void SetPlayerTimeClock(const Dog::SpeedSignal::slot_type& slot) const {
-        dog_->SetSlotSpeed(slot);
-    }
-
 private:
   friend Players;
 
@@ -66,7 +62,7 @@ public:
   std::pair<Token, SharedPlayer>
   AddPlayer(int id, const std::string &name, Dog *dog, const GameSession *session);
 
-  SharedPlayer FindByDogIdAndMapId(int dog_id, std::string map_id) const;
+  SharedPlayer FindByDogIdAndMapId(int dog_id, const Map::Id &map_id) const;
 
   const SharedPlayer FindByToken(Token token);
   
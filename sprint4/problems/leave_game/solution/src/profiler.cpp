@@ -0,0 +1,306 @@
+#include "profiler.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <time.h>
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+namespace profiler {
+
+namespace {
+
+constexpr int MAX_DEPTH = 64;
+/* Первые кадры каждого стека - сам обработчик и трамплин возврата из сигнала */
+constexpr int SKIPPED_FRAMES = 2;
+/* Число уникальных стеков, степень двойки */
+constexpr size_t TABLE_SIZE = 1 << 14;
+constexpr size_t MAX_PROBES = 64;
+
+constexpr uint32_t SLOT_WRITING = 1;
+constexpr uint32_t SLOT_READY = 2;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "signal handler requires lock-free atomics");
+static_assert((TABLE_SIZE & (TABLE_SIZE - 1)) == 0);
+
+/* Ячейка открытой адресации: стек записывается один раз, повторные выборки увеличивают count */
+struct StackSlot {
+    std::atomic<uint64_t> hash{0};
+    std::atomic<uint32_t> state{0};
+    std::atomic<uint64_t> count{0};
+    int depth = 0;
+    void* frames[MAX_DEPTH];
+};
+
+struct ProfilerState {
+    std::mutex mutex;
+    bool handler_installed = false;
+    timer_t timer{};
+    /*
+        Таблица выделяется при первом запуске и больше не освобождается: сигнал,
+        доставленный после Stop, мог застать указатель, поэтому новый запуск
+        очищает ячейки на месте, дождавшись выхода всех обработчиков
+    */
+    std::unique_ptr<StackSlot[]> table;
+
+    std::atomic<StackSlot*> table_ptr{nullptr};
+    std::atomic<bool> running{false};
+    /* Обработчики, которые сейчас выполняются; увеличивается до проверки running */
+    std::atomic<uint32_t> in_flight{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> unique_stacks{0};
+};
+
+ProfilerState& GetState() {
+    static ProfilerState state;
+    return state;
+}
+
+uint64_t HashFrames(void* const* frames, int depth) noexcept {
+    uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < depth; ++i) {
+        hash ^= reinterpret_cast<uintptr_t>(frames[i]);
+        hash *= 1099511628211ull;
+    }
+    /* Ноль зарезервирован под пустую ячейку */
+    return hash == 0 ? 1 : hash;
+}
+
+void StoreSample(ProfilerState& state, StackSlot* table, void* const* frames, int depth) noexcept {
+    const uint64_t hash = HashFrames(frames, depth);
+    for (size_t probe = 0; probe < MAX_PROBES; ++probe) {
+        StackSlot& slot = table[(hash + probe) & (TABLE_SIZE - 1)];
+        uint64_t expected = 0;
+        if (slot.hash.compare_exchange_strong(expected, hash, std::memory_order_acq_rel)) {
+            slot.state.store(SLOT_WRITING, std::memory_order_relaxed);
+            slot.depth = depth;
+            std::memcpy(slot.frames, frames, sizeof(void*) * depth);
+            slot.state.store(SLOT_READY, std::memory_order_release);
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            state.unique_stacks.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (expected == hash) {
+            slot.count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    state.dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+/* Выполняется в контексте сигнала: только атомики, backtrace (прогрет в Start) и запись в готовую таблицу */
+void OnProfSignal(int, siginfo_t*, void*) {
+    ProfilerState& state = GetState();
+    /* seq_cst в паре с Start: либо Start дождётся этого обработчика, либо обработчик увидит running == false */
+    state.in_flight.fetch_add(1);
+    StackSlot* table = state.table_ptr.load(std::memory_order_acquire);
+    if (state.running.load() && table != nullptr) {
+        const int saved_errno = errno;
+        void* frames[MAX_DEPTH + SKIPPED_FRAMES];
+        const int depth = backtrace(frames, MAX_DEPTH + SKIPPED_FRAMES);
+        if (depth > SKIPPED_FRAMES) {
+            state.samples.fetch_add(1, std::memory_order_relaxed);
+            StoreSample(state, table, frames + SKIPPED_FRAMES, depth - SKIPPED_FRAMES);
+        }
+        errno = saved_errno;
+    }
+    state.in_flight.fetch_sub(1, std::memory_order_release);
+}
+
+/* Вызывается при остановленном сборе, когда ни один обработчик не пишет в таблицу */
+void ClearTable(StackSlot* table) noexcept {
+    for (size_t i = 0; i < TABLE_SIZE; ++i) {
+        table[i].hash.store(0, std::memory_order_relaxed);
+        table[i].state.store(0, std::memory_order_relaxed);
+        table[i].count.store(0, std::memory_order_relaxed);
+        table[i].depth = 0;
+    }
+}
+
+void InstallHandler(ProfilerState& state) {
+    if (state.handler_installed) {
+        return;
+    }
+    struct sigaction action {};
+    action.sa_sigaction = OnProfSignal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, nullptr) != 0) {
+        throw std::runtime_error("Failed to install SIGPROF handler: " + std::string(std::strerror(errno)));
+    }
+    state.handler_installed = true;
+}
+
+std::string Demangle(const char* name) {
+    int status = 0;
+    std::unique_ptr<char, decltype(&std::free)> demangled{
+        abi::__cxa_demangle(name, nullptr, nullptr, &status), &std::free};
+    return status == 0 && demangled ? std::string(demangled.get()) : std::string(name);
+}
+
+std::string Symbolize(void* address) {
+    Dl_info info{};
+    std::ostringstream out;
+    if (dladdr(address, &info) == 0) {
+        out << "[unknown+" << address << ']';
+        return out.str();
+    }
+    if (info.dli_sname != nullptr) {
+        return Demangle(info.dli_sname);
+    }
+    /* Символ не экспортирован (статическая функция или сборка без -rdynamic) */
+    std::string_view module = info.dli_fname != nullptr ? info.dli_fname : "unknown";
+    module = module.substr(module.find_last_of('/') + 1);
+    out << '[' << module << "+0x" << std::hex
+        << reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase) << ']';
+    return out.str();
+}
+
+} // namespace
+
+std::optional<unsigned> ParseFrequency(std::string_view text) noexcept {
+    unsigned frequency = 0;
+    const char* end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, frequency);
+    if (ec != std::errc{} || ptr != end || frequency == 0 || frequency > MAX_FREQUENCY_HZ) {
+        return std::nullopt;
+    }
+    return frequency;
+}
+
+bool Start(unsigned frequency_hz) {
+    if (frequency_hz == 0 || frequency_hz > MAX_FREQUENCY_HZ) {
+        throw std::invalid_argument("Profiler frequency must be in 1.." + std::to_string(MAX_FREQUENCY_HZ));
+    }
+    ProfilerState& state = GetState();
+    std::lock_guard lock{state.mutex};
+    if (state.running.load()) {
+        return false;
+    }
+
+    /* Первый вызов backtrace подгружает libgcc_s; в обработчике сигнала это делать нельзя */
+    void* warmup[1];
+    backtrace(warmup, 1);
+
+    /* Сигналы прошлого запуска могут ещё обрабатываться на других потоках */
+    while (state.in_flight.load() != 0) {
+        std::this_thread::yield();
+    }
+    if (!state.table) {
+        state.table = std::make_unique<StackSlot[]>(TABLE_SIZE);
+    } else {
+        ClearTable(state.table.get());
+    }
+    state.samples = 0;
+    state.dropped = 0;
+    state.unique_stacks = 0;
+    state.table_ptr.store(state.table.get(), std::memory_order_release);
+
+    InstallHandler(state);
+
+    sigevent event{};
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+    if (timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &state.timer) != 0) {
+        throw std::runtime_error("Failed to create profiling timer: " + std::string(std::strerror(errno)));
+    }
+
+    const long interval_ns = 1'000'000'000L / frequency_hz;
+    itimerspec spec{};
+    spec.it_interval.tv_sec = interval_ns / 1'000'000'000L;
+    spec.it_interval.tv_nsec = interval_ns % 1'000'000'000L;
+    spec.it_value = spec.it_interval;
+
+    state.running.store(true);
+    if (timer_settime(state.timer, 0, &spec, nullptr) != 0) {
+        state.running.store(false);
+        timer_delete(state.timer);
+        throw std::runtime_error("Failed to start profiling timer: " + std::string(std::strerror(errno)));
+    }
+    return true;
+}
+
+void Stop() {
+    ProfilerState& state = GetState();
+    std::lock_guard lock{state.mutex};
+    if (!state.running.load()) {
+        return;
+    }
+    /* Сигналы, пришедшие после сброса флага, игнорируются обработчиком */
+    state.running.store(false);
+    timer_delete(state.timer);
+}
+
+bool IsRunning() noexcept {
+    return GetState().running.load(std::memory_order_relaxed);
+}
+
+Stats GetStats() noexcept {
+    ProfilerState& state = GetState();
+    return {state.samples.load(std::memory_order_relaxed), state.dropped.load(std::memory_order_relaxed),
+            state.unique_stacks.load(std::memory_order_relaxed)};
+}
+
+std::string DumpCollapsed() {
+    ProfilerState& state = GetState();
+    std::lock_guard lock{state.mutex};
+    StackSlot* table = state.table_ptr.load(std::memory_order_acquire);
+    if (table == nullptr) {
+        return {};
+    }
+
+    /* Разные адреса внутри одной функции схлопываются в одну строку */
+    std::unordered_map<void*, std::string> symbols;
+    std::map<std::string, uint64_t> stacks;
+    for (size_t i = 0; i < TABLE_SIZE; ++i) {
+        const StackSlot& slot = table[i];
+        if (slot.state.load(std::memory_order_acquire) != SLOT_READY) {
+            continue;
+        }
+        const uint64_t count = slot.count.load(std::memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+
+        std::string line;
+        for (int frame = slot.depth - 1; frame >= 0; --frame) {
+            /* Кроме листа, адреса - это адреса возврата: отступаем внутрь инструкции вызова */
+            void* address = frame == 0 ? slot.frames[frame] : static_cast<char*>(slot.frames[frame]) - 1;
+            auto [it, inserted] = symbols.try_emplace(address);
+            if (inserted) {
+                it->second = Symbolize(address);
+            }
+            if (!line.empty()) {
+                line += ';';
+            }
+            line += it->second;
+        }
+        stacks[std::move(line)] += count;
+    }
+
+    std::string result;
+    for (const auto& [stack, count] : stacks) {
+        result += stack;
+        result += ' ';
+        result += std::to_string(count);
+        result += '\n';
+    }
+    return result;
+}
+
+} // namespace profiler
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace profiler {
+
+constexpr unsigned DEFAULT_FREQUENCY_HZ = 99;
+constexpr unsigned MAX_FREQUENCY_HZ = 1000;
+
+/*
+    Выборочный профилировщик процессорного времени.
+    Таймер timer_create(CLOCK_PROCESS_CPUTIME_ID) посылает процессу SIGPROF,
+    обработчик сигнала снимает стек прерванного потока через backtrace и
+    накапливает его в таблице фиксированного размера без блокировок и выделения памяти.
+*/
+
+/* Частота из параметра запроса: только десятичное число 1..MAX_FREQUENCY_HZ целиком, иначе nullopt */
+std::optional<unsigned> ParseFrequency(std::string_view text) noexcept;
+
+/* Запускает сбор стеков, предыдущие результаты сбрасываются. false, если сбор уже идёт */
+bool Start(unsigned frequency_hz = DEFAULT_FREQUENCY_HZ);
+
+/* Останавливает сбор, накопленные стеки остаются доступны для выгрузки */
+void Stop();
+
+bool IsRunning() noexcept;
+
+struct Stats {
+    uint64_t samples = 0;
+    /* Выборки, не поместившиеся в таблицу уникальных стеков */
+    uint64_t dropped = 0;
+    uint64_t unique_stacks = 0;
+};
+
+Stats GetStats() noexcept;
+
+/*
+    Стеки в формате collapsed: "корень;...;лист количество" по строке на стек,
+    который напрямую принимают flamegraph.pl и speedscope.
+*/
+std::string DumpCollapsed();
+
+} // namespace profiler
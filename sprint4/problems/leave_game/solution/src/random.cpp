@@ -0,0 +1,68 @@
+#include "random.h"
+
+#include <atomic>
+#include <random>
+#include <utility>
+
+namespace model {
+
+namespace {
+
+/* Зерно SetRandomSeed; поколение 0 - зерно не задавалось */
+std::atomic<uint64_t> seed_value{0};
+std::atomic<uint64_t> seed_generation{0};
+std::atomic<uint64_t> next_thread_index{0};
+
+struct ThreadRandom {
+    RandomEngine engine;
+    uint64_t generation = 0;
+
+    ThreadRandom() {
+        std::random_device device;
+        engine.Seed((static_cast<uint64_t>(device()) << 32) ^ device());
+    }
+};
+
+/* Множитель 128-битного произведения: равномерно по [0, size) без деления */
+uint64_t MultiplyHigh(uint64_t value, uint64_t size) noexcept {
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(value) * size) >> 64);
+}
+
+}  // namespace
+
+RandomEngine& GetRandomEngine() noexcept {
+    thread_local ThreadRandom random;
+    const uint64_t generation = seed_generation.load(std::memory_order_acquire);
+    if (generation != random.generation) {
+        random.generation = generation;
+        const uint64_t thread_index = next_thread_index.fetch_add(1, std::memory_order_relaxed);
+        random.engine.Seed(
+            RandomEngine::SplitMix64(seed_value.load(std::memory_order_relaxed), thread_index + 1));
+    }
+    return random.engine;
+}
+
+void SetRandomSeed(uint64_t seed) noexcept {
+    seed_value.store(seed, std::memory_order_relaxed);
+    next_thread_index.store(0, std::memory_order_relaxed);
+    seed_generation.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t RandomIndex(uint64_t size) noexcept {
+    return MultiplyHigh(GetRandomEngine()(), size);
+}
+
+int RandomInt(int first, int second) noexcept {
+    if (second < first) {
+        std::swap(first, second);
+    }
+    const uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(second) - first) + 1;
+    return static_cast<int>(first + static_cast<int64_t>(RandomIndex(range)));
+}
+
+double RandomDouble(double from, double to) noexcept {
+    const double unit = static_cast<double>(GetRandomEngine()() >> 11) * 0x1.0p-53;
+    return from + (to - from) * unit;
+}
+
+}  // namespace model
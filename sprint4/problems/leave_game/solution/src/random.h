@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+namespace model {
+
+/*
+    xoshiro256** (Blackman, Vigna): 256 бит состояния, генерация за несколько
+    сдвигов и умножение. Совместим с UniformRandomBitGenerator.
+*/
+class RandomEngine {
+public:
+    using result_type = uint64_t;
+
+    explicit RandomEngine(uint64_t seed = 0) noexcept {
+        Seed(seed);
+    }
+
+    /* Состояние раскладывается из одного числа через splitmix64, как рекомендуют авторы */
+    void Seed(uint64_t seed) noexcept {
+        for (uint64_t i = 0; i < 4; ++i) {
+            state_[i] = SplitMix64(seed, i + 1);
+        }
+    }
+
+    /* index-е (с единицы) число последовательности splitmix64, начатой с seed */
+    static constexpr uint64_t SplitMix64(uint64_t seed, uint64_t index) noexcept {
+        uint64_t z = seed + index * 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr result_type min() noexcept {
+        return 0;
+    }
+
+    static constexpr result_type max() noexcept {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() noexcept {
+        const uint64_t result = Rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = Rotl(state_[3], 45);
+        return result;
+    }
+
+private:
+    static constexpr uint64_t Rotl(uint64_t x, int k) noexcept {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t state_[4];
+};
+
+/*
+    У каждого потока свой генератор, поэтому синхронизация не нужна. Без явного зерна
+    он инициализируется из std::random_device. После SetRandomSeed поток при первом
+    обращении получает номер (0, 1, ... в порядке обращений) и генератор с зерном
+    SplitMix64(seed, номер + 1). Однопоточный прогон так полностью воспроизводим;
+    в пуле потоков номера зависят от того, какой поток первым выполнил вызов модели.
+*/
+RandomEngine& GetRandomEngine() noexcept;
+
+void SetRandomSeed(uint64_t seed) noexcept;
+
+/* Равномерное целое из [first, second] без std::uniform_int_distribution, чей алгоритм зависит от библиотеки */
+int RandomInt(int first, int second) noexcept;
+
+/* Равномерный индекс из [0, size) */
+uint64_t RandomIndex(uint64_t size) noexcept;
+
+/* Равномерное вещественное из [from, to) */
+double RandomDouble(double from, double to) noexcept;
+
+}  // namespace model
@@ -0,0 +1,187 @@
+#include "rate_limiter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+
+namespace http_handler {
+
+namespace {
+
+using namespace std::literals;
+
+constexpr std::string_view BEARER = "Bearer "sv;
+constexpr unsigned FINGERPRINT_SHIFT = 48;
+constexpr uint64_t TAT_MASK = (uint64_t{1} << FINGERPRINT_SHIFT) - 1;
+
+std::string_view RateClassName(RateClass rate_class) {
+  switch (rate_class) {
+  case RateClass::JOIN:
+    return "join"sv;
+  case RateClass::ACTION:
+    return "action"sv;
+  case RateClass::STATE:
+    return "state"sv;
+  case RateClass::READ:
+    return "read"sv;
+  default:
+    return "unknown"sv;
+  }
+}
+
+RateClass ClassifyRate(Route route) {
+  switch (route) {
+  case Route::JOIN:
+    return RateClass::JOIN;
+  case Route::ACTION:
+    return RateClass::ACTION;
+  case Route::STATE:
+    return RateClass::STATE;
+  case Route::MAPS:
+  case Route::MAP:
+  case Route::PLAYERS:
+  case Route::TICK:
+  case Route::RECORDS:
+  case Route::API_OTHER:
+    return RateClass::READ;
+  default:
+    return RateClass::COUNT;
+  }
+}
+
+double ParseNumber(std::string_view text, std::string_view spec) {
+  double value = 0;
+  const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc{} || end != text.data() + text.size() || !std::isfinite(value) ||
+      value < 0) {
+    throw std::invalid_argument("Invalid rate limit: "s + std::string(spec));
+  }
+  return value;
+}
+
+/* Хеш байтов адреса клиента */
+size_t AddressHash(const net::ip::address &remote) {
+  if (remote.is_v4()) {
+    const auto bytes = remote.to_v4().to_bytes();
+    return std::hash<std::string_view>{}(
+        std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size()));
+  }
+  const auto bytes = remote.to_v6().to_bytes();
+  return std::hash<std::string_view>{}(
+      std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size()));
+}
+
+} // namespace
+
+RateLimits ParseRateLimits(const std::vector<std::string> &specs) {
+  RateLimits limits{};
+  for (const std::string &spec : specs) {
+    const size_t eq = spec.find('=');
+    if (eq == std::string::npos) {
+      throw std::invalid_argument("Invalid rate limit: "s + spec);
+    }
+    const std::string_view name = std::string_view(spec).substr(0, eq);
+    std::string_view value = std::string_view(spec).substr(eq + 1);
+
+    size_t index = 0;
+    while (index < limits.size() && RateClassName(static_cast<RateClass>(index)) != name) {
+      ++index;
+    }
+    if (index == limits.size()) {
+      throw std::invalid_argument("Unknown rate limit class: "s + std::string(name));
+    }
+
+    RateLimit limit;
+    if (const size_t colon = value.find(':'); colon != std::string_view::npos) {
+      limit.burst = std::max(1u, static_cast<unsigned>(ParseNumber(value.substr(colon + 1), spec)));
+      value = value.substr(0, colon);
+    }
+    limit.rate = ParseNumber(value, spec);
+    limits[index] = limit;
+  }
+  return limits;
+}
+
+RateLimiter::RateLimiter(const RateLimits &limits, unsigned clients_per_address)
+    : start_(metrics::Clock::now()) {
+  static metrics::Family<metrics::Counter> &rejected = metrics::DefaultRegistry().AddCounter(
+      "game_http_requests_rate_limited_total",
+      "API requests rejected with 429 because the client exceeded its rate", {"class"});
+
+  clients_per_address = std::max(1u, clients_per_address);
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    const RateLimit &limit = limits[i];
+    if (limit.rate <= 0) {
+      continue;
+    }
+    Bucket &bucket = buckets_[i];
+    bucket.clients.interval = std::max<uint64_t>(1, static_cast<uint64_t>(1e6 / limit.rate));
+    bucket.clients.tolerance = bucket.clients.interval * (limit.burst - 1);
+    bucket.clients.slots = std::make_unique<std::atomic<uint64_t>[]>(SLOTS);
+
+    bucket.addresses.interval = std::max<uint64_t>(
+        1, static_cast<uint64_t>(1e6 / (limit.rate * clients_per_address)));
+    bucket.addresses.tolerance =
+        bucket.addresses.interval * (uint64_t{limit.burst} * clients_per_address - 1);
+    bucket.addresses.slots = std::make_unique<std::atomic<uint64_t>[]>(SLOTS);
+
+    bucket.rejected = &rejected.WithLabels(
+        {std::string(RateClassName(static_cast<RateClass>(i)))});
+    enabled_ = true;
+  }
+}
+
+uint64_t RateLimiter::NowMicros() const noexcept {
+  return std::chrono::duration_cast<std::chrono::microseconds>(metrics::Clock::now() - start_)
+      .count();
+}
+
+bool RateLimiter::Table::Take(uint64_t hash, uint64_t now) noexcept {
+  const uint64_t fingerprint = hash >> FINGERPRINT_SHIFT;
+  std::atomic<uint64_t> &slot = slots[hash & (SLOTS - 1)];
+
+  uint64_t current = slot.load(std::memory_order_relaxed);
+  while (true) {
+    // Слот чужого ключа считаем пустым: корзина клиента начинается заново
+    uint64_t tat = (current >> FINGERPRINT_SHIFT) == fingerprint ? current & TAT_MASK : 0;
+    tat = std::max(tat, now);
+    if (tat - now > tolerance) {
+      return false;
+    }
+    const uint64_t next = (fingerprint << FINGERPRINT_SHIFT) | ((tat + interval) & TAT_MASK);
+    if (slot.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+}
+
+bool RateLimiter::Allow(Route route, std::string_view authorization,
+                        const net::ip::address &remote) noexcept {
+  const RateClass rate_class = ClassifyRate(route);
+  if (!enabled_ || rate_class == RateClass::COUNT) {
+    return true;
+  }
+  Bucket &bucket = buckets_[static_cast<size_t>(rate_class)];
+  if (!bucket.clients.slots) {
+    return true;
+  }
+
+  const uint64_t now = NowMicros();
+  const uint64_t address_hash = AddressHash(remote);
+  bool allowed = false;
+  if (authorization.substr(0, BEARER.size()) == BEARER) {
+    // Запрос, отклонённый по токену, уже учтён в корзине адреса: это лишь ужесточает лимит
+    allowed = bucket.addresses.Take(address_hash, now) &&
+              bucket.clients.Take(std::hash<std::string_view>{}(authorization.substr(BEARER.size())), now);
+  } else {
+    allowed = bucket.clients.Take(address_hash, now);
+  }
+  if (!allowed) {
+    bucket.rejected->Increment();
+  }
+  return allowed;
+}
+
+} // namespace http_handler
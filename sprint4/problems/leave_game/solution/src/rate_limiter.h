@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <boost/asio/ip/address.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "metrics.h"
+#include "request_metrics.h"
+
+namespace http_handler {
+
+namespace net = boost::asio;
+
+/* Классы маршрутов API с независимыми лимитами */
+enum class RateClass {
+  JOIN,
+  ACTION,
+  STATE,
+  // Остальные запросы API: карты, игроки, рекорды, tick
+  READ,
+  COUNT
+};
+
+struct RateLimit {
+  // Запросов в секунду; 0 - без ограничения
+  double rate = 0;
+  // Сколько запросов подряд допускается сверх равномерного темпа
+  unsigned burst = 1;
+};
+
+using RateLimits = std::array<RateLimit, static_cast<size_t>(RateClass::COUNT)>;
+
+// Строки вида "state=20" или "state=20:40" (класс=запросов в секунду[:всплеск]).
+// Классы: join, action, state, read; иначе std::invalid_argument
+RateLimits ParseRateLimits(const std::vector<std::string> &specs);
+
+// Сколько игроков за одним адресом получают полный лимит, по умолчанию
+constexpr unsigned DEFAULT_CLIENTS_PER_ADDRESS = 8;
+
+/*
+    Ограничение частоты запросов каждого клиента. Клиент - токен игрока из
+    заголовка Authorization, а без него - адрес, с которого пришёл запрос.
+    Токен не проверяется до strand, поэтому запрос с токеном проходит ещё и
+    корзину своего адреса с лимитом в clients_per_address раз больше: иначе
+    новый случайный токен в каждом запросе обходил бы ограничение.
+    Корзина клиента реализована алгоритмом GCRA: вместо числа жетонов хранится
+    теоретическое время прихода следующего запроса, поэтому состояние помещается
+    в одно 64-битное слово и обновляется одной операцией CAS.
+    Для каждого класса заводится таблица фиксированного размера; ключ попадает
+    в слот по хешу, а 16-битный отпечаток отличает чужой ключ в том же слоте.
+    При коллизии корзина начинается заново, то есть ограничение ослабевает,
+    но запросы не отклоняются по ошибке.
+*/
+class RateLimiter {
+public:
+  explicit RateLimiter(const RateLimits &limits,
+                       unsigned clients_per_address = DEFAULT_CLIENTS_PER_ADDRESS);
+
+  bool Enabled() const noexcept { return enabled_; }
+
+  // true, если запрос укладывается в лимит своего класса
+  bool Allow(Route route, std::string_view authorization,
+             const net::ip::address &remote) noexcept;
+
+private:
+  static constexpr size_t SLOTS = 1 << 14;
+
+  struct Table {
+    // Интервал между запросами и допустимое опережение, в микросекундах
+    uint64_t interval = 0;
+    uint64_t tolerance = 0;
+    std::unique_ptr<std::atomic<uint64_t>[]> slots;
+
+    // Учитывает запрос ключа hash; false, если корзина ключа переполнена
+    bool Take(uint64_t hash, uint64_t now) noexcept;
+  };
+
+  struct Bucket {
+    // Корзины клиентов: токенов, а для запросов без токена - адресов
+    Table clients;
+    // Корзины адресов для запросов с токеном
+    Table addresses;
+    metrics::Counter *rejected = nullptr;
+  };
+
+  uint64_t NowMicros() const noexcept;
+
+  bool enabled_ = false;
+  metrics::Clock::time_point start_;
+  std::array<Bucket, static_cast<size_t>(RateClass::COUNT)> buckets_;
+};
+
+} // namespace http_handler
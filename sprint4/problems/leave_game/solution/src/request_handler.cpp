@@ -1,4 +1,5 @@
 #include "request_handler.h"
+#include "boost_logger.h"
 #include "json_loader.h"
 
 namespace http_handler
@@ -159,6 +160,33 @@ namespace http_handler
 
         return args;
     }
+    app::StateEncoding LogicHandler::ChooseStateEncoding(std::string_view accept)
+    {
+        // При равных весах (в том числе без заголовка и для */*) остаётся JSON
+        using http_compression::MediaTypeQuality;
+        const double msgpack = MediaTypeQuality(accept, {ContentType::MSGPACK, "application/x-msgpack"});
+        const double json = accept.empty() ? 1 : MediaTypeQuality(accept, {ContentType::JSON_HTML});
+        return msgpack > json ? app::StateEncoding::MSGPACK : app::StateEncoding::JSON;
+    }
+
+    void LogicHandler::CompressResponse(StringResponse &response, http_compression::Encoding encoding, int level)
+    {
+        response.body() = http_compression::Compress(response.body(), encoding, level);
+        response.content_length(response.body().size());
+        response.set(http::field::content_encoding, std::string(http_compression::EncodingName(encoding)));
+        AddVary(response, "Accept-Encoding");
+    }
+
+    void LogicHandler::AddVary(StringResponse &response, std::string_view field)
+    {
+        std::string vary(response[http::field::vary]);
+        if (!vary.empty()) {
+            vary += ", ";
+        }
+        vary += field;
+        response.set(http::field::vary, vary);
+    }
+
     /* ======================================= HandleApiRequest ======================================= */
 
     //Jбработка запроса для .../maps...
@@ -171,8 +199,9 @@ namespace http_handler
         }
         else if (StartWithStr(decoded, "/api/v1/maps/"))
         {
-            model::Map::Id map_id(decoded.substr(std::string("/api/v1/maps/").length()));
-            const model::Map* map = game.FindMap(map_id);
+            const std::optional<model::Map::Id> map_id =
+                model::Map::Id::Find(decoded.substr(std::string("/api/v1/maps/").length()));
+            const model::Map* map = map_id ? game.FindMap(*map_id) : nullptr;
             if(map != nullptr) {
                 std::string respons_body = json_loader::MapFullInfo(*map);
                 return std::make_pair(respons_body, true);
@@ -185,4 +214,41 @@ namespace http_handler
     }
 
     /* ======================================= HandleFileRequest ======================================= */
+
+    /* ======================================= RequestHandler ======================================= */
+    void RequestHandler::ReloadMaps(std::function<void(size_t maps, const std::string &error)> done)
+    {
+        // Разбор файла может длиться долго: поток контекста, на котором живут strand и тикеры,
+        // его не ждёт, в strand попадает только подмена карт
+        net::post(reload_pool_, [self = shared_from_this(), done = std::move(done),
+                                 worker = http_server::IoContextPool::Current()]() mutable {
+            std::shared_ptr<model::Game> loaded;
+            try
+            {
+                TRACE_SCOPE("RequestHandler::ReloadMaps");
+                loaded = std::make_shared<model::Game>(json_loader::LoadGame(self->config_path_));
+            }
+            catch (const std::exception &ex)
+            {
+                logger::LogError(0, ex.what(), "ReloadMaps");
+                return done(0, ex.what());
+            }
+
+            Strand &strand = self->api_handler.GetStrand();
+            net::dispatch(strand, [self = std::move(self), loaded = std::move(loaded), done = std::move(done),
+                                   worker]() mutable {
+                std::shared_ptr<const model::Game::MapVersion> previous = self->game_.ReplaceMaps(*loaded);
+                // Описания карт в кэше относятся к прежней версии
+                self->api_handler.map_payloads_.Clear();
+                const size_t maps = loaded->GetMaps().size();
+                logger::LogConfigReloaded(maps);
+
+                // Если на прежние карты не ссылается ни одна сессия, они освобождаются вне strand
+                net::io_context &home =
+                    worker ? *worker : self->api_handler.GetStrand().get_inner_executor().context();
+                net::post(home, [previous = std::move(previous), loaded = std::move(loaded)] {});
+                done(maps, std::string{});
+            });
+        });
+    }
 } // namespace http_handler
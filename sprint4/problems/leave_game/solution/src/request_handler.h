@@ -1,18 +1,30 @@
 #pragma once
 
+#include <boost/asio/thread_pool.hpp>
 #include <boost/json.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <array>
 #include <cassert>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <set>
 #include <string_view>
 #include <variant>
 
+#include "admission_control.h"
 #include "app.h"
+#include "http_compression.h"
+#include "io_context_pool.h"
+#include "metrics.h"
 #include "model.h"
+#include "request_metrics.h"
+#include "profiler.h"
+#include "rate_limiter.h"
 #include "request_struct.h"
+#include "tracing.h"
 
 namespace http_handler {
 
@@ -33,6 +45,19 @@ using Strand = net::strand<net::io_context::executor_type>;
 using Milliseconds = std::chrono::milliseconds;
 using DatabaseManagerPtr = std::unique_ptr<db_connection::DatabaseManager>;
 
+// Сессии принимают ответ по значению или общий неизменяемый ответ, который
+// отправляется многократно без копирования заголовков и тела
+template <typename Body, typename Fields>
+const http::response<Body, Fields> &ResponseMessage(const http::response<Body, Fields> &response) {
+  return response;
+}
+
+template <typename Body, typename Fields>
+const http::response<Body, Fields> &
+ResponseMessage(const std::shared_ptr<const http::response<Body, Fields>> &response) {
+  return *response;
+}
+
 class LogicHandler {
 public:
   static StringResponse MakeStringResponse(http::status status, std::string_view body,
@@ -96,10 +121,12 @@ static StringResponse ReportServerError(http::status status, std::string_view co
     constexpr static std::string_view TEXT_PLAIN = "text/plain"sv;
     constexpr static std::string_view TEXT_CSS = "text/css"sv;
     constexpr static std::string_view JSON_HTML = "application/json"sv;
+    constexpr static std::string_view MSGPACK = "application/msgpack"sv;
     constexpr static std::string_view APP_XML = "application/xml"sv;
     constexpr static std::string_view IMAGE_JPEG = "image/jpeg"sv;
     constexpr static std::string_view IMAGE_SVG = "image/svg+xml"sv;
     constexpr static std::string_view EMPTY = "application/octet-stream"sv;
+    constexpr static std::string_view PROMETHEUS = "text/plain; version=0.0.4"sv;
   };
 
   static std::string URLDecode(const std::string &encoded);
@@ -110,6 +137,24 @@ static StringResponse ReportServerError(http::status status, std::string_view co
   std::string_view GetContentType(const std::string &req_target);
   static std::string StatusCodeProcessing(int code);
   static std::unordered_map<std::string, std::string> ParseTargetArgs(std::string_view req);
+  static app::StateEncoding ChooseStateEncoding(std::string_view accept);
+
+  /* Кодировка для ответа: IDENTITY, если сжатие выключено, тело короче порога или уже сжато */
+  template <typename Request>
+  static http_compression::Encoding ResponseEncoding(const Request &req, const StringResponse &response,
+                                                     const http_compression::Settings &settings) {
+    if (!settings.enabled || response.body().size() < settings.min_size ||
+        response.find(http::field::content_encoding) != response.end()) {
+      return http_compression::Encoding::IDENTITY;
+    }
+    const boost::beast::string_view accept_encoding = req[http::field::accept_encoding];
+    return http_compression::ChooseEncoding(std::string_view(accept_encoding.data(), accept_encoding.size()));
+  }
+
+  static void CompressResponse(StringResponse &response, http_compression::Encoding encoding, int level);
+
+  /* Добавляет поле в Vary, сохраняя уже перечисленные */
+  static void AddVary(StringResponse &response, std::string_view field);
 
 
   static Milliseconds FromDouble(double tick) {
@@ -128,15 +173,20 @@ public:
                             std::optional<std::string> state_file, 
                             std::optional<double> tick_state_per, 
                             bool random_spawn, 
-                            DatabaseManagerPtr&& db_manager)
+                            DatabaseManagerPtr&& db_manager,
+                            http_compression::Settings compression)
       : app_(game, tick, state_file, tick_state_per, random_spawn, std::move(db_manager), api_strand),
-        ticker_(), loot_ticker_() {}
+        compression_(compression), ticker_(), loot_ticker_() {}
 
 private:
   friend class RequestHandler;
   int random_id = 1;
   app::Aplication app_;
 
+  http_compression::Settings compression_;
+  // Описания карт неизменны, поэтому тело и его сжатые варианты строятся один раз
+  http_compression::PayloadCache map_payloads_;
+
   std::shared_ptr<app::Ticker> ticker_;
   std::shared_ptr<app::Ticker> loot_ticker_;
 
@@ -194,14 +244,27 @@ Strand& GetStrand(){
               ContentType::JSON_HTML, "no-cache", "GET, HEAD");
         }
         
-        std::pair<std::string, bool> request = MapRequest(decoded, game);
-        if (request.second == false) {
-          return error_response(http::status::not_found, request.first,
-                                ContentType::JSON_HTML);
-        } else {
-          return text_response(http::status::ok, request.first,
-                               ContentType::JSON_HTML);
+        if (map_payloads_.Find(decoded, http_compression::Encoding::IDENTITY) == nullptr) {
+          std::pair<std::string, bool> request = MapRequest(decoded, game);
+          if (request.second == false) {
+            return error_response(http::status::not_found, request.first,
+                                  ContentType::JSON_HTML);
+          }
+          map_payloads_.Put(decoded, std::move(request.first));
+        }
+
+        const std::string &body =
+            *map_payloads_.Find(decoded, http_compression::Encoding::IDENTITY);
+        auto response = text_response(http::status::ok, body, ContentType::JSON_HTML);
+        if (const auto encoding = ResponseEncoding(req, response, compression_);
+            encoding != http_compression::Encoding::IDENTITY) {
+          response.body() = *map_payloads_.Find(decoded, encoding, compression_.level);
+          response.content_length(response.body().size());
+          response.set(http::field::content_encoding,
+                       std::string(http_compression::EncodingName(encoding)));
+          AddVary(response, "Accept-Encoding");
         }
+        return response;
       }
       /*---------------------------------------------------players---------------------------------------------------*/
       if (StartWithStr(decoded, "/api/v1/game/players")) {
@@ -312,9 +375,16 @@ Strand& GetStrand(){
           }
 
           if (app_.FindByToken(token)) {
-            std::string respons_body = app_.GetGameState(token);
-            return text_response(http::status::ok, respons_body,
-                                 ContentType::JSON_HTML, "no-cache");
+            const boost::beast::string_view accept = req[http::field::accept];
+            const app::StateEncoding encoding =
+                ChooseStateEncoding(std::string_view(accept.data(), accept.size()));
+            std::string respons_body = app_.GetGameState(token, encoding);
+            auto response = text_response(
+                http::status::ok, respons_body,
+                encoding == app::StateEncoding::MSGPACK ? ContentType::MSGPACK : ContentType::JSON_HTML,
+                "no-cache");
+            response.set(http::field::vary, "Accept");
+            return response;
           }
 
            json::object error_code;
@@ -360,7 +430,8 @@ Strand& GetStrand(){
                                   ContentType::JSON_HTML, "no-cache");
           }
           auto move_req = json::parse(req.body()).as_object();
-          if (!move_req.contains("move")) {
+          const json::string *move = move_req.contains("move") ? move_req.at("move").if_string() : nullptr;
+          if (move == nullptr || !app::GameStateUseCase::IsValidMove(std::string_view(move->data(), move->size()))) {
             json::object error_code;
             error_code["code"] = "invalidArgument";
             error_code["message"] = "Failed to parse action";
@@ -368,7 +439,7 @@ Strand& GetStrand(){
                                   json::serialize(error_code),
                                   ContentType::JSON_HTML, "no-cache");
           }
-          std::string move_dir = std::string(move_req.at("move").as_string());
+          std::string move_dir(move->data(), move->size());
 
           if (auto player = app_.FindByToken(token)) {
             std::string respons_body = app_.PlayerAction(player, move_dir);
@@ -526,26 +597,232 @@ private:
   fs::path static_path_root_;
 };
 
+// ---------------------------------------------- HandlerAdminRequest ---------------------------------------------- //
+
+/*
+    Служебные запросы /admin/... для диагностики работающего сервера.
+    Обрабатываются вне strand и доступны только при запуске с ключом --admin-api.
+*/
+class HandlerAdminRequest : public LogicHandler {
+public:
+  template <typename Request>
+  StringResponse AdminHandleRequest(const Request &req) {
+    const auto text_response = [&req](http::status status, std::string_view text,
+                                      std::string_view content_type) {
+      return MakeStringResponse(status, text, req.version(), req.keep_alive(),
+                                content_type, "no-cache");
+    };
+    const auto invalid_method = [&req](std::string_view allow) {
+      json::object error_code;
+      error_code["code"] = "invalidMethod";
+      error_code["message"] = "Invalid method";
+      return ReportServerError(http::status::method_not_allowed,
+                               json::serialize(error_code), req.version(),
+                               req.keep_alive(), ContentType::JSON_HTML,
+                               "no-cache", allow);
+    };
+
+    std::string decoded = URLDecode(std::string(req.target()));
+/*---------------------------------------------------trace---------------------------------------------------*/
+    if (decoded == "/admin/trace") {
+      if (req.method() != http::verb::get && req.method() != http::verb::head) {
+        return invalid_method("GET, HEAD");
+      }
+      return text_response(http::status::ok, tracing::DumpChromeTrace(),
+                           ContentType::JSON_HTML);
+    }
+    if (decoded == "/admin/trace/start" || decoded == "/admin/trace/stop") {
+      if (req.method() != http::verb::post) {
+        return invalid_method("POST");
+      }
+      const bool start = decoded == "/admin/trace/start";
+      if (start) {
+        tracing::Clear();
+      }
+      tracing::SetEnabled(start);
+      return text_response(http::status::ok, "{}", ContentType::JSON_HTML);
+    }
+/*--------------------------------------------------config---------------------------------------------------*/
+    // POST обрабатывает RequestHandler::ReloadMaps: ему нужен strand игры
+    if (decoded == "/admin/config/reload") {
+      return invalid_method("POST");
+    }
+/*--------------------------------------------------profile--------------------------------------------------*/
+    if (decoded == "/admin/profile") {
+      if (req.method() != http::verb::get && req.method() != http::verb::head) {
+        return invalid_method("GET, HEAD");
+      }
+      /* Свёрнутые стеки: flamegraph.pl profile.txt > profile.svg */
+      return text_response(http::status::ok, profiler::DumpCollapsed(),
+                           ContentType::TEXT_PLAIN);
+    }
+    // Путь без параметров сравнивается целиком: /admin/profile/started - неизвестный маршрут
+    if (decoded.compare(0, decoded.find('?'), "/admin/profile/start") == 0) {
+      if (req.method() != http::verb::post) {
+        return invalid_method("POST");
+      }
+      unsigned frequency = profiler::DEFAULT_FREQUENCY_HZ;
+      if (decoded.find('?') != std::string::npos) {
+        auto url_args = ParseTargetArgs(decoded);
+        if (url_args.contains("hz")) {
+          // "12abc", " 12" и "-1" отклоняются, а не читаются частично
+          const std::optional<unsigned> parsed = profiler::ParseFrequency(url_args.at("hz"));
+          if (!parsed) {
+            return text_response(http::status::bad_request,
+                                 StatusCodeProcessing(400), ContentType::JSON_HTML);
+          }
+          frequency = *parsed;
+        }
+      }
+      bool started = false;
+      try {
+        started = profiler::Start(frequency);
+      } catch (const std::exception &e) {
+        /* Таймер или обработчик SIGPROF не установлены: исключение не должно дойти до io_context */
+        json::object error_code;
+        error_code["code"] = "profilerError";
+        error_code["message"] = e.what();
+        return text_response(http::status::internal_server_error,
+                             json::serialize(error_code), ContentType::JSON_HTML);
+      }
+      if (!started) {
+        return text_response(http::status::conflict,
+                             R"({"code": "alreadyRunning", "message": "Profiler is already running"})",
+                             ContentType::JSON_HTML);
+      }
+      return text_response(http::status::ok, "{}", ContentType::JSON_HTML);
+    }
+    if (decoded == "/admin/profile/stop") {
+      if (req.method() != http::verb::post) {
+        return invalid_method("POST");
+      }
+      profiler::Stop();
+      const profiler::Stats stats = profiler::GetStats();
+      json::object body;
+      body["samples"] = stats.samples;
+      body["dropped"] = stats.dropped;
+      body["uniqueStacks"] = stats.unique_stacks;
+      return text_response(http::status::ok, json::serialize(body),
+                           ContentType::JSON_HTML);
+    }
+    json::object error_code;
+    error_code["code"] = "notFound";
+    error_code["message"] = "Not found";
+    return text_response(http::status::not_found, json::serialize(error_code),
+                         ContentType::JSON_HTML);
+  }
+};
+
 class RequestHandler : public std::enable_shared_from_this<RequestHandler> {
 public:
   explicit RequestHandler(model::Game &game, strct::Args &args,
                           Strand api_strand, DatabaseManagerPtr&& db_manager)
-      : game_(game), file_handler(args.root),
-        api_handler{api_strand, game, args.tick, args.state_file, args.save_state_tick, args.random_spawn, std::move(db_manager)} {}
+      : game_(game), admin_api_(args.admin_api), config_path_(args.config),
+        compression_{args.compression, args.compression_threshold},
+        admission_{{args.shed_queue_depth, std::chrono::milliseconds{args.shed_queue_delay},
+                    std::chrono::seconds{args.retry_after}}},
+        rate_limiter_{ParseRateLimits(args.rate_limits), args.rate_limit_clients_per_address},
+        too_many_requests_{MakeTooManyRequestsResponses()},
+        api_handler{api_strand, game, args.tick, args.state_file, args.save_state_tick, args.random_spawn, std::move(db_manager), compression_},
+        file_handler(args.root) {}
 
   RequestHandler(const RequestHandler &) = delete;
   RequestHandler &operator=(const RequestHandler &) = delete;
 
   template <typename Request, typename Send>
-  void operator()(Request &&req, Send &&send) {
+  void operator()(Request &&req, const net::ip::address &remote, Send &&send) {
     std::string decoded = logic_handler.URLDecode(std::string(req.target()));
+    const Route route = ClassifyRoute(decoded);
+    const metrics::Clock::time_point received_at = metrics::Clock::now();
+
+    /* Перед отправкой ответа учитываем его в метриках маршрута */
+    auto observed_send = [send, route, received_at](auto &&response) {
+      RequestMetrics::Instance().ObserveResponse(
+          route, ResponseMessage(response).result_int(),
+          metrics::Clock::now() - received_at);
+      send(std::forward<decltype(response)>(response));
+    };
+
+    /* Метрики атомарны, поэтому отдаются без захода в strand */
+    if (route == Route::METRICS) {
+      return observed_send(MakeMetricsResponse(req));
+    }
+
+    if (route == Route::ADMIN && admin_api_ && decoded == "/admin/config/reload" &&
+        req.method() == http::verb::post) {
+      // Ответ отправляется после подмены карт внутри strand
+      return ReloadMaps([send = std::move(observed_send), version = req.version(),
+                         keep_alive = req.keep_alive()](size_t maps, const std::string &error) {
+        json::object body;
+        http::status status = http::status::ok;
+        if (error.empty()) {
+          body["maps"] = maps;
+        } else {
+          status = http::status::unprocessable_entity;
+          body["code"] = "invalidConfig";
+          body["message"] = error;
+        }
+        send(LogicHandler::MakeStringResponse(status, json::serialize(body), version, keep_alive,
+                                              LogicHandler::ContentType::JSON_HTML, "no-cache"));
+      });
+    }
+
+    if (route == Route::ADMIN && admin_api_) {
+      return observed_send(admin_handler.AdminHandleRequest(req));
+    }
+
     if (logic_handler.StartWithStr(decoded, "/api/")) {
-      auto handle = [self = shared_from_this(), send, req] {
+      const auto authorization_field = req[http::field::authorization];
+      const std::string_view authorization(authorization_field.data(),
+                                           authorization_field.size());
+      // Лимит частоты проверяется до strand, отказ - готовый общий ответ без копирования
+      if (!rate_limiter_.Allow(route, authorization, remote)) {
+        return observed_send(too_many_requests_[req.version() == 10 ? 0 : 1][req.keep_alive()]);
+      }
+      const bool admission = admission_.Enabled();
+      if (admission) {
+        // Второстепенные запросы отклоняются до очереди strand, пока она перегружена
+        if (admission_.ShouldShed(route, authorization, api_handler.app_.GetTickCount())) {
+          return observed_send(MakeOverloadedResponse(req));
+        }
+        admission_.Enqueued();
+      }
+      auto handle = [self = shared_from_this(), send = std::move(observed_send),
+                     req, received_at, admission,
+                     worker = http_server::IoContextPool::Current()] {
+        const metrics::Clock::time_point dequeued_at = metrics::Clock::now();
+        RequestMetrics::Instance().ObserveStrandQueue(dequeued_at - received_at);
+        if (admission) {
+          self->admission_.Dequeued(dequeued_at - received_at);
+        }
+        tracing::RecordSpanIfEnabled("RequestHandler::StrandQueue", received_at,
+                                     dequeued_at);
+        TRACE_SCOPE("HandlerApiRequest::ApiHandleRequest");
         try {
           // Этот assert не выстрелит, так как лямбда-функция будет выполняться
           // внутри strand
           assert(self->api_handler.GetStrand().running_in_this_thread());
-          return send(self->api_handler.ApiHandleRequest(req, self->game_));
+          StringResponse response = self->api_handler.ApiHandleRequest(req, self->game_);
+          const http_compression::Encoding encoding =
+              LogicHandler::ResponseEncoding(req, response, self->compression_);
+          if (encoding == http_compression::Encoding::IDENTITY) {
+            return send(std::move(response));
+          }
+          // Сжатие выполняется вне strand, чтобы не задерживать очередь игровых
+          // запросов, на контексте потока, принявшего запрос
+          net::io_context &home =
+              worker ? *worker : self->api_handler.GetStrand().get_inner_executor().context();
+          return net::post(
+              home,
+              [self, send, encoding, response = std::move(response)]() mutable {
+                TRACE_SCOPE("RequestHandler::CompressResponse");
+                try {
+                  LogicHandler::CompressResponse(response, encoding, self->compression_.level);
+                } catch (const std::exception &) {
+                  // Ошибка zlib не повод терять ответ: тело не тронуто, отправляем как есть
+                }
+                send(std::move(response));
+              });
         } catch (std::exception &ex) {
           send(self->logic_handler.ReportServerError(
               http::status::bad_request, "badRequest", req.version(),
@@ -556,9 +833,10 @@ public:
     }
 
     /* Запросы доступа к файлам обрабатывает FileHandler*/
+    TRACE_SCOPE("HandlerFIleRequest::FileHandleRequest");
     return std::visit(
-        [&send, &req](auto &&result) {
-          send(std::forward<decltype(result)>(result));
+        [&observed_send](auto &&result) {
+          observed_send(std::forward<decltype(result)>(result));
         },
         file_handler.FileHandleRequest(std::forward<decltype(req)>(req)));
   }
@@ -567,15 +845,89 @@ public:
     api_handler.SaveState();
 }
 
+  /*
+    Перечитывает карты из файла конфигурации в отдельном потоке перезагрузки и
+    подменяет их внутри strand одной операцией, поэтому тики не ждут разбора,
+    на каком бы контексте ни пришёл запрос или SIGHUP. Перезагрузки выполняются
+    по очереди. Идущие сессии доигрываются на прежних картах. done(maps, error)
+    вызывается после подмены или с текстом ошибки, если файл не разобран; тогда
+    карты не меняются
+  */
+  void ReloadMaps(std::function<void(size_t maps, const std::string &error)> done);
+
+  // Число завершённых тиков игры
+  uint64_t GetTickCount() const noexcept {
+    return api_handler.app_.GetTickCount();
+  }
+
 void LoadState(){
   api_handler.LoadState();
 }
 
 private:
+  template <typename Request>
+  StringResponse MakeMetricsResponse(const Request &req) {
+    if (req.method() != http::verb::get && req.method() != http::verb::head) {
+      return logic_handler.ReportServerError(
+          http::status::method_not_allowed, "Invalid method", req.version(),
+          req.keep_alive(), LogicHandler::ContentType::TEXT_PLAIN, "no-cache",
+          "GET, HEAD");
+    }
+    return logic_handler.MakeStringResponse(
+        http::status::ok, metrics::DefaultRegistry().RenderPrometheus(),
+        req.version(), req.keep_alive(), LogicHandler::ContentType::PROMETHEUS,
+        "no-cache");
+  }
+
+  // Ответы 429 по версии HTTP (1.0, 1.1) и keep-alive собираются один раз
+  using SharedResponses = std::array<std::array<std::shared_ptr<const StringResponse>, 2>, 2>;
+
+  static SharedResponses MakeTooManyRequestsResponses() {
+    json::object error_code;
+    error_code["code"] = "tooManyRequests";
+    error_code["message"] = "Request rate limit exceeded";
+    const std::string body = json::serialize(error_code);
+    SharedResponses responses;
+    for (const unsigned version : {10u, 11u}) {
+      for (const bool keep_alive : {false, true}) {
+        StringResponse response = LogicHandler::ReportServerError(
+            http::status::too_many_requests, body, version, keep_alive,
+            LogicHandler::ContentType::JSON_HTML, "no-cache");
+        response.set(http::field::retry_after, "1");
+        responses[version == 10 ? 0 : 1][keep_alive] =
+            std::make_shared<const StringResponse>(std::move(response));
+      }
+    }
+    return responses;
+  }
+
+  template <typename Request>
+  StringResponse MakeOverloadedResponse(const Request &req) {
+    json::object error_code;
+    error_code["code"] = "serviceUnavailable";
+    error_code["message"] = "Server is overloaded, retry later";
+    StringResponse response = logic_handler.ReportServerError(
+        http::status::service_unavailable, json::serialize(error_code),
+        req.version(), req.keep_alive(), LogicHandler::ContentType::JSON_HTML,
+        "no-cache");
+    response.set(http::field::retry_after,
+                 std::to_string(admission_.RetryAfter().count()));
+    return response;
+  }
+
   model::Game &game_;
+  bool admin_api_;
+  std::filesystem::path config_path_;
+  http_compression::Settings compression_;
+  AdmissionControl admission_;
+  RateLimiter rate_limiter_;
+  const SharedResponses too_many_requests_;
   LogicHandler logic_handler;
+  HandlerAdminRequest admin_handler;
   HandlerApiRequest api_handler;
   HandlerFIleRequest file_handler;
+  // Последним членом: разрушается первым и дожидается начатого разбора конфигурации
+  net::thread_pool reload_pool_{1};
 };
 
 } // namespace http_handler
@@ -0,0 +1,137 @@
+#include "request_metrics.h"
+
+#include <algorithm>
+#include <string>
+
+namespace http_handler {
+
+namespace {
+
+bool StartsWith(std::string_view str, std::string_view prefix) {
+  return str.substr(0, prefix.size()) == prefix;
+}
+
+} // namespace
+
+Route ClassifyRoute(std::string_view decoded_target) {
+  using namespace std::literals;
+  if (StartsWith(decoded_target, "/api/v1/maps/"sv)) {
+    return Route::MAP;
+  }
+  if (StartsWith(decoded_target, "/api/v1/maps"sv)) {
+    return Route::MAPS;
+  }
+  if (StartsWith(decoded_target, "/api/v1/game/join"sv)) {
+    return Route::JOIN;
+  }
+  if (StartsWith(decoded_target, "/api/v1/game/players"sv)) {
+    return Route::PLAYERS;
+  }
+  if (StartsWith(decoded_target, "/api/v1/game/state"sv)) {
+    return Route::STATE;
+  }
+  if (StartsWith(decoded_target, "/api/v1/game/player/action"sv)) {
+    return Route::ACTION;
+  }
+  if (StartsWith(decoded_target, "/api/v1/game/tick"sv)) {
+    return Route::TICK;
+  }
+  if (StartsWith(decoded_target, "/api/v1/game/records"sv)) {
+    return Route::RECORDS;
+  }
+  if (StartsWith(decoded_target, "/api/"sv)) {
+    return Route::API_OTHER;
+  }
+  if (decoded_target == "/metrics"sv) {
+    return Route::METRICS;
+  }
+  if (StartsWith(decoded_target, "/admin/"sv)) {
+    return Route::ADMIN;
+  }
+  return Route::STATIC;
+}
+
+std::string_view RouteName(Route route) {
+  using namespace std::literals;
+  switch (route) {
+  case Route::MAPS:
+    return "maps"sv;
+  case Route::MAP:
+    return "map"sv;
+  case Route::JOIN:
+    return "join"sv;
+  case Route::PLAYERS:
+    return "players"sv;
+  case Route::STATE:
+    return "state"sv;
+  case Route::ACTION:
+    return "action"sv;
+  case Route::TICK:
+    return "tick"sv;
+  case Route::RECORDS:
+    return "records"sv;
+  case Route::API_OTHER:
+    return "api_other"sv;
+  case Route::METRICS:
+    return "metrics"sv;
+  case Route::ADMIN:
+    return "admin"sv;
+  case Route::STATIC:
+    return "static"sv;
+  default:
+    return "unknown"sv;
+  }
+}
+
+RequestMetrics &RequestMetrics::Instance() {
+  static RequestMetrics instance;
+  return instance;
+}
+
+RequestMetrics::RequestMetrics()
+    : requests_(metrics::DefaultRegistry().AddCounter(
+          "game_http_requests_total", "Number of handled HTTP requests",
+          {"route", "status"})),
+      latency_(metrics::DefaultRegistry().AddHistogram(
+          "game_http_request_duration_seconds",
+          "Time from request receipt to response creation",
+          {"route", "status"})),
+      strand_queue_(metrics::DefaultRegistry()
+                        .AddHistogram("game_api_strand_queue_seconds",
+                                      "Time API requests wait for the strand")
+                        .WithLabels({})) {}
+
+RequestMetrics::Series &RequestMetrics::GetSeries(Route route,
+                                                   unsigned status) {
+  status = std::clamp(status, MIN_STATUS, MAX_STATUS);
+  auto &slot = series_[static_cast<size_t>(route)][status - MIN_STATUS];
+
+  if (Series *series = slot.load(std::memory_order_acquire)) {
+    return *series;
+  }
+
+  /* Медленный путь выполняется один раз для каждой пары (маршрут, статус) */
+  std::lock_guard lock{mutex_};
+  if (Series *series = slot.load(std::memory_order_acquire)) {
+    return *series;
+  }
+  metrics::LabelValues labels{std::string(RouteName(route)),
+                              std::to_string(status)};
+  Series &series = storage_.emplace_back(Series{
+      requests_.WithLabels(labels), latency_.WithLabels(labels)});
+  slot.store(&series, std::memory_order_release);
+  return series;
+}
+
+void RequestMetrics::ObserveResponse(Route route, unsigned status,
+                                     metrics::Clock::duration latency) {
+  Series &series = GetSeries(route, status);
+  series.requests.Increment();
+  series.latency.RecordDuration(latency);
+}
+
+void RequestMetrics::ObserveStrandQueue(metrics::Clock::duration wait) {
+  strand_queue_.RecordDuration(wait);
+}
+
+} // namespace http_handler
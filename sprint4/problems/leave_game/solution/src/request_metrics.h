@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string_view>
+
+#include "metrics.h"
+
+namespace http_handler {
+
+/* Класс маршрута, по которому группируются метрики HTTP-запросов */
+enum class Route {
+  MAPS,
+  MAP,
+  JOIN,
+  PLAYERS,
+  STATE,
+  ACTION,
+  TICK,
+  RECORDS,
+  API_OTHER,
+  METRICS,
+  ADMIN,
+  STATIC,
+  COUNT
+};
+
+Route ClassifyRoute(std::string_view decoded_target);
+
+std::string_view RouteName(Route route);
+
+/*
+    Метрики HTTP-слоя: число запросов и время ответа по маршруту и статусу,
+    а также время ожидания запросов в очереди API strand.
+    Дочерние метрики для пары (маршрут, статус) создаются один раз и кэшируются
+    в атомарных указателях, поэтому запись не берёт блокировок.
+*/
+class RequestMetrics {
+public:
+  static RequestMetrics &Instance();
+
+  void ObserveResponse(Route route, unsigned status,
+                       metrics::Clock::duration latency);
+
+  void ObserveStrandQueue(metrics::Clock::duration wait);
+
+private:
+  RequestMetrics();
+
+  struct Series {
+    metrics::Counter &requests;
+    metrics::Histogram &latency;
+  };
+
+  static constexpr unsigned MIN_STATUS = 100;
+  static constexpr unsigned MAX_STATUS = 599;
+  static constexpr size_t STATUS_SLOTS = MAX_STATUS - MIN_STATUS + 1;
+
+  using RouteSeries = std::array<std::atomic<Series *>, STATUS_SLOTS>;
+
+  Series &GetSeries(Route route, unsigned status);
+
+  metrics::Family<metrics::Counter> &requests_;
+  metrics::Family<metrics::Histogram> &latency_;
+  metrics::Histogram &strand_queue_;
+
+  std::array<RouteSeries, static_cast<size_t>(Route::COUNT)> series_{};
+  std::mutex mutex_;
+  std::deque<Series> storage_;
+};
+
+} // namespace http_handler
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
@@ -13,5 +15,18 @@ struct Args {
   bool random_spawn = false;
   std::optional<std::string> state_file;
   std::optional<int> save_state_tick;
+  bool admin_api = false;
+  std::optional<uint64_t> random_seed;
+  bool compression = true;
+  size_t compression_threshold = 1024;
+  std::string io_mode = "shared";
+  unsigned threads = 0;
+  bool pin_threads = false;
+  bool coroutine_sessions = false;
+  size_t shed_queue_depth = 0;
+  unsigned shed_queue_delay = 0;
+  unsigned retry_after = 1;
+  std::vector<std::string> rate_limits;
+  unsigned rate_limit_clients_per_address = 8;
 };
 }; // namespace strct
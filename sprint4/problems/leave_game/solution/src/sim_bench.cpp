@@ -0,0 +1,322 @@
+/*
+    Безголовый бенчмарк игровой модели: без HTTP, базы данных и таймеров.
+
+    Загружает конфигурацию, создаёт на каждой карте заданное число сессий с N
+    синтетическими собаками и прогоняет тики с максимальной скоростью:
+      actions - случайное блуждание собак (аналог /api/v1/game/player/action),
+                доля --idle-share собак стоит на месте, как брошенные игроки;
+      loot    - Game::GenerateLootInSessions;
+      update  - Game::UpdateGameState (подбор, доставка и перемещение).
+
+    Все случайные решения берутся из генераторов с фиксированным зерном, поэтому
+    итоговое состояние (checksum) совпадает от запуска к запуску; меняются только времена.
+
+    Пример:
+      game_sim_bench -c data/config.json --dogs 1000 --sessions 4 --ticks 2000
+*/
+#include <boost/program_options.hpp>
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+
+#include "json_loader.h"
+#include "metrics.h"
+#include "model.h"
+
+using namespace std::literals;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::string config;
+  std::optional<std::string> map_id;
+  unsigned sessions = 1;
+  unsigned dogs = 100;
+  unsigned ticks = 1000;
+  int tick_period_ms = 50;
+  double turn_probability = 0.05;
+  double idle_share = 0;
+  uint64_t seed = 1;
+};
+
+enum class Phase { ACTIONS, LOOT, UPDATE, COUNT };
+
+constexpr std::string_view PHASE_NAMES[] = {"actions"sv, "loot"sv, "update"sv};
+
+/* Время фазы: гистограмма для перцентилей и точная сумма для среднего */
+struct PhaseStats {
+  metrics::Histogram histogram;
+  Clock::duration total{};
+
+  void Observe(Clock::duration duration) {
+    histogram.RecordDuration(duration);
+    total += duration;
+  }
+};
+
+/*
+    Отдельный от модели поток случайных чисел для действий игроков.
+    Величины считаются из сырых 64-битных чисел, а не через
+    std::*_distribution, чьи алгоритмы зависят от стандартной библиотеки.
+*/
+class ScriptRandom {
+public:
+  /* Зерно смещено, чтобы не совпадать с генератором модели */
+  explicit ScriptRandom(uint64_t seed) : engine_(~seed) {}
+
+  double Uniform() { return static_cast<double>(engine_() >> 11) * 0x1.0p-53; }
+
+  uint64_t Below(uint64_t bound) { return engine_() % bound; }
+
+private:
+  model::RandomEngine engine_;
+};
+
+model::Dog::Position RandomRoadPoint(const model::Map &map,
+                                     ScriptRandom &random) {
+  const auto &roads = map.GetRoads();
+  const model::Road &road = roads[random.Below(roads.size())];
+  const model::Point start = road.GetStart();
+  const model::Point end = road.GetEnd();
+  const double t = random.Uniform();
+  return model::Dog::Position(
+      {start.x + (end.x - start.x) * t, start.y + (end.y - start.y) * t});
+}
+
+double DogSpeed(const model::Game &game, const model::Map &map) {
+  return map.GetDogSpeed() > 0 ? map.GetDogSpeed() : game.GetDefaultDogSpeed();
+}
+
+/* Скриптовое действие игрока: сменить направление или остановиться */
+void RandomWalk(model::Dog &dog, double speed, double turn_probability,
+                ScriptRandom &random) {
+  const auto [vx, vy] = *dog.GetSpeed();
+  /* Упёршаяся в край дороги собака выбирает новое направление сразу */
+  if (vx != 0 || vy != 0) {
+    if (random.Uniform() >= turn_probability) {
+      return;
+    }
+  }
+  switch (random.Below(5)) {
+  case 0:
+    dog.SetSpeed(model::Dog::Speed({0, -speed}));
+    dog.SetDirection(model::Direction::NORTH);
+    break;
+  case 1:
+    dog.SetSpeed(model::Dog::Speed({0, speed}));
+    dog.SetDirection(model::Direction::SOUTH);
+    break;
+  case 2:
+    dog.SetSpeed(model::Dog::Speed({-speed, 0}));
+    dog.SetDirection(model::Direction::WEST);
+    break;
+  case 3:
+    dog.SetSpeed(model::Dog::Speed({speed, 0}));
+    dog.SetDirection(model::Direction::EAST);
+    break;
+  default:
+    dog.SetSpeed(model::Dog::Speed({0, 0}));
+    break;
+  }
+}
+
+void HashCombine(uint64_t &hash, uint64_t value) {
+  hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+}
+
+/* Отпечаток итогового состояния: позиции, очки и рюкзаки собак, трофеи на картах */
+uint64_t StateChecksum(const model::Game &game) {
+  uint64_t hash = 0;
+  const auto &all_sessions = game.GetAllSessions();
+  for (const model::Map &map : game.GetMaps()) {
+    auto it = all_sessions.find(map.GetId());
+    if (it == all_sessions.end()) {
+      continue;
+    }
+    for (const model::GameSession &session : it->second) {
+      for (const model::Dog &dog : session.GetDogs()) {
+        HashCombine(hash, static_cast<uint64_t>(dog.GetId()));
+        HashCombine(hash, std::bit_cast<uint64_t>((*dog.GetPosition()).x));
+        HashCombine(hash, std::bit_cast<uint64_t>((*dog.GetPosition()).y));
+        HashCombine(hash, static_cast<uint64_t>(dog.GetScore()));
+        HashCombine(hash, (*dog.GetBag()).size());
+      }
+      for (const model::Loot &loot : session.GetLootObjects()) {
+        HashCombine(hash, static_cast<uint64_t>(loot.id));
+        HashCombine(hash, std::bit_cast<uint64_t>(loot.pos.x));
+        HashCombine(hash, std::bit_cast<uint64_t>(loot.pos.y));
+      }
+    }
+  }
+  return hash;
+}
+
+[[nodiscard]] std::optional<Options> ParseCommandLine(int argc,
+                                                      const char *const argv[]) {
+  namespace po = boost::program_options;
+  Options options;
+  std::string map_id;
+  po::options_description desc{"Allowed options"s};
+  desc.add_options()
+  ("help,h", "produce help message")
+  ("config-file,c", po::value(&options.config)->value_name("file"s), "Set config file path")
+  ("map", po::value(&map_id)->value_name("id"s), "Simulate only this map (default: all maps)")
+  ("sessions", po::value(&options.sessions)->value_name("count"s), "Sessions per map")
+  ("dogs", po::value(&options.dogs)->value_name("count"s), "Dogs per session")
+  ("ticks", po::value(&options.ticks)->value_name("count"s), "Number of simulated ticks")
+  ("tick-period,t", po::value(&options.tick_period_ms)->value_name("milliseconds"s), "Simulated time per tick")
+  ("turn-probability", po::value(&options.turn_probability)->value_name("p"s), "Chance a moving dog changes direction each tick")
+  ("idle-share", po::value(&options.idle_share)->value_name("share"s), "Share of dogs in each session that never move (AFK players)")
+  ("seed", po::value(&options.seed)->value_name("number"s), "Random seed");
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, desc), vm);
+  po::notify(vm);
+
+  if (vm.contains("help"s)) {
+    std::cout << desc;
+    return std::nullopt;
+  }
+  if (!vm.contains("config-file"s)) {
+    throw std::runtime_error("Config file have not been specified"s);
+  }
+  if (vm.contains("map"s)) {
+    options.map_id = map_id;
+  }
+  if (options.idle_share < 0 || options.idle_share > 1) {
+    throw std::runtime_error("Idle share must be in [0, 1]"s);
+  }
+  if (options.tick_period_ms <= 0) {
+    throw std::runtime_error("Tick period must be positive"s);
+  }
+  return options;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+  try {
+    std::optional<Options> options = ParseCommandLine(argc, argv);
+    if (!options) {
+      return EXIT_SUCCESS;
+    }
+
+    model::Game game = json_loader::LoadGame(options->config);
+    model::SetRandomSeed(options->seed);
+    ScriptRandom random{options->seed};
+
+    /* Создание сессий и собак */
+    int next_dog_id = 0;
+    size_t total_dogs = 0;
+    for (const model::Map &map : game.GetMaps()) {
+      if (options->map_id && *map.GetId() != *options->map_id) {
+        continue;
+      }
+      for (unsigned s = 0; s < options->sessions; ++s) {
+        model::GameSession *session = game.AddSession(map.GetId());
+        for (unsigned d = 0; d < options->dogs; ++d) {
+          const int id = next_dog_id++;
+          model::Dog *dog = session->AddDog(
+              id, model::Dog::Name("bot" + std::to_string(id)),
+              RandomRoadPoint(map, random), model::Dog::Speed({0, 0}),
+              model::Direction::NORTH);
+          dog->SetBagCapacity(map.GetBagCapacity());
+        }
+        total_dogs += options->dogs;
+      }
+    }
+    if (total_dogs == 0) {
+      throw std::runtime_error("No dogs to simulate: check --map and --dogs"s);
+    }
+
+    PhaseStats phases[static_cast<size_t>(Phase::COUNT)];
+    PhaseStats tick_stats;
+    const model::detail::Milliseconds tick_period{options->tick_period_ms};
+    /* Первые idle_dogs собак каждой сессии стоят на месте */
+    const size_t idle_dogs = static_cast<size_t>(options->idle_share * options->dogs);
+
+    const Clock::time_point bench_start = Clock::now();
+    for (unsigned tick = 0; tick < options->ticks; ++tick) {
+      const Clock::time_point tick_start = Clock::now();
+
+      for (auto &[map_id, sessions] : game.GetAllSessions()) {
+        for (model::GameSession &session : sessions) {
+          const double speed = DogSpeed(game, *session.GetMap());
+          size_t index = 0;
+          for (model::Dog &dog : session.GetDogs()) {
+            if (index++ >= idle_dogs) {
+              RandomWalk(dog, speed, options->turn_probability, random);
+            }
+          }
+        }
+      }
+      const Clock::time_point actions_end = Clock::now();
+
+      game.GenerateLootInSessions(tick_period);
+      const Clock::time_point loot_end = Clock::now();
+
+      game.UpdateGameState(options->tick_period_ms);
+      const Clock::time_point update_end = Clock::now();
+
+      phases[static_cast<size_t>(Phase::ACTIONS)].Observe(actions_end - tick_start);
+      phases[static_cast<size_t>(Phase::LOOT)].Observe(loot_end - actions_end);
+      phases[static_cast<size_t>(Phase::UPDATE)].Observe(update_end - loot_end);
+      tick_stats.Observe(update_end - tick_start);
+    }
+    const double elapsed_s =
+        std::chrono::duration<double>(Clock::now() - bench_start).count();
+
+    size_t total_loot = 0;
+    for (const auto &[map_id, sessions] : game.GetAllSessions()) {
+      for (const model::GameSession &session : sessions) {
+        total_loot += session.GetLootObjects().size();
+      }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "dogs=" << total_dogs << " ticks=" << options->ticks
+              << " tick_period_ms=" << options->tick_period_ms
+              << " seed=" << options->seed << '\n';
+    std::cout << "elapsed_s=" << elapsed_s
+              << " ticks_per_s=" << options->ticks / elapsed_s
+              << " dog_updates_per_s=" << total_dogs * options->ticks / elapsed_s
+              << " realtime_factor="
+              << options->ticks * options->tick_period_ms / 1000.0 / elapsed_s
+              << '\n';
+
+    const auto print_row = [&options](std::string_view name,
+                                      const PhaseStats &stats) {
+      const double mean_us =
+          std::chrono::duration<double, std::micro>(stats.total).count() /
+          options->ticks;
+      std::cout << std::left << std::setw(8) << name << std::right
+                << " mean_us=" << std::setw(10) << mean_us
+                << " p50_us=" << std::setw(8) << stats.histogram.ValueAtPercentile(50)
+                << " p99_us=" << std::setw(8) << stats.histogram.ValueAtPercentile(99)
+                << " max_us=" << std::setw(8) << stats.histogram.Max() << '\n';
+    };
+    for (size_t i = 0; i < static_cast<size_t>(Phase::COUNT); ++i) {
+      print_row(PHASE_NAMES[i], phases[i]);
+    }
+    print_row("tick"sv, tick_stats);
+
+    /* В установившемся режиме временные контейнеры тика не обращаются к куче */
+    const util::TickArena::Stats &arena = game.GetTickArenaStats();
+    std::cout << "tick_arena_buffer_bytes=" << arena.buffer_size
+              << " last_tick_heap_allocations=" << arena.heap_allocations << '\n';
+
+    /* Воспроизводимая часть вывода: не зависит от скорости машины */
+    std::cout << "loot_on_maps=" << total_loot << " checksum=0x" << std::hex
+              << StateChecksum(game) << std::dec << '\n';
+  } catch (const std::exception &ex) {
+    std::cerr << "game_sim_bench: " << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+/**
+ * Плотное хранилище объектов со стабильными идентификаторами.
+ * Объекты лежат подряд в векторе, поэтому обход дружелюбен к кэшу,
+ * а по идентификатору объект находится через индекс id -> позиция.
+ * Удаление переставляет последний объект на место удалённого, поэтому
+ * все операции выполняются за O(1), но порядок обхода не сохраняется.
+ *
+ * IdOf - функтор, возвращающий идентификатор объекта:
+ *
+ *  struct LootIdOf {
+ *      int operator()(const Loot& loot) const { return loot.id; }
+ *  };
+ *  util::SlotMap<Loot, int, LootIdOf> loot;
+ */
+template <typename Value, typename Id, typename IdOf>
+class SlotMap {
+public:
+    using Container = std::vector<Value>;
+    using const_iterator = typename Container::const_iterator;
+
+    SlotMap() = default;
+
+    template <typename It>
+    SlotMap(It first, It last) {
+        for (; first != last; ++first) {
+            Insert(*first);
+        }
+    }
+
+    /* Выбрасывает std::invalid_argument, если объект с таким id уже есть */
+    Value& Insert(Value value) {
+        const Id id = IdOf{}(value);
+        if (!slots_.emplace(id, items_.size()).second) {
+            throw std::invalid_argument("Duplicate id in SlotMap");
+        }
+        try {
+            return items_.emplace_back(std::move(value));
+        } catch (...) {
+            slots_.erase(id);
+            throw;
+        }
+    }
+
+    /* Возвращает false, если объекта с таким id нет */
+    bool Erase(const Id& id) {
+        auto it = slots_.find(id);
+        if (it == slots_.end()) {
+            return false;
+        }
+        const size_t slot = it->second;
+        slots_.erase(it);
+
+        if (slot + 1 != items_.size()) {
+            items_[slot] = std::move(items_.back());
+            slots_[IdOf{}(items_[slot])] = slot;
+        }
+        items_.pop_back();
+        return true;
+    }
+
+    const Value* Find(const Id& id) const {
+        auto it = slots_.find(id);
+        return it == slots_.end() ? nullptr : &items_[it->second];
+    }
+
+    /* Доступ по текущей позиции: позиции действительны до следующего удаления */
+    const Value& operator[](size_t slot) const {
+        return items_[slot];
+    }
+
+    void Reserve(size_t count) {
+        items_.reserve(count);
+        slots_.reserve(count);
+    }
+
+    void Clear() noexcept {
+        items_.clear();
+        slots_.clear();
+    }
+
+    size_t size() const noexcept {
+        return items_.size();
+    }
+
+    bool empty() const noexcept {
+        return items_.empty();
+    }
+
+    const_iterator begin() const noexcept {
+        return items_.begin();
+    }
+
+    const_iterator end() const noexcept {
+        return items_.end();
+    }
+
+private:
+    Container items_;
+    std::unordered_map<Id, size_t> slots_;
+};
+
+}  // namespace util
@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "geom.h"
+
+namespace model {
+
+/**
+ * Равномерная сетка для поиска объектов в радиусе.
+ * Записи хранятся в одном векторе, отсортированном по номеру ячейки,
+ * поэтому пересборка не выделяет память после первого заполнения,
+ * а запрос просматривает только ячейки, пересекающие квадрат вокруг центра.
+ * Порядок работы: Reset, Insert для всех объектов, Build, затем запросы.
+ */
+template <typename Value>
+class SpatialGrid {
+public:
+    void Reset(double cell_size) {
+        cell_size_ = cell_size;
+        entries_.clear();
+    }
+
+    void Insert(PairDouble pos, Value value) {
+        entries_.push_back(Entry{CellKey(CellOf(pos.x), CellOf(pos.y)), pos, std::move(value)});
+    }
+
+    void Build() {
+        std::sort(entries_.begin(), entries_.end(), [](const Entry& lhs, const Entry& rhs) {
+            return lhs.key < rhs.key;
+        });
+    }
+
+    size_t size() const noexcept {
+        return entries_.size();
+    }
+
+    /* Вызывает action(const Value&) для всех объектов не дальше radius от center */
+    template <typename Action>
+    void ForEachInRadius(PairDouble center, double radius, Action&& action) const {
+        const double radius2 = radius * radius;
+        const int64_t min_x = CellOf(center.x - radius);
+        const int64_t max_x = CellOf(center.x + radius);
+        const int64_t min_y = CellOf(center.y - radius);
+        const int64_t max_y = CellOf(center.y + radius);
+        for (int64_t x = min_x; x <= max_x; ++x) {
+            for (int64_t y = min_y; y <= max_y; ++y) {
+                const uint64_t key = CellKey(x, y);
+                auto it = std::lower_bound(entries_.begin(), entries_.end(), key,
+                                           [](const Entry& entry, uint64_t key) {
+                                               return entry.key < key;
+                                           });
+                for (; it != entries_.end() && it->key == key; ++it) {
+                    const double dx = it->pos.x - center.x;
+                    const double dy = it->pos.y - center.y;
+                    if (dx * dx + dy * dy <= radius2) {
+                        action(it->value);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        uint64_t key;
+        PairDouble pos;
+        Value value;
+    };
+
+    int64_t CellOf(double coord) const {
+        return static_cast<int64_t>(std::floor(coord / cell_size_));
+    }
+
+    static uint64_t CellKey(int64_t x, int64_t y) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+
+    double cell_size_ = 1.0;
+    std::vector<Entry> entries_;
+};
+
+}  // namespace model
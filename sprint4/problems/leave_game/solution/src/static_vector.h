@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace util {
+
+/**
+ * Вектор с ёмкостью Capacity, хранящий элементы внутри себя, без выделения памяти.
+ * Подходит для маленьких коллекций с известной верхней границей размера,
+ * например для рюкзака собаки. Добавление в заполненный вектор
+ * выбрасывает std::length_error.
+ *
+ * Элементы лежат в std::array, поэтому очистка лишь сбрасывает размер;
+ * для этого тип обязан быть тривиально копируемым.
+ */
+template <typename Value, size_t Capacity>
+class StaticVector {
+    static_assert(std::is_trivially_copyable_v<Value>, "StaticVector does not destroy its elements");
+
+public:
+    using Container = std::array<Value, Capacity>;
+    using value_type = Value;
+    using iterator = typename Container::iterator;
+    using const_iterator = typename Container::const_iterator;
+
+    StaticVector() = default;
+
+    template <typename It>
+    StaticVector(It first, It last) {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    void push_back(const Value& value) {
+        if (size_ == Capacity) {
+            throw std::length_error("StaticVector is full");
+        }
+        items_[size_++] = value;
+    }
+
+    template <typename... Args>
+    Value& emplace_back(Args&&... args) {
+        push_back(Value{std::forward<Args>(args)...});
+        return items_[size_ - 1];
+    }
+
+    void clear() noexcept {
+        size_ = 0;
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    static constexpr size_t capacity() noexcept {
+        return Capacity;
+    }
+
+    const Value& operator[](size_t index) const {
+        return items_[index];
+    }
+
+    Value& operator[](size_t index) {
+        return items_[index];
+    }
+
+    iterator begin() noexcept {
+        return items_.begin();
+    }
+
+    iterator end() noexcept {
+        return items_.begin() + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return items_.begin();
+    }
+
+    const_iterator end() const noexcept {
+        return items_.begin() + size_;
+    }
+
+    friend bool operator==(const StaticVector& lhs, const StaticVector& rhs) {
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+    }
+
+private:
+    Container items_{};
+    size_t size_ = 0;
+};
+
+}  // namespace util
@@ -0,0 +1,47 @@
+#include "tick_arena.h"
+
+namespace util {
+
+TickArena::TickArena(size_t buffer_size)
+    : buffer_(std::make_unique<std::byte[]>(buffer_size))
+    , buffer_size_(buffer_size) {
+    last_tick_.buffer_size = buffer_size_;
+    StartTick();
+}
+
+void TickArena::Reset() {
+    // Разрушение монотонного ресурса возвращает в кучу всё, что было добрано сверх буфера
+    arena_.reset();
+
+    last_tick_.heap_allocations = heap_.allocations;
+    last_tick_.heap_bytes = heap_.bytes;
+    if (heap_.allocations != 0) {
+        buffer_size_ += heap_.bytes;
+        buffer_ = std::make_unique<std::byte[]>(buffer_size_);
+    }
+    last_tick_.buffer_size = buffer_size_;
+
+    StartTick();
+}
+
+void TickArena::StartTick() {
+    heap_.allocations = 0;
+    heap_.bytes = 0;
+    arena_.emplace(buffer_.get(), buffer_size_, &heap_);
+}
+
+void* TickArena::CountingHeap::do_allocate(size_t bytes, size_t alignment) {
+    ++allocations;
+    this->bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void TickArena::CountingHeap::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool TickArena::CountingHeap::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+}  // namespace util
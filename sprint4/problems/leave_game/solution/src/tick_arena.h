@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace util {
+
+/**
+ * Монотонная арена для временных контейнеров одного тика (std::pmr).
+ * Выделение - сдвиг указателя в буфере, освобождение отдельных объектов
+ * ничего не делает, а Reset в конце тика отдаёт всю память сразу, за O(1).
+ *
+ * Если тик не уместился в буфер, арена добирает память из кучи, а при
+ * следующем Reset увеличивает буфер на добранный объём. После нескольких
+ * тиков с похожей нагрузкой буфер перестаёт расти и тик обходится
+ * без обращений к куче; это видно по GetLastTickStats().heap_allocations.
+ *
+ * Контейнеры из арены не должны переживать Reset.
+ */
+class TickArena {
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+    struct Stats {
+        /* Обращения к куче за тик, когда буфера не хватило */
+        size_t heap_allocations = 0;
+        size_t heap_bytes = 0;
+        /* Размер буфера, которым начнётся следующий тик */
+        size_t buffer_size = 0;
+    };
+
+    explicit TickArena(size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+    TickArena(const TickArena&) = delete;
+    TickArena& operator=(const TickArena&) = delete;
+
+    std::pmr::memory_resource* Resource() noexcept {
+        return &*arena_;
+    }
+
+    /* Освобождает всё выделенное за тик; при нехватке буфера увеличивает его */
+    void Reset();
+
+    /* Счётчики тика, завершённого последним Reset */
+    const Stats& GetLastTickStats() const noexcept {
+        return last_tick_;
+    }
+
+private:
+    /* Память сверх буфера: берётся из кучи и подсчитывается */
+    class CountingHeap : public std::pmr::memory_resource {
+    public:
+        size_t allocations = 0;
+        size_t bytes = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+    };
+
+    void StartTick();
+
+    std::unique_ptr<std::byte[]> buffer_;
+    size_t buffer_size_;
+    CountingHeap heap_;
+    std::optional<std::pmr::monotonic_buffer_resource> arena_;
+    Stats last_tick_;
+};
+
+}  // namespace util
@@ -0,0 +1,163 @@
+#include "timing_wheel.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace util {
+
+namespace {
+
+/* Индекс первого установленного бита, не меньшего from, либо SLOTS */
+template <typename Bitmap>
+uint64_t FindOccupied(const Bitmap& bits, uint64_t from) noexcept {
+    constexpr uint64_t SLOTS = TimingWheel::SLOTS;
+    while (from < SLOTS) {
+        const uint64_t word = bits[from / 64] >> (from % 64);
+        if (word != 0) {
+            return from + std::countr_zero(word);
+        }
+        from = (from / 64 + 1) * 64;
+    }
+    return SLOTS;
+}
+
+}  // namespace
+
+TimerNode::~TimerNode() {
+    if (wheel_ != nullptr) {
+        wheel_->Cancel(*this);
+    }
+}
+
+TimingWheel::~TimingWheel() {
+    /* Оставшиеся узлы отвязываются, чтобы их деструкторы не обращались к колесу */
+    for (TimerNode*& head : lists_) {
+        while (head != nullptr) {
+            TimerNode* node = head;
+            head = node->next_;
+            node->prev_ = node->next_ = nullptr;
+            node->wheel_ = nullptr;
+        }
+    }
+}
+
+void TimingWheel::Schedule(TimerNode& node, uint64_t deadline) noexcept {
+    if (node.wheel_ != nullptr) {
+        Unlink(node);
+    }
+    node.deadline_ = std::max(deadline, now_);
+    Place(node);
+}
+
+void TimingWheel::Cancel(TimerNode& node) noexcept {
+    if (node.wheel_ == this) {
+        Unlink(node);
+    }
+}
+
+void TimingWheel::Place(TimerNode& node) noexcept {
+    const uint64_t delta = node.deadline_ - now_;
+    for (unsigned level = 0; level < LEVELS; ++level) {
+        const unsigned shift = SLOT_BITS * level;
+        if (delta < (SLOTS << shift)) {
+            Link(node, static_cast<uint32_t>(level * SLOTS + ((node.deadline_ >> shift) & SLOT_MASK)));
+            return;
+        }
+    }
+    /* Дальше горизонта колеса: перераспределяется при каждом полном обороте верхнего уровня */
+    Link(node, OVERFLOW_LIST);
+}
+
+void TimingWheel::Link(TimerNode& node, uint32_t list) noexcept {
+    node.wheel_ = this;
+    node.list_ = list;
+    node.prev_ = nullptr;
+    node.next_ = lists_[list];
+    if (node.next_ != nullptr) {
+        node.next_->prev_ = &node;
+    }
+    lists_[list] = &node;
+    if (list < OVERFLOW_LIST) {
+        const uint32_t slot = list % SLOTS;
+        occupied_[list / SLOTS][slot / 64] |= uint64_t{1} << (slot % 64);
+    }
+    ++size_;
+}
+
+void TimingWheel::Unlink(TimerNode& node) noexcept {
+    if (node.prev_ != nullptr) {
+        node.prev_->next_ = node.next_;
+    } else {
+        lists_[node.list_] = node.next_;
+    }
+    if (node.next_ != nullptr) {
+        node.next_->prev_ = node.prev_;
+    }
+    if (node.list_ < OVERFLOW_LIST && lists_[node.list_] == nullptr) {
+        const uint32_t slot = node.list_ % SLOTS;
+        occupied_[node.list_ / SLOTS][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+    }
+    node.prev_ = node.next_ = nullptr;
+    node.wheel_ = nullptr;
+    --size_;
+}
+
+uint64_t TimingWheel::NextStop(uint64_t now) const noexcept {
+    uint64_t next = now;
+    for (unsigned level = 0; level < LEVELS; ++level) {
+        const unsigned shift = SLOT_BITS * level;
+        const uint64_t current = (now_ >> shift) & SLOT_MASK;
+        const uint64_t rotation_start = (now_ >> shift >> SLOT_BITS) << SLOT_BITS << shift;
+
+        /* Слот уровня level посещается в момент, кратный 256^level; занятые слоты
+           не дальше текущего относятся к следующему обороту */
+        uint64_t slot = FindOccupied(occupied_[level], current + 1);
+        uint64_t at = rotation_start + (slot << shift);
+        if (slot == SLOTS) {
+            slot = FindOccupied(occupied_[level], 0);
+            at = rotation_start + (SLOTS << shift) + (slot << shift);
+        }
+        if (slot != SLOTS) {
+            next = std::min(next, at);
+        }
+    }
+    if (lists_[OVERFLOW_LIST] != nullptr) {
+        const unsigned shift = SLOT_BITS * LEVELS;
+        next = std::min(next, ((now_ >> shift) + 1) << shift);
+    }
+    return next;
+}
+
+void TimingWheel::Cascade(unsigned level) noexcept {
+    if (level >= LEVELS) {
+        TimerNode* node = lists_[OVERFLOW_LIST];
+        while (node != nullptr) {
+            TimerNode* next = node->next_;
+            Unlink(*node);
+            Place(*node);
+            node = next;
+        }
+        return;
+    }
+
+    const unsigned shift = SLOT_BITS * level;
+    const uint64_t slot = (now_ >> shift) & SLOT_MASK;
+    if (slot == 0) {
+        Cascade(level + 1);
+    }
+
+    const uint32_t list = static_cast<uint32_t>(level * SLOTS + slot);
+    TimerNode* node = lists_[list];
+    lists_[list] = nullptr;
+    occupied_[level][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+    while (node != nullptr) {
+        TimerNode* next = node->next_;
+        node->prev_ = node->next_ = nullptr;
+        node->wheel_ = nullptr;
+        --size_;
+        Place(*node);
+        node = next;
+    }
+}
+
+}  // namespace util
@@ -0,0 +1,136 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+
+class TimingWheel;
+
+/**
+ * Узел таймера, встраиваемый в объект-владелец (обычно наследованием).
+ * Постановка, перенос и отмена не выделяют память.
+ * Разрушение запланированного узла снимает его с колеса.
+ */
+class TimerNode {
+public:
+    TimerNode() = default;
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    ~TimerNode();
+
+    bool IsScheduled() const noexcept {
+        return wheel_ != nullptr;
+    }
+
+    uint64_t GetDeadline() const noexcept {
+        return deadline_;
+    }
+
+private:
+    friend TimingWheel;
+
+    uint64_t deadline_ = 0;
+    TimerNode* prev_ = nullptr;
+    TimerNode* next_ = nullptr;
+    TimingWheel* wheel_ = nullptr;
+    /* Номер списка, в котором лежит узел: уровень * SLOTS + слот, либо OVERFLOW_LIST */
+    uint32_t list_ = 0;
+};
+
+/**
+ * Иерархическое колесо таймеров (Varghese, Lauck).
+ * Время - целые тики (например, миллисекунды игрового времени).
+ * Уровень L содержит 256 слотов по 256^L тиков; узлы верхних уровней
+ * спускаются на нижние, когда время доходит до их слота.
+ * Advance посещает только занятые слоты (по битовым картам уровней),
+ * поэтому стоимость тика не зависит от числа запланированных таймеров
+ * и длины промежутка времени.
+ */
+class TimingWheel {
+public:
+    static constexpr unsigned SLOT_BITS = 8;
+    static constexpr uint64_t SLOTS = uint64_t{1} << SLOT_BITS;
+    static constexpr unsigned LEVELS = 4;
+
+    explicit TimingWheel(uint64_t now = 0) noexcept
+        : now_(now) {
+    }
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    ~TimingWheel();
+
+    uint64_t Now() const noexcept {
+        return now_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    /* Ставит или переносит таймер. Прошедший срок сработает при следующем Advance */
+    void Schedule(TimerNode& node, uint64_t deadline) noexcept;
+
+    void Cancel(TimerNode& node) noexcept;
+
+    /*
+        Продвигает время до now и вызывает on_expired(TimerNode&) для каждого
+        истёкшего узла. Узел снимается с колеса до вызова, поэтому обработчик
+        может перепланировать или разрушить его.
+    */
+    template <typename Callback>
+    void Advance(uint64_t now, Callback&& on_expired) {
+        if (now < now_) {
+            return;
+        }
+        if (size_ == 0) {
+            now_ = now;
+            return;
+        }
+        for (;;) {
+            ExpireSlot(now_ & SLOT_MASK, on_expired);
+            if (now_ == now) {
+                break;
+            }
+            now_ = NextStop(now);
+            if ((now_ & SLOT_MASK) == 0) {
+                Cascade(1);
+            }
+        }
+    }
+
+private:
+    static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+    static constexpr uint32_t OVERFLOW_LIST = LEVELS * SLOTS;
+
+    template <typename Callback>
+    void ExpireSlot(uint64_t slot, Callback& on_expired) {
+        while (TimerNode* node = lists_[slot]) {
+            Unlink(*node);
+            on_expired(*node);
+        }
+    }
+
+    /* Следующий момент, который нужно посетить: занятый слот нижнего уровня, спуск непустого слота верхнего или now */
+    uint64_t NextStop(uint64_t now) const noexcept;
+
+    void Place(TimerNode& node) noexcept;
+
+    void Link(TimerNode& node, uint32_t list) noexcept;
+
+    void Unlink(TimerNode& node) noexcept;
+
+    /* Спускает узлы текущего слота уровня level (и выше, если у них тоже граница) */
+    void Cascade(unsigned level) noexcept;
+
+    uint64_t now_;
+    size_t size_ = 0;
+    std::array<TimerNode*, LEVELS * SLOTS + 1> lists_{};
+    /* Битовые карты занятых слотов каждого уровня */
+    std::array<std::array<uint64_t, SLOTS / 64>, LEVELS> occupied_{};
+};
+
+}  // namespace util
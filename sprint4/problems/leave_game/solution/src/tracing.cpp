@@ -0,0 +1,243 @@
+#include "tracing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace tracing {
+
+namespace {
+
+/* Сколько последних спанов хранит каждый поток */
+constexpr size_t BUFFER_CAPACITY = 1 << 16;
+
+struct Span {
+    const char* name;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+/* Простая спин-блокировка: писатель захватывает её без конкуренции, читатель - только при выгрузке */
+class SpinLock {
+public:
+    void lock() noexcept {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+        }
+    }
+
+    void unlock() noexcept {
+        flag_.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+class ThreadBuffer {
+public:
+    explicit ThreadBuffer(int thread_id)
+        : thread_id_(thread_id)
+        , spans_(BUFFER_CAPACITY) {
+    }
+
+    void Push(const Span& span) noexcept {
+        std::lock_guard lock{lock_};
+        spans_[written_ % BUFFER_CAPACITY] = span;
+        ++written_;
+    }
+
+    /* Копирует спаны в хронологическом порядке записи */
+    std::vector<Span> Snapshot() {
+        std::lock_guard lock{lock_};
+        const size_t count = std::min<size_t>(written_, BUFFER_CAPACITY);
+        std::vector<Span> result;
+        result.reserve(count);
+        for (size_t i = written_ - count; i < written_; ++i) {
+            result.push_back(spans_[i % BUFFER_CAPACITY]);
+        }
+        return result;
+    }
+
+    void Clear() {
+        std::lock_guard lock{lock_};
+        written_ = 0;
+    }
+
+    /*
+        Поток буфера завершился. Пустой буфер больше не нужен (возвращает true),
+        иначе кольцо ужимается до записанных спанов: пока их меньше ёмкости,
+        они лежат с нулевого индекса, и Snapshot читает их по тем же индексам.
+    */
+    bool Retire() noexcept {
+        std::lock_guard lock{lock_};
+        retired_ = true;
+        if (written_ == 0) {
+            return true;
+        }
+        if (written_ < BUFFER_CAPACITY) {
+            spans_.resize(written_);
+            spans_.shrink_to_fit();
+        }
+        return false;
+    }
+
+    bool IsRetired() noexcept {
+        std::lock_guard lock{lock_};
+        return retired_;
+    }
+
+    int GetThreadId() const noexcept {
+        return thread_id_;
+    }
+
+private:
+    int thread_id_;
+    SpinLock lock_;
+    std::vector<Span> spans_;
+    size_t written_ = 0;
+    bool retired_ = false;
+};
+
+/*
+    Буферы завершившихся потоков со спанами живут до ближайшей очистки, чтобы
+    их спаны попали в выгрузку; пустые удаляются сразу. Так короткоживущие
+    потоки (например, разбор конфигурации) не копят буферы.
+*/
+class BufferRegistry {
+public:
+    std::shared_ptr<ThreadBuffer> Register() {
+        std::lock_guard lock{mutex_};
+        return buffers_.emplace_back(std::make_shared<ThreadBuffer>(++last_thread_id_));
+    }
+
+    void Retire(const std::shared_ptr<ThreadBuffer>& buffer) {
+        std::lock_guard lock{mutex_};
+        if (buffer->Retire()) {
+            std::erase(buffers_, buffer);
+        }
+    }
+
+    std::vector<std::shared_ptr<ThreadBuffer>> GetBuffers() {
+        std::lock_guard lock{mutex_};
+        return buffers_;
+    }
+
+    void Clear() {
+        std::lock_guard lock{mutex_};
+        std::erase_if(buffers_, [](const std::shared_ptr<ThreadBuffer>& buffer) {
+            buffer->Clear();
+            return buffer->IsRetired();
+        });
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    int last_thread_id_ = 0;
+};
+
+BufferRegistry& GetRegistry() {
+    static BufferRegistry registry;
+    return registry;
+}
+
+/* Буфер потока создаётся первым спаном и снимается с учёта при завершении потока */
+class ThreadBufferHolder {
+public:
+    ~ThreadBufferHolder() {
+        if (buffer_) {
+            GetRegistry().Retire(buffer_);
+        }
+    }
+
+    /* nullptr, если выделить буфер не удалось: спан тогда теряется */
+    ThreadBuffer* Get() noexcept {
+        if (!buffer_) {
+            try {
+                buffer_ = GetRegistry().Register();
+            } catch (const std::exception&) {
+                return nullptr;
+            }
+        }
+        return buffer_.get();
+    }
+
+private:
+    std::shared_ptr<ThreadBuffer> buffer_;
+};
+
+ThreadBuffer* GetThreadBuffer() noexcept {
+    thread_local ThreadBufferHolder holder;
+    return holder.Get();
+}
+
+const Clock::time_point& GetEpoch() {
+    static const Clock::time_point epoch = Clock::now();
+    return epoch;
+}
+
+int64_t ToNanoseconds(Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - GetEpoch()).count();
+}
+
+void WriteEscaped(std::ostream& out, const char* str) {
+    for (; *str != '\0'; ++str) {
+        if (*str == '"' || *str == '\\') {
+            out << '\\';
+        }
+        out << *str;
+    }
+}
+
+} // namespace
+
+void SetEnabled(bool enabled) noexcept {
+    GetEpoch();
+    detail::enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void RecordSpan(const char* name, Clock::time_point start, Clock::time_point end) noexcept {
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (buffer == nullptr) {
+        return;
+    }
+    const int64_t start_ns = ToNanoseconds(start);
+    buffer->Push(Span{name, start_ns, ToNanoseconds(end) - start_ns});
+}
+
+std::string DumpChromeTrace() {
+    std::ostringstream out;
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    out << "{\"traceEvents\":[";
+
+    bool first = true;
+    for (const auto& buffer : GetRegistry().GetBuffers()) {
+        for (const Span& span : buffer->Snapshot()) {
+            out << (first ? "" : ",") << "{\"name\":\"";
+            WriteEscaped(out, span.name);
+            /* Формат trace_event ожидает время в микросекундах */
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->GetThreadId()
+                << ",\"ts\":" << static_cast<double>(span.start_ns) / 1000.0
+                << ",\"dur\":" << static_cast<double>(span.duration_ns) / 1000.0 << '}';
+            first = false;
+        }
+    }
+
+    out << "],\"displayTimeUnit\":\"ms\"}";
+    return out.str();
+}
+
+void Clear() {
+    GetRegistry().Clear();
+}
+
+size_t GetThreadBufferCount() {
+    return GetRegistry().GetBuffers().size();
+}
+
+} // namespace tracing
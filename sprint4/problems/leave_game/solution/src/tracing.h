@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace tracing {
+
+using Clock = std::chrono::steady_clock;
+
+namespace detail {
+
+inline std::atomic<bool> enabled{false};
+
+} // namespace detail
+
+/* Запись спанов включается во время работы сервера, по умолчанию выключена */
+inline bool IsEnabled() noexcept {
+    return detail::enabled.load(std::memory_order_relaxed);
+}
+
+void SetEnabled(bool enabled) noexcept;
+
+/*
+    Сохраняет завершённый спан в кольцевой буфер текущего потока.
+    name должен указывать на строку со статическим временем жизни.
+*/
+void RecordSpan(const char* name, Clock::time_point start, Clock::time_point end) noexcept;
+
+/* Для интервалов, измеренных заранее (например, ожидание в очереди strand) */
+inline void RecordSpanIfEnabled(const char* name, Clock::time_point start, Clock::time_point end) noexcept {
+#ifdef GAME_ENABLE_TRACING
+    if (IsEnabled()) {
+        RecordSpan(name, start, end);
+    }
+#else
+    (void)name;
+    (void)start;
+    (void)end;
+#endif
+}
+
+/* Собирает спаны из буферов всех потоков в JSON формата Chrome trace_event */
+std::string DumpChromeTrace();
+
+/* Очищает буферы всех потоков и освобождает буферы завершившихся */
+void Clear();
+
+/* Число буферов спанов: живые потоки, писавшие спаны, и завершившиеся до очистки */
+size_t GetThreadBufferCount();
+
+/* Спан, длящийся от создания объекта до его разрушения */
+class ScopedSpan {
+public:
+    explicit ScopedSpan(const char* name) noexcept
+        : name_(name)
+        , active_(IsEnabled()) {
+        if (active_) {
+            start_ = Clock::now();
+        }
+    }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+    ~ScopedSpan() {
+        if (active_) {
+            RecordSpan(name_, start_, Clock::now());
+        }
+    }
+
+private:
+    const char* name_;
+    bool active_;
+    Clock::time_point start_;
+};
+
+} // namespace tracing
+
+/*
+    TRACE_SCOPE("name") отмечает спан до конца текущей области видимости.
+    Без GAME_ENABLE_TRACING макрос раскрывается в пустое выражение.
+*/
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+
+#ifdef GAME_ENABLE_TRACING
+#define TRACE_SCOPE(name) ::tracing::ScopedSpan TRACE_CONCAT(trace_span_, __LINE__){name}
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#endif
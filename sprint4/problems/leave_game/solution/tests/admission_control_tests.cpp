@@ -0,0 +1,198 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <string>
+
+#include "../src/admission_control.h"
+
+using namespace std::literals;
+using http_handler::AdmissionControl;
+using http_handler::AdmissionSettings;
+using http_handler::Route;
+
+namespace {
+
+constexpr std::string_view TOKEN_A = "Bearer 0123456789abcdef0123456789abcdef";
+constexpr std::string_view TOKEN_B = "Bearer fedcba9876543210fedcba9876543210";
+
+AdmissionSettings DepthLimit(size_t depth) {
+    AdmissionSettings settings;
+    settings.max_queue_depth = depth;
+    return settings;
+}
+
+AdmissionSettings DelayLimit(std::chrono::milliseconds delay) {
+    AdmissionSettings settings;
+    settings.max_queue_delay = delay;
+    return settings;
+}
+
+void Enqueue(AdmissionControl& control, int count) {
+    for (int i = 0; i < count; ++i) {
+        control.Enqueued();
+    }
+}
+
+/* Маршруты, которые не отклоняются ни при какой нагрузке */
+bool ShedsAnyEssential(AdmissionControl& control, uint64_t tick) {
+    for (Route route : {Route::JOIN, Route::ACTION, Route::MAPS, Route::MAP, Route::TICK}) {
+        /* Дважды в одном тике, чтобы правило повторного опроса тоже не сработало */
+        if (control.ShouldShed(route, TOKEN_A, tick) || control.ShouldShed(route, TOKEN_A, tick)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+SCENARIO("Admission control sheds secondary requests when the queue is deep") {
+    GIVEN("a depth limit of three queued requests") {
+        AdmissionControl control{DepthLimit(3)};
+        REQUIRE(control.Enabled());
+
+        WHEN("the queue is below the limit") {
+            Enqueue(control, 2);
+
+            THEN("nothing is shed") {
+                CHECK_FALSE(control.Overloaded());
+                CHECK_FALSE(control.ShouldShed(Route::RECORDS, "", 1));
+                CHECK_FALSE(control.ShouldShed(Route::PLAYERS, TOKEN_A, 1));
+            }
+        }
+
+        WHEN("the queue reaches the limit") {
+            Enqueue(control, 3);
+
+            THEN("records and players are shed") {
+                CHECK(control.Overloaded());
+                CHECK(control.ShouldShed(Route::RECORDS, "", 1));
+                CHECK(control.ShouldShed(Route::PLAYERS, TOKEN_A, 1));
+            }
+
+            THEN("join, action and other routes are never shed") {
+                CHECK_FALSE(ShedsAnyEssential(control, 1));
+            }
+
+            AND_WHEN("a request leaves the queue") {
+                control.Dequeued(0ms);
+
+                THEN("shedding stops") {
+                    CHECK_FALSE(control.Overloaded());
+                    CHECK_FALSE(control.ShouldShed(Route::RECORDS, "", 1));
+                }
+            }
+        }
+    }
+
+    GIVEN("no thresholds") {
+        AdmissionControl control{AdmissionSettings{}};
+        Enqueue(control, 10'000);
+
+        THEN("admission control is disabled and sheds nothing") {
+            CHECK_FALSE(control.Enabled());
+            CHECK_FALSE(control.ShouldShed(Route::RECORDS, "", 1));
+            CHECK_FALSE(control.ShouldShed(Route::STATE, TOKEN_A, 1));
+            CHECK_FALSE(control.ShouldShed(Route::STATE, TOKEN_A, 1));
+        }
+    }
+}
+
+SCENARIO("Admission control sheds secondary requests when the queue is slow") {
+    GIVEN("a delay limit of 10 ms") {
+        AdmissionControl control{DelayLimit(10ms)};
+
+        WHEN("requests waited long and the queue is not empty") {
+            control.Enqueued();
+            control.Dequeued(100ms);
+            control.Enqueued();
+
+            THEN("secondary requests are shed, essential ones are not") {
+                CHECK(control.Overloaded());
+                CHECK(control.ShouldShed(Route::RECORDS, "", 1));
+                CHECK_FALSE(ShedsAnyEssential(control, 1));
+            }
+        }
+
+        WHEN("requests waited long but the queue is empty now") {
+            control.Enqueued();
+            control.Dequeued(100ms);
+
+            THEN("the stale average does not shed requests that would run at once") {
+                CHECK_FALSE(control.Overloaded());
+                CHECK_FALSE(control.ShouldShed(Route::RECORDS, "", 1));
+            }
+        }
+
+        WHEN("a single slow request is followed by fast ones") {
+            control.Enqueued();
+            control.Dequeued(100ms);
+            for (int i = 0; i < 30; ++i) {
+                control.Enqueued();
+                control.Dequeued(0ms);
+            }
+            control.Enqueued();
+
+            THEN("the average decays below the limit") {
+                CHECK_FALSE(control.Overloaded());
+            }
+        }
+
+        WHEN("requests wait just below the limit") {
+            for (int i = 0; i < 50; ++i) {
+                control.Enqueued();
+                control.Dequeued(9ms);
+            }
+            control.Enqueued();
+
+            THEN("nothing is shed") {
+                CHECK_FALSE(control.Overloaded());
+            }
+        }
+    }
+}
+
+SCENARIO("Admission control sheds only repeated state polls within a tick") {
+    GIVEN("an overloaded queue") {
+        AdmissionControl control{DepthLimit(1)};
+        control.Enqueued();
+        REQUIRE(control.Overloaded());
+
+        THEN("the first poll of a player in a tick passes, a repeated one is shed") {
+            CHECK_FALSE(control.ShouldShed(Route::STATE, TOKEN_A, 5));
+            CHECK(control.ShouldShed(Route::STATE, TOKEN_A, 5));
+            CHECK(control.ShouldShed(Route::STATE, TOKEN_A, 5));
+        }
+
+        THEN("other players and the next tick are not affected") {
+            CHECK_FALSE(control.ShouldShed(Route::STATE, TOKEN_A, 5));
+            CHECK_FALSE(control.ShouldShed(Route::STATE, TOKEN_B, 5));
+            CHECK_FALSE(control.ShouldShed(Route::STATE, TOKEN_A, 6));
+            CHECK(control.ShouldShed(Route::STATE, TOKEN_B, 5));
+        }
+
+        THEN("polls without a bearer token are never shed") {
+            CHECK_FALSE(control.ShouldShed(Route::STATE, "", 5));
+            CHECK_FALSE(control.ShouldShed(Route::STATE, "", 5));
+            CHECK_FALSE(control.ShouldShed(Route::STATE, "Basic abc", 5));
+            CHECK_FALSE(control.ShouldShed(Route::STATE, "Basic abc", 5));
+        }
+    }
+
+    GIVEN("a queue that becomes overloaded within a tick") {
+        AdmissionControl control{DepthLimit(1)};
+
+        WHEN("a player polls before and after the overload") {
+            const bool shed_before = control.ShouldShed(Route::STATE, TOKEN_A, 7);
+            const bool repeated_before = control.ShouldShed(Route::STATE, TOKEN_A, 7);
+            control.Enqueued();
+            const bool shed_after = control.ShouldShed(Route::STATE, TOKEN_A, 7);
+
+            THEN("polls pass while the queue is short, the poll is remembered and the repeat is shed") {
+                CHECK_FALSE(shed_before);
+                CHECK_FALSE(repeated_before);
+                CHECK(shed_after);
+            }
+        }
+    }
+}
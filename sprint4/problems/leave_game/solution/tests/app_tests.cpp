@@ -0,0 +1,45 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <string>
+
+#include "../src/app.h"
+
+using namespace model;
+using namespace std::literals;
+
+SCENARIO("Player actions set the dog's speed and direction") {
+    GIVEN("a moving player on a map with dog speed 2") {
+        auto map = std::make_shared<Map>(Map::Id("action_town"s), "Action town"s);
+        map->AddRoad(Road{Road::HORIZONTAL, {0, 0}, 10});
+        map->AddDogSpeed(2);
+        GameSession session{map};
+        Dog* dog = session.AddDog(1, Dog::Name("Rex"s), Dog::Position({0, 0}), Dog::Speed({0, 0}), Direction::NORTH);
+        auto player = std::make_shared<players::Player>(1, "Rex"s, dog, &session);
+        app::GameStateUseCase::SetPlayerAction(player, "R");
+
+        THEN("a direction move sets the speed along it") {
+            CHECK((*dog->GetSpeed()).x == 2);
+            CHECK((*dog->GetSpeed()).y == 0);
+            CHECK(dog->GetDirection() == Direction::EAST);
+        }
+
+        WHEN("the player sends the empty stop move") {
+            CHECK(app::GameStateUseCase::SetPlayerAction(player, ""s) == "{}"s);
+
+            THEN("the dog stops and keeps its direction") {
+                CHECK(dog->IsStopped());
+                CHECK(dog->GetDirection() == Direction::EAST);
+            }
+        }
+    }
+
+    THEN("only L, R, U, D and the empty move are valid") {
+        for (const char* move : {"L", "R", "U", "D", ""}) {
+            CHECK(app::GameStateUseCase::IsValidMove(move));
+        }
+        CHECK_FALSE(app::GameStateUseCase::IsValidMove("X"));
+        CHECK_FALSE(app::GameStateUseCase::IsValidMove("LR"));
+        CHECK_FALSE(app::GameStateUseCase::IsValidMove("l"));
+    }
+}
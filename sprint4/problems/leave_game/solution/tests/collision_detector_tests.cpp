@@ -0,0 +1,58 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <vector>
+
+#include "../src/collision_detector.h"
+#include "vector_provider.h"
+
+using namespace collision_detector;
+
+namespace {
+
+using test_support::VectorProvider;
+
+bool SameEvents(const std::vector<GatheringEvent>& lhs, const std::pmr::vector<GatheringEvent>& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].item_id != rhs[i].item_id || lhs[i].gatherer_id != rhs[i].gatherer_id
+            || lhs[i].sq_distance != rhs[i].sq_distance || lhs[i].time != rhs[i].time) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+SCENARIO("Gather events are the same through the provider and through arrays") {
+    GIVEN("items along a road and gatherers passing them") {
+        const std::vector<Item> items{
+            {{5, 0}, 0.},
+            {{1, 0.5}, 0.},
+            {{8, 3}, 0.},   // далеко от всех путей
+            {{9, 0}, 0.5},
+        };
+        const std::vector<Gatherer> gatherers{
+            {{0, 0}, {10, 0}, 0.6},
+            {{6, 0}, {6, 0}, 0.6},  // стоит на месте и ничего не собирает
+            {{10, 0}, {0, 0}, 0.6},
+        };
+
+        THEN("both overloads find the items in chronological order") {
+            const std::vector<GatheringEvent> by_provider = FindGatherEvents(VectorProvider{items, gatherers});
+            const std::pmr::vector<GatheringEvent> by_arrays = FindGatherEvents(items, gatherers);
+
+            CHECK(by_provider.size() == 6);
+            CHECK(SameEvents(by_provider, by_arrays));
+            for (size_t i = 1; i < by_arrays.size(); ++i) {
+                CHECK(by_arrays[i - 1].time <= by_arrays[i].time);
+            }
+            for (const GatheringEvent& event : by_arrays) {
+                CHECK(event.item_id != 2);
+                CHECK(event.gatherer_id != 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,302 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/coro_session.h"
+
+using namespace std::literals;
+
+/*
+  Подсчёт глобальных выделений памяти. Считаются только выделения потоков,
+  включивших счётчик, - в тестах это поток io_context сервера
+*/
+namespace {
+
+std::atomic<size_t> allocations{0};
+thread_local bool count_allocations = false;
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+    if (count_allocations) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+
+using namespace http_server;
+
+constexpr std::string_view PING_REQUEST = "GET /ping HTTP/1.1\r\nHost: localhost\r\n\r\n"sv;
+
+/* Отвечает 204 без полей и тела: сам ответ не обращается к куче */
+struct PingHandler {
+    // Значение счётчика выделений в момент каждого запроса
+    std::vector<size_t>* allocations_at_request;
+    // Ответ отправляется из другого потока, пока обработчик ещё не вернул управление
+    bool complete_from_other_thread = false;
+    // Готовый общий ответ вместо 204
+    std::shared_ptr<const http::response<http::string_body>> shared_response;
+
+    template <typename Request, typename Send>
+    void operator()(const Request& request, const net::ip::address&, Send&& send) const {
+        if (allocations_at_request != nullptr) {
+            allocations_at_request->push_back(allocations.load(std::memory_order_relaxed));
+        }
+        if (shared_response) {
+            return send(shared_response);
+        }
+        http::response<http::empty_body> response{http::status::no_content, request.version()};
+        response.keep_alive(request.keep_alive());
+        if (complete_from_other_thread) {
+            std::thread([&send, &response] { send(std::move(response)); }).join();
+        } else {
+            send(std::move(response));
+        }
+    }
+};
+
+/* Соединение клиента с сессией; io_context сервера работает в своём потоке */
+template <template <typename> class SessionT = CoroSession>
+class SessionFixture {
+public:
+    explicit SessionFixture(PingHandler handler) {
+        tcp::acceptor acceptor(server_ioc_, {net::ip::address_v4::loopback(), 0});
+        client_.connect(acceptor.local_endpoint());
+        std::make_shared<SessionT<PingHandler>>(acceptor.accept(net::make_strand(server_ioc_)),
+                                                   handler)
+            ->Run();
+        server_ = std::thread([this] {
+            count_allocations = true;
+            server_ioc_.run();
+        });
+    }
+
+    ~SessionFixture() {
+        Disconnect();
+    }
+
+    http::status Ping() {
+        return Request().result();
+    }
+
+    http::response<http::string_body> Request() {
+        net::write(client_, net::buffer(PING_REQUEST));
+        http::response<http::string_body> response;
+        http::read(client_, buffer_, response);
+        return response;
+    }
+
+    // Закрывает соединение и дожидается завершения сессии
+    void Disconnect() {
+        if (server_.joinable()) {
+            beast::error_code ec;
+            client_.shutdown(tcp::socket::shutdown_send, ec);
+            client_.close(ec);
+            server_.join();
+        }
+    }
+
+    // Выполняет fn на потоке сервера
+    template <typename Fn>
+    void RunOnServer(Fn fn) {
+        std::atomic<bool> done{false};
+        net::post(server_ioc_, [&] {
+            fn();
+            done = true;
+        });
+        while (!done) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    net::io_context server_ioc_;
+    net::io_context client_ioc_;
+    tcp::socket client_{client_ioc_};
+    beast::flat_buffer buffer_;
+    std::thread server_;
+};
+
+}  // namespace
+
+SCENARIO("CoroSession does not allocate per request on a keep-alive connection") {
+    constexpr size_t WARM_UP = 16;
+    constexpr size_t REQUESTS = 64;
+
+    GIVEN("a session that answered a few requests") {
+        std::vector<size_t> allocations_at_request;
+        allocations_at_request.reserve(WARM_UP + REQUESTS);
+        SessionFixture<> session(PingHandler{&allocations_at_request});
+        // Журнал запроса и ответа выделяет память сам; сессия не должна добавлять к нему ничего
+        size_t logging_allocations = 0;
+        session.RunOnServer([&logging_allocations] {
+            for (int i = 0; i < 2; ++i) {
+                const size_t before = allocations.load(std::memory_order_relaxed);
+                logger::LogRequestReceived("127.0.0.1"s, "/ping"s, "GET"s);
+                logger::LogResponseSent(0, 204, ""s);
+                logging_allocations = allocations.load(std::memory_order_relaxed) - before;
+            }
+        });
+        for (size_t i = 0; i < WARM_UP; ++i) {
+            REQUIRE(session.Ping() == http::status::no_content);
+        }
+
+        WHEN("more requests go over the same connection") {
+            for (size_t i = 0; i < REQUESTS; ++i) {
+                REQUIRE(session.Ping() == http::status::no_content);
+            }
+            session.Disconnect();
+
+            THEN("only logging touches the heap") {
+                REQUIRE(allocations_at_request.size() == WARM_UP + REQUESTS);
+                const size_t steady = allocations_at_request.back() - allocations_at_request[WARM_UP];
+                CHECK(steady <= (REQUESTS - 1) * logging_allocations);
+            }
+        }
+    }
+}
+
+SCENARIO("CoroSession accepts a response completed before it waits for one") {
+    GIVEN("a handler that sends the response from another thread and waits for it") {
+        SessionFixture<> session(PingHandler{nullptr, true});
+
+        THEN("every request on the connection gets its response") {
+            for (int i = 0; i < 8; ++i) {
+                REQUIRE(session.Ping() == http::status::no_content);
+            }
+        }
+    }
+}
+
+SCENARIO("Sessions write a shared immutable response without taking it over") {
+    auto response = [] {
+        http::response<http::string_body> response{http::status::too_many_requests, 11};
+        response.set(http::field::content_type, "application/json");
+        response.body() = R"({"code":"tooManyRequests"})";
+        response.prepare_payload();
+        return std::make_shared<const http::response<http::string_body>>(std::move(response));
+    }();
+
+    const auto check_session = [&response](auto& session) {
+        for (int i = 0; i < 3; ++i) {
+            const auto received = session.Request();
+            CHECK(received.result() == http::status::too_many_requests);
+            CHECK(received.body() == response->body());
+        }
+        session.Disconnect();
+        CHECK(response.use_count() == 1);
+        CHECK(response->body() == R"({"code":"tooManyRequests"})");
+    };
+
+    GIVEN("a callback session") {
+        SessionFixture<Session> session(PingHandler{nullptr, false, response});
+        check_session(session);
+    }
+
+    GIVEN("a coroutine session") {
+        SessionFixture<CoroSession> session(PingHandler{nullptr, false, response});
+        check_session(session);
+    }
+}
+
+SCENARIO("HandlerMemory serves small blocks from its slots") {
+    HandlerMemory memory;
+
+    GIVEN("blocks that fit a slot") {
+        const size_t before = allocations.load();
+        count_allocations = true;
+        void* first = memory.Allocate(64);
+        void* second = memory.Allocate(1024);
+        count_allocations = false;
+
+        THEN("they do not come from the heap") {
+            CHECK(allocations.load() == before);
+            CHECK(first != second);
+        }
+
+        WHEN("a block is released") {
+            memory.Deallocate(first);
+
+            THEN("the next block reuses its slot") {
+                void* third = memory.Allocate(128);
+                CHECK(third == first);
+                memory.Deallocate(third);
+            }
+        }
+        memory.Deallocate(second);
+    }
+
+    GIVEN("a block larger than a slot and a block beyond the free slots") {
+        std::vector<void*> slots;
+        for (int i = 0; i < 4; ++i) {
+            slots.push_back(memory.Allocate(16));
+        }
+        const size_t before = allocations.load();
+        count_allocations = true;
+        void* large = memory.Allocate(4096);
+        void* overflow = memory.Allocate(16);
+        count_allocations = false;
+
+        THEN("both come from the heap and are returned to it") {
+            CHECK(allocations.load() == before + 2);
+            memory.Deallocate(large);
+            memory.Deallocate(overflow);
+        }
+        for (void* slot : slots) {
+            memory.Deallocate(slot);
+        }
+    }
+}
+
+SCENARIO("CompletionSlot holds one handler until it is invoked") {
+    GIVEN("a slot with a handler") {
+        CompletionSlot slot;
+        auto state = std::make_shared<int>(0);
+        slot.Emplace([state] { ++*state; });
+
+        THEN("Invoke calls the handler and releases its captures") {
+            slot.Invoke();
+            CHECK(*state == 1);
+            CHECK(state.use_count() == 1);
+        }
+
+        THEN("the handler may fill the slot again while being invoked") {
+            slot.Invoke();
+            slot.Emplace([state, &slot] {
+                ++*state;
+                slot.Emplace([state] { *state += 10; });
+            });
+            slot.Invoke();
+            slot.Invoke();
+            CHECK(*state == 12);
+        }
+
+        THEN("a handler that was never invoked is destroyed with the slot") {
+            {
+                CompletionSlot other;
+                other.Emplace([state] { ++*state; });
+                CHECK(state.use_count() == 3);
+            }
+            CHECK(state.use_count() == 2);
+        }
+    }
+}
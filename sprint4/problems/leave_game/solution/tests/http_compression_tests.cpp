@@ -0,0 +1,206 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <zlib.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "../src/http_compression.h"
+
+using namespace std::literals;
+using http_compression::ChooseEncoding;
+using http_compression::Compress;
+using http_compression::Encoding;
+using http_compression::HeaderQuality;
+
+namespace {
+
+/* Распаковка средствами zlib: gzip - с обёрткой gzip, deflate - в формате zlib */
+std::string Inflate(const std::string& compressed, Encoding encoding) {
+    z_stream stream{};
+    if (inflateInit2(&stream, encoding == Encoding::GZIP ? MAX_WBITS + 16 : MAX_WBITS) != Z_OK) {
+        throw std::runtime_error("inflateInit2 failed");
+    }
+    std::string out(64 * 1024, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(compressed.data()));
+    stream.avail_in = static_cast<uInt>(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = static_cast<uInt>(out.size());
+    const int result = inflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        throw std::runtime_error("inflate did not reach the end of the stream");
+    }
+    return out;
+}
+
+/* Похоже на JSON состояния игры: хорошо сжимается */
+std::string MakePayload(int players) {
+    std::string payload = "{\"players\":{";
+    for (int i = 0; i < players; ++i) {
+        payload += "\"" + std::to_string(i) + "\":{\"pos\":[" + std::to_string(i * 1.5) + ",0.0],\"dir\":\"U\"},";
+    }
+    return payload + "}}";
+}
+
+}  // namespace
+
+SCENARIO("Accept-Encoding weights are parsed") {
+    THEN("q-values are read per listed value, case-insensitively and with spaces") {
+        CHECK(HeaderQuality("gzip;q=0.5, deflate", {"gzip"}) == 0.5);
+        CHECK(HeaderQuality("gzip;q=0.5, deflate", {"deflate"}) == 1.0);
+        CHECK(HeaderQuality("GZip ; q=0.25", {"gzip"}) == 0.25);
+        CHECK(HeaderQuality("  br,\tgzip;q=0.8 ", {"gzip"}) == 0.8);
+    }
+
+    THEN("the highest weight among matches wins and absent values weigh zero") {
+        CHECK(HeaderQuality("gzip;q=0.2, x-gzip;q=0.7", {"gzip", "x-gzip"}) == 0.7);
+        CHECK(HeaderQuality("br", {"gzip"}) == 0.0);
+        CHECK(HeaderQuality("", {"gzip"}) == 0.0);
+    }
+
+    THEN("media types with parameters are matched too") {
+        CHECK(HeaderQuality("application/json, application/msgpack;q=0.9", {"application/msgpack"}) == 0.9);
+    }
+}
+
+SCENARIO("Accept weights come from the most specific media range") {
+    using http_compression::MediaTypeQuality;
+
+    THEN("an exact type beats wildcard ranges with any weight") {
+        CHECK(MediaTypeQuality("application/json;q=0.1, */*", {"application/json"}) == 0.1);
+        CHECK(MediaTypeQuality("application/*;q=0.3, application/json;q=0.1", {"application/json"}) == 0.1);
+        CHECK(MediaTypeQuality("application/msgpack;q=0, */*", {"application/msgpack"}) == 0.0);
+    }
+
+    THEN("synonyms count as the exact type") {
+        CHECK(MediaTypeQuality("application/x-msgpack;q=0.4, */*", {"application/msgpack", "application/x-msgpack"})
+              == 0.4);
+    }
+
+    THEN("a type range is more specific than any type") {
+        CHECK(MediaTypeQuality("*/*;q=0.9, application/*;q=0.2", {"application/json"}) == 0.2);
+        CHECK(MediaTypeQuality("text/*, */*;q=0.5", {"application/json"}) == 0.5);
+    }
+
+    THEN("an unmatched type weighs zero") {
+        CHECK(MediaTypeQuality("text/html", {"application/json"}) == 0.0);
+        CHECK(MediaTypeQuality("", {"application/json"}) == 0.0);
+    }
+}
+
+SCENARIO("Response encoding is chosen from Accept-Encoding") {
+    THEN("an explicit zero weight rejects gzip even when * allows everything") {
+        CHECK(ChooseEncoding("gzip;q=0, *") == Encoding::DEFLATE);
+        CHECK(ChooseEncoding("*, gzip;q=0, deflate;q=0") == Encoding::IDENTITY);
+    }
+
+    THEN("gzip wins a tie with deflate") {
+        CHECK(ChooseEncoding("deflate, gzip") == Encoding::GZIP);
+        CHECK(ChooseEncoding("deflate;q=0.5, gzip;q=0.5") == Encoding::GZIP);
+        CHECK(ChooseEncoding("*") == Encoding::GZIP);
+    }
+
+    THEN("a higher weight wins") {
+        CHECK(ChooseEncoding("deflate;q=0.6, gzip;q=0.5") == Encoding::DEFLATE);
+        CHECK(ChooseEncoding("x-gzip, deflate;q=0.9") == Encoding::GZIP);
+    }
+
+    THEN("identity is used when nothing is acceptable") {
+        CHECK(ChooseEncoding("") == Encoding::IDENTITY);
+        CHECK(ChooseEncoding("br, identity") == Encoding::IDENTITY);
+        CHECK(ChooseEncoding("gzip;q=0, deflate;q=0") == Encoding::IDENTITY);
+        CHECK(ChooseEncoding("*;q=0") == Encoding::IDENTITY);
+    }
+}
+
+SCENARIO("Compressed bodies inflate back to the input") {
+    const std::string first = MakePayload(200);
+    const std::string second = MakePayload(50) + "tail";
+
+    for (Encoding encoding : {Encoding::GZIP, Encoding::DEFLATE}) {
+        GIVEN("the "s + std::string(http_compression::EncodingName(encoding)) + " encoding") {
+            THEN("the output is smaller and inflates to the input") {
+                const std::string compressed = Compress(first, encoding);
+                CHECK(compressed.size() < first.size());
+                CHECK(Inflate(compressed, encoding) == first);
+            }
+
+            THEN("the reused per-thread stream produces a complete stream on the next call") {
+                REQUIRE(Inflate(Compress(first, encoding), encoding) == first);
+                CHECK(Inflate(Compress(second, encoding), encoding) == second);
+                CHECK(Inflate(Compress(""s, encoding), encoding).empty());
+            }
+
+            THEN("changing the level between calls keeps the output valid") {
+                REQUIRE(Inflate(Compress(first, encoding, 1), encoding) == first);
+                CHECK(Inflate(Compress(second, encoding, 9), encoding) == second);
+                CHECK(Inflate(Compress(first, encoding), encoding) == first);
+            }
+        }
+    }
+
+    THEN("the gzip and zlib headers are written") {
+        const std::string gzip = Compress(first, Encoding::GZIP);
+        REQUIRE(gzip.size() > 2);
+        CHECK(static_cast<unsigned char>(gzip[0]) == 0x1f);
+        CHECK(static_cast<unsigned char>(gzip[1]) == 0x8b);
+        CHECK(static_cast<unsigned char>(Compress(first, Encoding::DEFLATE)[0]) == 0x78);
+    }
+
+    THEN("identity returns the input as is") {
+        CHECK(Compress(first, Encoding::IDENTITY) == first);
+    }
+}
+
+SCENARIO("Payload cache keeps a body and its compressed variants") {
+    GIVEN("a cache with one body") {
+        http_compression::PayloadCache cache;
+        const std::string body = MakePayload(100);
+        cache.Put("map1"s, body);
+
+        THEN("the body and its compressed variants are found") {
+            REQUIRE(cache.Find("map1"s, Encoding::IDENTITY) != nullptr);
+            CHECK(*cache.Find("map1"s, Encoding::IDENTITY) == body);
+            const std::string* gzip = cache.Find("map1"s, Encoding::GZIP);
+            REQUIRE(gzip != nullptr);
+            CHECK(Inflate(*gzip, Encoding::GZIP) == body);
+            CHECK(cache.Find("map1"s, Encoding::GZIP) == gzip);
+            CHECK(Inflate(*cache.Find("map1"s, Encoding::DEFLATE), Encoding::DEFLATE) == body);
+        }
+
+        THEN("unknown keys are not found") {
+            CHECK(cache.Find("map2"s, Encoding::IDENTITY) == nullptr);
+            CHECK(cache.Find("map2"s, Encoding::GZIP) == nullptr);
+        }
+
+        WHEN("the cache is cleared after compressed variants were built") {
+            REQUIRE(cache.Find("map1"s, Encoding::GZIP) != nullptr);
+            REQUIRE(cache.Find("map1"s, Encoding::DEFLATE) != nullptr);
+            cache.Clear();
+
+            THEN("nothing is found") {
+                CHECK(cache.Find("map1"s, Encoding::IDENTITY) == nullptr);
+                CHECK(cache.Find("map1"s, Encoding::GZIP) == nullptr);
+            }
+
+            THEN("a new body for the key is compressed anew") {
+                const std::string new_body = MakePayload(7);
+                cache.Put("map1"s, new_body);
+                CHECK(Inflate(*cache.Find("map1"s, Encoding::GZIP), Encoding::GZIP) == new_body);
+                CHECK(Inflate(*cache.Find("map1"s, Encoding::DEFLATE), Encoding::DEFLATE) == new_body);
+            }
+        }
+
+        WHEN("a new body is put over a compressed one") {
+            REQUIRE(cache.Find("map1"s, Encoding::GZIP) != nullptr);
+            const std::string new_body = MakePayload(3);
+            cache.Put("map1"s, new_body);
+
+            THEN("the stale compressed variant is not served") {
+                CHECK(Inflate(*cache.Find("map1"s, Encoding::GZIP), Encoding::GZIP) == new_body);
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/interned_id.h"
+
+using namespace std::literals;
+
+namespace {
+
+// У каждого теста своя метка, чтобы таблицы имён не пересекались
+struct SameNameTag {};
+struct FindTag {};
+struct ThreadsTag {};
+
+}  // namespace
+
+SCENARIO("Interned ids compare by index and keep the name for output") {
+    using Id = util::InternedId<SameNameTag>;
+
+    GIVEN("ids created from names") {
+        const Id town{"town"s};
+        const Id town_again{"town"sv};
+        const Id city{"city"s};
+
+        THEN("the same name gets the same dense index") {
+            CHECK(town == town_again);
+            CHECK(town.GetIndex() == town_again.GetIndex());
+            CHECK(town != city);
+            CHECK(town.GetIndex() == 0);
+            CHECK(city.GetIndex() == 1);
+        }
+
+        THEN("the name is shared, not copied") {
+            CHECK(*town == "town"s);
+            CHECK(*city == "city"s);
+            CHECK(&*town == &*town_again);
+        }
+    }
+}
+
+SCENARIO("Find does not intern unknown names") {
+    using Id = util::InternedId<FindTag>;
+
+    const Id known{"known"s};
+
+    CHECK(Id::Find("known"sv) == known);
+    CHECK_FALSE(Id::Find("unknown"sv).has_value());
+    CHECK_FALSE(Id::Find("unknown"sv).has_value());
+    // Следующее занесённое имя получает номер сразу за "known"
+    CHECK(Id{"next"s}.GetIndex() == known.GetIndex() + 1);
+}
+
+SCENARIO("Names interned from several threads get distinct indices") {
+    using Id = util::InternedId<ThreadsTag>;
+    constexpr int THREADS = 4;
+    constexpr int NAMES = 100;
+
+    std::vector<std::vector<Id>> ids(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&ids, t] {
+            for (int i = 0; i < NAMES; ++i) {
+                ids[t].emplace_back("map"s + std::to_string(i));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::set<Id::IndexType> indices;
+    for (int i = 0; i < NAMES; ++i) {
+        for (int t = 1; t < THREADS; ++t) {
+            CHECK(ids[t][i] == ids[0][i]);
+        }
+        CHECK(*ids[0][i] == "map"s + std::to_string(i));
+        indices.insert(ids[0][i].GetIndex());
+    }
+    // Номера плотные: 0..NAMES-1
+    CHECK(indices.size() == NAMES);
+    CHECK(*indices.rbegin() == NAMES - 1);
+}
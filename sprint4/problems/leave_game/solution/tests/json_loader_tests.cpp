@@ -0,0 +1,196 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include "../src/json_loader.h"
+
+using namespace std::literals;
+using json_loader::ConfigError;
+
+namespace {
+
+const std::string ROAD = R"({"x0": 0, "y0": 0, "x1": 40})"s;
+const std::string OFFICE = R"({"id": "o0", "x": 40, "y": 0, "offsetX": 5, "offsetY": 0})"s;
+const std::string LOOT_TYPE = R"({"name": "key", "file": "assets/key.obj", "type": "obj", "value": 10})"s;
+
+struct MapSpec {
+    std::string id;
+    std::string roads = "[" + ROAD + "]";
+    std::string offices = "[" + OFFICE + "]";
+    // Поле "name" со значением; пустая строка - поля нет
+    std::string name_field = R"("name": "Town", )"s;
+};
+
+std::string MapJson(const MapSpec& spec) {
+    return R"({"id": ")" + spec.id + R"(", )" + spec.name_field + R"("roads": )" + spec.roads +
+           R"(, "buildings": [], "offices": )" + spec.offices + R"(, "lootTypes": [)" + LOOT_TYPE + "]}";
+}
+
+std::string ConfigJson(const std::vector<MapSpec>& maps, const std::string& settings = {}) {
+    std::string result = "{" + settings + R"("maps": [)";
+    for (size_t i = 0; i < maps.size(); ++i) {
+        if (i != 0) {
+            result += ", ";
+        }
+        result += MapJson(maps[i]);
+    }
+    return result + "]}";
+}
+
+std::vector<MapSpec> ManyMaps(size_t count) {
+    std::vector<MapSpec> maps(count);
+    for (size_t i = 0; i < count; ++i) {
+        maps[i].id = "map" + std::to_string(i);
+    }
+    return maps;
+}
+
+/* Путь из ConfigError, брошенной при разборе; пустая строка, если разбор прошёл */
+std::string ErrorPath(const std::string& config) {
+    try {
+        json_loader::ParseGame(config);
+    } catch (const ConfigError& ex) {
+        return ex.Path();
+    }
+    return {};
+}
+
+}  // namespace
+
+SCENARIO("A valid configuration is loaded") {
+    GIVEN("a configuration with global settings and two maps") {
+        const std::string config = ConfigJson(
+            ManyMaps(2),
+            R"("defaultDogSpeed": 3.5, "lootGeneratorConfig": {"period": 5.0, "probability": 0.5}, )"
+            R"("maxPlayersPerSession": 4, "sessionPlacement": "leastLoaded", )");
+
+        THEN("the maps and settings are applied") {
+            const model::Game game = json_loader::ParseGame(config);
+            REQUIRE(game.GetMaps().size() == 2);
+            CHECK(*game.GetMaps()[1].GetId() == "map1"s);
+            CHECK(game.GetMaps()[0].GetDogSpeed() == 3.5);
+            CHECK(game.GetMaps()[0].GetMaxPlayersPerSession() == 4);
+            CHECK(game.GetSessionPlacement() == model::SessionPlacement::LEAST_LOADED);
+        }
+    }
+}
+
+SCENARIO("Configuration errors point to the offending value") {
+    THEN("a broken document is reported at the root") {
+        CHECK(ErrorPath(R"({"maps": [)") == "$"s);
+        CHECK(ErrorPath(R"([])") == "$"s);
+        CHECK(ErrorPath(R"({})") == "$.maps"s);
+    }
+
+    GIVEN("a bad road") {
+        THEN("a road without an end is reported at the road") {
+            auto maps = ManyMaps(1);
+            maps[0].roads = "[" + ROAD + R"(, {"x0": 0, "y0": 0}])";
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[0].roads[1]"s);
+        }
+
+        THEN("a coordinate of the wrong type is reported at the coordinate") {
+            auto maps = ManyMaps(2);
+            maps[1].roads = "[" + ROAD + R"(, {"x0": "a", "y0": 0, "x1": 5}])";
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[1].roads[1].x0"s);
+        }
+
+        THEN("a fractional coordinate is reported at the coordinate") {
+            auto maps = ManyMaps(1);
+            maps[0].roads = R"([{"x0": 0, "y0": 0, "x1": 2.5}])";
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[0].roads[0].x1"s);
+        }
+
+        THEN("a road that is not an object is reported at the road") {
+            auto maps = ManyMaps(1);
+            maps[0].roads = "[" + ROAD + ", 17]";
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[0].roads[1]"s);
+        }
+    }
+
+    GIVEN("a missing field") {
+        THEN("a missing map name is reported at the field") {
+            auto maps = ManyMaps(3);
+            maps[2].name_field.clear();
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[2].name"s);
+        }
+
+        THEN("a missing office offset is reported at the field") {
+            auto maps = ManyMaps(1);
+            maps[0].offices = R"([{"id": "o0", "x": 40, "y": 0, "offsetX": 5}])";
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[0].offices[0].offsetY"s);
+        }
+
+        THEN("a missing global setting field is reported at the field") {
+            CHECK(ErrorPath(ConfigJson(ManyMaps(1), R"("lootGeneratorConfig": {"probability": 0.5}, )"))
+                  == "$.lootGeneratorConfig.period"s);
+        }
+    }
+
+    GIVEN("invalid global settings") {
+        THEN("they are reported before any map") {
+            auto maps = ManyMaps(1);
+            maps[0].name_field.clear();
+            CHECK(ErrorPath(ConfigJson(maps, R"("defaultDogSpeed": "fast", )")) == "$.defaultDogSpeed"s);
+            CHECK(ErrorPath(ConfigJson(maps, R"("sessionPlacement": "random", )")) == "$.sessionPlacement"s);
+            CHECK(ErrorPath(ConfigJson(maps, R"("defaultBagCapacity": 1000, )")) == "$.defaultBagCapacity"s);
+            CHECK(ErrorPath(ConfigJson(maps, R"("dogRetirementTime": -1, )")) == "$.dogRetirementTime"s);
+            CHECK(ErrorPath(ConfigJson(maps, R"("dogRetirementTime": 1e12, )")) == "$.dogRetirementTime"s);
+        }
+    }
+
+    GIVEN("duplicate ids") {
+        THEN("a duplicate map id is reported at the second map") {
+            auto maps = ManyMaps(4);
+            maps[3].id = "map0";
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[3].id"s);
+        }
+
+        THEN("a duplicate office id is reported at the second office") {
+            auto maps = ManyMaps(1);
+            maps[0].offices = "[" + OFFICE + ", " + OFFICE + "]";
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[0].offices[1].id"s);
+        }
+    }
+}
+
+SCENARIO("The first error wins when maps are loaded in parallel") {
+    GIVEN("many maps with errors in several of them") {
+        /* Достаточно карт, чтобы загрузка шла в нескольких потоках */
+        auto maps = ManyMaps(json_loader::MAPS_PER_WORKER * 16);
+        maps[200].roads = R"([{"x0": 0, "y0": 0}])";
+        maps[170].name_field.clear();
+        maps[90].offices = R"([{"id": "o0", "x": 40, "y": 0, "offsetX": 5}])";
+        maps[250].id = "map1";
+        const std::string config = ConfigJson(maps);
+
+        THEN("the error of the map with the lowest index is reported on every run") {
+            for (int run = 0; run < 20; ++run) {
+                REQUIRE(ErrorPath(config) == "$.maps[90].offices[0].offsetY"s);
+            }
+        }
+    }
+
+    GIVEN("an error in the first map and in the last one") {
+        auto maps = ManyMaps(json_loader::MAPS_PER_WORKER * 16);
+        maps[0].name_field.clear();
+        maps.back().name_field.clear();
+        const std::string config = ConfigJson(maps);
+
+        THEN("the first map is reported even if the last one fails first") {
+            for (int run = 0; run < 20; ++run) {
+                REQUIRE(ErrorPath(config) == "$.maps[0].name"s);
+            }
+        }
+    }
+
+    GIVEN("many valid maps with a duplicate id far apart") {
+        auto maps = ManyMaps(json_loader::MAPS_PER_WORKER * 16);
+        maps[240].id = "map7";
+
+        THEN("the duplicate is reported at the later map") {
+            CHECK(ErrorPath(ConfigJson(maps)) == "$.maps[240].id"s);
+        }
+    }
+}
@@ -0,0 +1,269 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/metrics.h"
+
+using namespace std::literals;
+using metrics::Histogram;
+
+namespace {
+
+struct BucketLine {
+    std::string le;
+    uint64_t count = 0;
+};
+
+/* Строки name_bucket{...,le="..."} из вывода Prometheus в порядке следования */
+std::vector<BucketLine> ParseBuckets(const std::string& text, const std::string& name) {
+    std::vector<BucketLine> buckets;
+    std::istringstream in{text};
+    const std::string prefix = name + "_bucket{";
+    for (std::string line; std::getline(in, line);) {
+        if (line.rfind(prefix, 0) != 0) {
+            continue;
+        }
+        const size_t le_begin = line.find("le=\"") + 4;
+        const size_t le_end = line.find('"', le_begin);
+        buckets.push_back({line.substr(le_begin, le_end - le_begin), std::stoull(line.substr(line.rfind(' ') + 1))});
+    }
+    return buckets;
+}
+
+/* Значение строки вида "name{labels} value" */
+std::string FindValue(const std::string& text, const std::string& series) {
+    std::istringstream in{text};
+    for (std::string line; std::getline(in, line);) {
+        if (line.rfind(series + " ", 0) == 0) {
+            return line.substr(series.size() + 1);
+        }
+    }
+    return {};
+}
+
+}  // namespace
+
+SCENARIO("Histogram buckets follow the log-linear grid") {
+    THEN("small values get a bucket each") {
+        for (uint64_t value = 0; value < Histogram::SUB_BUCKETS; ++value) {
+            CHECK(Histogram::BucketIndex(value) == value);
+            CHECK(Histogram::BucketLowerBound(value) == value);
+            CHECK(Histogram::BucketUpperBound(value) == value + 1);
+        }
+    }
+
+    THEN("every power of two starts a new bucket") {
+        for (unsigned exponent = 1; exponent <= Histogram::MAX_EXPONENT; ++exponent) {
+            INFO(exponent);
+            const uint64_t power = uint64_t{1} << exponent;
+            const size_t index = Histogram::BucketIndex(power);
+            CHECK(index == Histogram::BucketIndex(power - 1) + 1);
+            CHECK(Histogram::BucketLowerBound(index) == power);
+            CHECK(Histogram::BucketUpperBound(index - 1) == power);
+        }
+    }
+
+    THEN("a value lies within its bucket and the bucket is at most 1/SUB_BUCKETS wide") {
+        for (uint64_t value : {9ull, 15ull, 17ull, 100ull, 1'000ull, 123'456ull, 999'999'999ull, (1ull << 40) + 5}) {
+            INFO(value);
+            const size_t index = Histogram::BucketIndex(value);
+            CHECK(Histogram::BucketLowerBound(index) <= value);
+            CHECK(value < Histogram::BucketUpperBound(index));
+            CHECK((Histogram::BucketUpperBound(index) - Histogram::BucketLowerBound(index)) * Histogram::SUB_BUCKETS
+                  <= Histogram::BucketLowerBound(index));
+        }
+    }
+
+    THEN("the top bucket ends at 2^(MAX_EXPONENT + 1)") {
+        const uint64_t top = (uint64_t{1} << (Histogram::MAX_EXPONENT + 1)) - 1;
+        CHECK(Histogram::BucketIndex(top) == Histogram::BUCKET_COUNT - 1);
+        const uint64_t top_bucket_start = Histogram::BucketLowerBound(Histogram::BUCKET_COUNT - 1);
+        CHECK(top_bucket_start == top + 1 - (uint64_t{1} << (Histogram::MAX_EXPONENT - Histogram::SUB_BUCKET_BITS)));
+        CHECK(Histogram::BucketIndex(top_bucket_start - 1) == Histogram::BUCKET_COUNT - 2);
+        CHECK(Histogram::BucketUpperBound(Histogram::BUCKET_COUNT - 1) == top + 1);
+    }
+
+    THEN("larger values overflow into the top bucket") {
+        CHECK(Histogram::BucketIndex(uint64_t{1} << (Histogram::MAX_EXPONENT + 1)) == Histogram::BUCKET_COUNT - 1);
+        CHECK(Histogram::BucketIndex(std::numeric_limits<uint64_t>::max()) == Histogram::BUCKET_COUNT - 1);
+
+        Histogram histogram;
+        histogram.Record(std::numeric_limits<uint64_t>::max() / 2);
+        CHECK(histogram.Count() == 1);
+        CHECK(histogram.BucketValue(Histogram::BUCKET_COUNT - 1) == 1);
+        CHECK(histogram.Max() == std::numeric_limits<uint64_t>::max() / 2);
+    }
+}
+
+SCENARIO("Histogram percentiles") {
+    GIVEN("an empty histogram") {
+        Histogram histogram;
+
+        THEN("every percentile is zero") {
+            CHECK(histogram.ValueAtPercentile(50) == 0);
+            CHECK(histogram.ValueAtPercentile(100) == 0);
+        }
+    }
+
+    GIVEN("values from 1 to 100") {
+        Histogram histogram;
+        for (uint64_t value = 1; value <= 100; ++value) {
+            histogram.Record(value);
+        }
+
+        THEN("a percentile is the upper bound of the bucket holding the ranked value") {
+            CHECK(histogram.Count() == 100);
+            CHECK(histogram.Sum() == 5050);
+            CHECK(histogram.ValueAtPercentile(0) == 1);
+            CHECK(histogram.ValueAtPercentile(5) == 5);
+            /* 50 лежит в корзине [48, 52) */
+            CHECK(histogram.ValueAtPercentile(50) == 51);
+            /* 90 лежит в корзине [88, 96) */
+            CHECK(histogram.ValueAtPercentile(90) == 95);
+        }
+
+        THEN("the top percentiles do not exceed the maximum") {
+            CHECK(histogram.ValueAtPercentile(99) == 100);
+            CHECK(histogram.ValueAtPercentile(100) == 100);
+            CHECK(histogram.ValueAtPercentile(250) == 100);
+        }
+    }
+
+    GIVEN("a constant value") {
+        Histogram histogram;
+        for (int i = 0; i < 1'000; ++i) {
+            histogram.Record(1'000);
+        }
+
+        THEN("every percentile is that value") {
+            CHECK(histogram.ValueAtPercentile(1) == 1'000);
+            CHECK(histogram.ValueAtPercentile(50) == 1'000);
+            CHECK(histogram.ValueAtPercentile(99.9) == 1'000);
+        }
+    }
+
+    GIVEN("a skewed distribution: 990 fast and 10 slow values") {
+        Histogram histogram;
+        for (int i = 0; i < 990; ++i) {
+            histogram.Record(10);
+        }
+        for (int i = 0; i < 10; ++i) {
+            histogram.Record(100'000);
+        }
+
+        THEN("the slow tail shows only above the 99th percentile") {
+            CHECK(histogram.ValueAtPercentile(99) == 10);
+            CHECK(histogram.ValueAtPercentile(99.1) == 100'000);
+        }
+    }
+}
+
+SCENARIO("Registry renders the Prometheus text format") {
+    GIVEN("a registry with a counter, a gauge and a histogram") {
+        metrics::Registry registry;
+        registry.AddCounter("game_requests_total", "Requests", {"route"}).WithLabels({"state"}).Increment(3);
+        registry.AddGauge("game_sessions", "Sessions", {"map"}).WithLabels({"a\"b"}).Set(-2);
+        auto& latency = registry.AddHistogram("game_latency_seconds", "Latency", {"route"});
+        auto& histogram = latency.WithLabels({"state"});
+        for (uint64_t value : {3ull, 100ull, 5'000ull, 1ull << 30}) {
+            histogram.Record(value);
+        }
+        latency.WithLabels({"empty"});
+        const std::string text = registry.RenderPrometheus();
+
+        THEN("every family has HELP and TYPE lines") {
+            CHECK(text.find("# HELP game_requests_total Requests\n# TYPE game_requests_total counter\n") != text.npos);
+            CHECK(text.find("# TYPE game_sessions gauge\n") != text.npos);
+            CHECK(text.find("# TYPE game_latency_seconds histogram\n") != text.npos);
+        }
+
+        THEN("counters and gauges are written with escaped labels") {
+            CHECK(FindValue(text, R"(game_requests_total{route="state"})") == "3"s);
+            CHECK(FindValue(text, R"(game_sessions{map="a\"b"})") == "-2"s);
+        }
+
+        THEN("histogram buckets are cumulative and end with +Inf equal to _count") {
+            const auto buckets = ParseBuckets(text, "game_latency_seconds");
+            REQUIRE(buckets.size() > 2);
+            CHECK(buckets.back().le == "+Inf"s);
+            for (size_t i = 1; i + 1 < buckets.size(); ++i) {
+                INFO(buckets[i].le);
+                CHECK(std::stod(buckets[i - 1].le) < std::stod(buckets[i].le));
+                CHECK(buckets[i - 1].count <= buckets[i].count);
+            }
+            CHECK(buckets.back().count == 4);
+            CHECK(FindValue(text, R"(game_latency_seconds_count{route="state"})") == "4"s);
+            /* Значение больше последней экспортируемой границы попадает только в +Inf */
+            CHECK(buckets[buckets.size() - 2].count == 3);
+        }
+
+        THEN("bucket bounds are the last microsecond before a power of two, in seconds") {
+            const auto buckets = ParseBuckets(text, "game_latency_seconds");
+            REQUIRE_FALSE(buckets.empty());
+            CHECK(buckets.front().le == "1.5e-05"s);
+            bool found = false;
+            for (const BucketLine& bucket : buckets) {
+                if (bucket.le == "0.000127"s) {
+                    CHECK(bucket.count == 2);
+                    found = true;
+                }
+            }
+            CHECK(found);
+        }
+
+        THEN("the sum is in seconds and empty children are not written") {
+            const double expected = static_cast<double>(3 + 100 + 5'000 + (uint64_t{1} << 30)) / 1'000'000;
+            CHECK(std::abs(std::stod(FindValue(text, R"(game_latency_seconds_sum{route="state"})")) - expected) < 0.01);
+            CHECK(text.find(R"(route="empty")") == text.npos);
+        }
+    }
+}
+
+SCENARIO("Removed children are not rendered") {
+    GIVEN("a gauge family with two children") {
+        metrics::Registry registry;
+        auto& sessions = registry.AddGauge("game_sessions", "Sessions", {"map"});
+        sessions.WithLabels({"map1"}).Set(1);
+        sessions.WithLabels({"town"}).Set(2);
+
+        WHEN("one child is removed") {
+            sessions.Remove({"map1"});
+            const std::string text = registry.RenderPrometheus();
+
+            THEN("only the other child is written") {
+                CHECK(text.find(R"(map="map1")") == text.npos);
+                CHECK(FindValue(text, R"(game_sessions{map="town"})") == "2"s);
+            }
+
+            THEN("the same labels start a new child from zero") {
+                CHECK(sessions.WithLabels({"map1"}).Value() == 0);
+            }
+        }
+    }
+}
+
+SCENARIO("A value on a power of two lands above the le bound that excludes it") {
+    metrics::Registry registry;
+    auto& histogram = registry.AddHistogram("game_latency_seconds", "Latency").WithLabels({});
+    histogram.Record(1'023);
+    histogram.Record(1'024);
+    const auto buckets = ParseBuckets(registry.RenderPrometheus(), "game_latency_seconds");
+
+    const auto count_at = [&buckets](const std::string& le) -> int64_t {
+        for (const BucketLine& bucket : buckets) {
+            if (bucket.le == le) {
+                return static_cast<int64_t>(bucket.count);
+            }
+        }
+        return -1;
+    };
+    /* le включает границу: 1023 мкс - в le="0.001023", 1024 мкс - только в следующей */
+    CHECK(count_at("0.000511"s) == 0);
+    CHECK(count_at("0.001023"s) == 1);
+    CHECK(count_at("0.002047"s) == 2);
+}
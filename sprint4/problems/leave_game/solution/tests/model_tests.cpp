@@ -0,0 +1,320 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../src/model.h"
+#include "../src/players.h"
+#include "../src/random.h"
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+
+/*
+    Дороги длиной 0, 30, 0, 10 и 60 (последняя идёт справа налево).
+    Нулевые дороги стоят в начале и между ненулевыми.
+*/
+Map MakeRoadNetwork() {
+    Map map{Map::Id("network"s), "Network"s};
+    map.AddRoad(Road{Road::HORIZONTAL, {5, 5}, 5});
+    map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 30});
+    map.AddRoad(Road{Road::HORIZONTAL, {50, 50}, 50});
+    map.AddRoad(Road{Road::VERTICAL, {100, 0}, 10});
+    map.AddRoad(Road{Road::HORIZONTAL, {60, 20}, 0});
+    return map;
+}
+
+/* Индекс дороги, на которой лежит точка; -1 - точка вне дорог */
+int FindRoadIndex(const Map& map, PairDouble pos) {
+    const Map::Roads& roads = map.GetRoads();
+    for (size_t i = 0; i < roads.size(); ++i) {
+        const Point start = roads[i].GetStart();
+        const Point end = roads[i].GetEnd();
+        const bool on_x = std::min(start.x, end.x) <= pos.x && pos.x <= std::max(start.x, end.x);
+        const bool on_y = std::min(start.y, end.y) <= pos.y && pos.y <= std::max(start.y, end.y);
+        if (on_x && on_y) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+/* Дорога вдоль оси x от 0 до 10 и далёкая вертикальная, трофеи одного типа */
+Game MakeGame() {
+    Map map{Map::Id("town"s), "Town"s};
+    map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 10});
+    map.AddRoad(Road{Road::VERTICAL, {100, 0}, 10});
+    LootType key;
+    key.name = "key"s;
+    map.AddLootType(key);
+
+    Game game;
+    game.AddMap(std::move(map));
+    game.SetLootGenerator(1.0, 1.0);
+    return game;
+}
+
+Dog* AddDog(GameSession& session, int id, PairDouble pos, double speed) {
+    return session.AddDog(id, Dog::Name("dog"s + std::to_string(id)), Dog::Position(pos),
+                          Dog::Speed({speed, 0}), Direction::EAST);
+}
+
+}  // namespace
+
+SCENARIO("Random positions are spread over all roads by length") {
+    GIVEN("a map with roads of different lengths and zero-length roads") {
+        SetRandomSeed(33);
+        const Map map = MakeRoadNetwork();
+        constexpr int SAMPLES = 100'000;
+
+        WHEN("many positions are sampled") {
+            std::array<int, 5> hits{};
+            int off_road = 0;
+            for (int i = 0; i < SAMPLES; ++i) {
+                const int road = FindRoadIndex(map, map.GetRandomPos());
+                if (road < 0) {
+                    ++off_road;
+                } else {
+                    ++hits[road];
+                }
+            }
+
+            THEN("every position lies on a road") {
+                CHECK(off_road == 0);
+            }
+
+            THEN("zero-length roads are never chosen") {
+                CHECK(hits[0] == 0);
+                CHECK(hits[2] == 0);
+            }
+
+            THEN("roads are hit in proportion to their length") {
+                CHECK(std::abs(hits[1] / static_cast<double>(SAMPLES) - 0.3) < 0.01);
+                CHECK(std::abs(hits[3] / static_cast<double>(SAMPLES) - 0.1) < 0.01);
+                CHECK(std::abs(hits[4] / static_cast<double>(SAMPLES) - 0.6) < 0.01);
+            }
+        }
+
+        WHEN("the same seed is set again") {
+            std::vector<PairDouble> first;
+            for (int i = 0; i < 10; ++i) {
+                first.push_back(map.GetRandomPos());
+            }
+            SetRandomSeed(33);
+
+            THEN("the same positions are drawn") {
+                for (const PairDouble& pos : first) {
+                    const PairDouble again = map.GetRandomPos();
+                    CHECK(again.x == pos.x);
+                    CHECK(again.y == pos.y);
+                }
+            }
+        }
+    }
+
+    GIVEN("a map where every road has zero length") {
+        Map map{Map::Id("dot"s), "Dot"s};
+        map.AddRoad(Road{Road::HORIZONTAL, {7, 3}, 7});
+
+        THEN("the start of the first road is returned") {
+            const PairDouble pos = map.GetRandomPos();
+            CHECK(pos.x == 7);
+            CHECK(pos.y == 3);
+        }
+    }
+}
+
+SCENARIO("Seeded threads draw their own reproducible sequences") {
+    const auto draw = [] {
+        std::array<uint64_t, 4> values{};
+        for (uint64_t& value : values) {
+            value = RandomIndex(std::numeric_limits<uint64_t>::max());
+        }
+        return values;
+    };
+    /* Номера потоков раздаются в порядке обращений: сначала этот поток, затем рабочий */
+    const auto draw_on_two_threads = [&draw] {
+        SetRandomSeed(7);
+        std::array<uint64_t, 4> main_values = draw();
+        std::array<uint64_t, 4> worker_values{};
+        std::thread worker{[&] { worker_values = draw(); }};
+        worker.join();
+        return std::pair{main_values, worker_values};
+    };
+
+    const auto first = draw_on_two_threads();
+    const auto second = draw_on_two_threads();
+
+    CHECK(first.first != first.second);
+    CHECK(first == second);
+}
+
+SCENARIO("Only moving dogs are ticked") {
+    const Map::Id town{"town"s};
+
+    GIVEN("a session with three moving dogs, the middle one about to hit the road end") {
+        Game game = MakeGame();
+        GameSession& session = *game.AddSession(town);
+        Dog* first = AddDog(session, 1, {0, 0}, 1);
+        Dog* stopping = AddDog(session, 2, {9.5, 0}, 1);
+        Dog* last = AddDog(session, 3, {2, 0}, 1);
+        REQUIRE(session.GetMovingDogs() == std::vector<Dog*>{first, stopping, last});
+
+        WHEN("a tick stops the middle dog") {
+            game.UpdateGameState(1'000);
+
+            THEN("it is removed from the moving set") {
+                CHECK(stopping->IsStopped());
+                CHECK((*stopping->GetPosition()).x == 10.4);
+                CHECK(session.GetMovingDogs() == std::vector<Dog*>{first, last});
+            }
+
+            THEN("the dog moved into its slot is not moved twice and the next slot is still processed") {
+                CHECK((*last->GetPosition()).x == 3);
+                CHECK((*first->GetPosition()).x == 1);
+            }
+
+            AND_WHEN("the moved dog stops too") {
+                last->SetSpeed(Dog::Speed({0, 0}));
+
+                THEN("its new slot is released") {
+                    CHECK(session.GetMovingDogs() == std::vector<Dog*>{first});
+                }
+            }
+        }
+
+        WHEN("a stopped dog starts again") {
+            stopping->SetSpeed(Dog::Speed({0, 0}));
+            stopping->SetSpeed(Dog::Speed({-1, 0}));
+
+            THEN("it is added once at the end") {
+                CHECK(session.GetMovingDogs() == std::vector<Dog*>{first, last, stopping});
+            }
+        }
+    }
+
+    GIVEN("a session where every dog stands still") {
+        Game game = MakeGame();
+        GameSession& session = *game.AddSession(town);
+        Dog* dog = AddDog(session, 1, {5, 0}, 0);
+
+        WHEN("the game ticks and loot is generated") {
+            game.UpdateGameState(1'000);
+            game.GenerateLootInSessions(std::chrono::milliseconds{1'000});
+
+            THEN("the session is skipped but still gets loot") {
+                CHECK(session.GetMovingDogs().empty());
+                CHECK((*dog->GetPosition()).x == 5);
+                CHECK(session.GetLootObjects().size() == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Tick temporaries come from the tick arena") {
+    const Map::Id town{"town"s};
+
+    GIVEN("a session with more moving dogs than fit into the initial arena buffer") {
+        Game game = MakeGame();
+        GameSession& session = *game.AddSession(town);
+        const int dogs_count = 4'000;
+        for (int id = 0; id < dogs_count; ++id) {
+            AddDog(session, id, {0, 0}, 1);
+        }
+        // Трофеи на пути каждого из двух тиков: оба тика дают одинаковое число событий
+        session.SetLootObjects({Loot{1, 0, 1, {0.01, 0}}, Loot{2, 0, 1, {0.03, 0}},
+                                Loot{3, 0, 1, {0.06, 0}}, Loot{4, 0, 1, {0.08, 0}}});
+
+        WHEN("the game ticks") {
+            game.UpdateGameState(50);
+            const util::TickArena::Stats first = game.GetTickArenaStats();
+            game.UpdateGameState(50);
+
+            THEN("only the first tick takes memory from the heap") {
+                CHECK(first.heap_allocations > 0);
+                CHECK(first.buffer_size > util::TickArena::DEFAULT_BUFFER_SIZE);
+                CHECK(game.GetTickArenaStats().heap_allocations == 0);
+                CHECK(session.GetMovingDogs().size() == dogs_count);
+            }
+        }
+    }
+}
+
+SCENARIO("A session without dogs is reclaimed") {
+    const Map::Id town{"town"s};
+
+    GIVEN("a session with a single player") {
+        Game game = MakeGame();
+        players::Players players;
+        GameSession* session = game.AddSession(town);
+        Dog* dog = AddDog(*session, 1, {0, 0}, 0);
+        auto [token, player] = players.AddPlayer(1, "Rex"s, dog, session);
+
+        WHEN("the player leaves") {
+            players.DeletePlayer(player);
+            game.DisconnectDogFromSession(session, dog);
+
+            THEN("the session and its player index entries are removed") {
+                CHECK(game.GetAllSessions().at(town).empty());
+                CHECK_THROWS_AS(players.FindPlayersBySession(session), std::logic_error);
+                CHECK(players.GetPlayers().empty());
+            }
+
+            THEN("the next join creates a fresh session") {
+                GameSession* fresh = game.FindSessionForNewDog(town);
+                REQUIRE(fresh != nullptr);
+                AddDog(*fresh, 2, {0, 0}, 0);
+                CHECK(game.GetAllSessions().at(town).size() == 1);
+                CHECK(fresh->GetDogs().size() == 1);
+                CHECK(fresh->GetLootObjects().size() == 0);
+            }
+        }
+
+        WHEN("one of two players leaves") {
+            Dog* other = AddDog(*session, 2, {0, 0}, 0);
+            players.AddPlayer(2, "Bim"s, other, session);
+            players.DeletePlayer(player);
+            game.DisconnectDogFromSession(session, dog);
+
+            THEN("the session stays") {
+                REQUIRE(game.GetAllSessions().at(town).size() == 1);
+                CHECK(&game.GetAllSessions().at(town).front() == session);
+                CHECK(players.FindPlayersBySession(session).size() == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Bag capacity is limited by the inline bag") {
+    Map map{Map::Id("bags"s), "Bags"s};
+    Game game;
+    Dog dog{0, Dog::Name("dog"s), Dog::Position({0, 0}), Dog::Speed({0, 0}), Direction::NORTH};
+
+    THEN("capacities from zero to MAX_BAG_CAPACITY are accepted") {
+        const int max_capacity = static_cast<int>(Dog::MAX_BAG_CAPACITY);
+        map.AddBagCapacity(max_capacity);
+        game.SetDefaultBagCapacity(0);
+        dog.SetBagCapacity(max_capacity);
+        CHECK(map.GetBagCapacity() == max_capacity);
+        CHECK(game.GetDefaultBagCapacity() == 0);
+        CHECK(dog.GetBagCapacity() == max_capacity);
+    }
+
+    THEN("a negative or larger capacity is rejected") {
+        const int too_large = static_cast<int>(Dog::MAX_BAG_CAPACITY) + 1;
+        CHECK_THROWS_AS(map.AddBagCapacity(too_large), std::invalid_argument);
+        CHECK_THROWS_AS(game.SetDefaultBagCapacity(-1), std::invalid_argument);
+        CHECK_THROWS_AS(dog.SetBagCapacity(too_large), std::invalid_argument);
+        CHECK(dog.GetBagCapacity() != too_large);
+    }
+}
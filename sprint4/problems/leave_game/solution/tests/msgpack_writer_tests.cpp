@@ -0,0 +1,315 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/app.h"
+#include "../src/msgpack_writer.h"
+
+using namespace std::literals;
+
+namespace {
+
+std::string Bytes(std::initializer_list<int> bytes) {
+    std::string result;
+    for (int byte : bytes) {
+        result.push_back(static_cast<char>(static_cast<uint8_t>(byte)));
+    }
+    return result;
+}
+
+template <typename Action>
+std::string Encode(Action&& action) {
+    std::string out;
+    msgpack::Writer writer(out);
+    action(writer);
+    return out;
+}
+
+std::string EncodeInt(int64_t value) {
+    return Encode([value](msgpack::Writer& writer) {
+        writer.Int(value);
+    });
+}
+
+std::string EncodeUInt(uint64_t value) {
+    return Encode([value](msgpack::Writer& writer) {
+        writer.UInt(value);
+    });
+}
+
+/*
+    Последовательный разбор ровно тех форм, что выдаёт Writer.
+    Чужой тип в ожидаемом месте - исключение, так что тест проверяет и схему.
+*/
+class Reader {
+public:
+    explicit Reader(std::string_view data) : data_(data) {
+    }
+
+    uint32_t MapHeader() {
+        const uint8_t tag = Byte();
+        if ((tag & 0xf0) == 0x80) {
+            return tag & 0x0f;
+        }
+        if (tag == 0xde) {
+            return static_cast<uint32_t>(BigEndian(2));
+        }
+        if (tag == 0xdf) {
+            return static_cast<uint32_t>(BigEndian(4));
+        }
+        throw std::runtime_error("map expected");
+    }
+
+    uint32_t ArrayHeader() {
+        const uint8_t tag = Byte();
+        if ((tag & 0xf0) == 0x90) {
+            return tag & 0x0f;
+        }
+        if (tag == 0xdc) {
+            return static_cast<uint32_t>(BigEndian(2));
+        }
+        if (tag == 0xdd) {
+            return static_cast<uint32_t>(BigEndian(4));
+        }
+        throw std::runtime_error("array expected");
+    }
+
+    std::string String() {
+        const uint8_t tag = Byte();
+        size_t size = 0;
+        if ((tag & 0xe0) == 0xa0) {
+            size = tag & 0x1f;
+        } else if (tag == 0xd9) {
+            size = BigEndian(1);
+        } else if (tag == 0xda) {
+            size = BigEndian(2);
+        } else if (tag == 0xdb) {
+            size = BigEndian(4);
+        } else {
+            throw std::runtime_error("string expected");
+        }
+        Need(size);
+        std::string result{data_.substr(pos_, size)};
+        pos_ += size;
+        return result;
+    }
+
+    int64_t Int() {
+        const uint8_t tag = Byte();
+        if (tag < 0x80) {
+            return tag;
+        }
+        if (tag >= 0xe0) {
+            return static_cast<int8_t>(tag);
+        }
+        switch (tag) {
+            case 0xcc: return static_cast<int64_t>(BigEndian(1));
+            case 0xcd: return static_cast<int64_t>(BigEndian(2));
+            case 0xce: return static_cast<int64_t>(BigEndian(4));
+            case 0xcf: return static_cast<int64_t>(BigEndian(8));
+            case 0xd0: return static_cast<int8_t>(BigEndian(1));
+            case 0xd1: return static_cast<int16_t>(BigEndian(2));
+            case 0xd2: return static_cast<int32_t>(BigEndian(4));
+            case 0xd3: return static_cast<int64_t>(BigEndian(8));
+        }
+        throw std::runtime_error("integer expected");
+    }
+
+    double Double() {
+        if (Byte() != 0xcb) {
+            throw std::runtime_error("float 64 expected");
+        }
+        return std::bit_cast<double>(BigEndian(8));
+    }
+
+    bool AtEnd() const {
+        return pos_ == data_.size();
+    }
+
+private:
+    void Need(size_t size) const {
+        if (data_.size() - pos_ < size) {
+            throw std::runtime_error("unexpected end of data");
+        }
+    }
+
+    uint8_t Byte() {
+        Need(1);
+        return static_cast<uint8_t>(data_[pos_++]);
+    }
+
+    uint64_t BigEndian(size_t size) {
+        uint64_t value = 0;
+        for (size_t i = 0; i < size; ++i) {
+            value = (value << 8) | Byte();
+        }
+        return value;
+    }
+
+    std::string_view data_;
+    size_t pos_ = 0;
+};
+
+}  // namespace
+
+SCENARIO("MessagePack writer encodes integers in the shortest form") {
+    THEN("non-negative values use positive fixint and uint 8/16/32/64") {
+        CHECK(EncodeUInt(0) == Bytes({0x00}));
+        CHECK(EncodeUInt(127) == Bytes({0x7f}));
+        CHECK(EncodeUInt(128) == Bytes({0xcc, 0x80}));
+        CHECK(EncodeUInt(255) == Bytes({0xcc, 0xff}));
+        CHECK(EncodeUInt(256) == Bytes({0xcd, 0x01, 0x00}));
+        CHECK(EncodeUInt(65'535) == Bytes({0xcd, 0xff, 0xff}));
+        CHECK(EncodeUInt(65'536) == Bytes({0xce, 0x00, 0x01, 0x00, 0x00}));
+        CHECK(EncodeUInt(std::numeric_limits<uint32_t>::max()) == Bytes({0xce, 0xff, 0xff, 0xff, 0xff}));
+        CHECK(EncodeUInt(uint64_t{1} << 32) == Bytes({0xcf, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00}));
+        CHECK(EncodeUInt(std::numeric_limits<uint64_t>::max())
+              == Bytes({0xcf, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff}));
+    }
+
+    THEN("non-negative signed values are encoded as unsigned") {
+        CHECK(EncodeInt(5) == Bytes({0x05}));
+        CHECK(EncodeInt(200) == Bytes({0xcc, 0xc8}));
+        CHECK(EncodeInt(std::numeric_limits<int64_t>::max())
+              == Bytes({0xcf, 0x7f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff}));
+    }
+
+    THEN("negative values use negative fixint and int 8/16/32/64") {
+        CHECK(EncodeInt(-1) == Bytes({0xff}));
+        CHECK(EncodeInt(-32) == Bytes({0xe0}));
+        CHECK(EncodeInt(-33) == Bytes({0xd0, 0xdf}));
+        CHECK(EncodeInt(-128) == Bytes({0xd0, 0x80}));
+        CHECK(EncodeInt(-129) == Bytes({0xd1, 0xff, 0x7f}));
+        CHECK(EncodeInt(-32'768) == Bytes({0xd1, 0x80, 0x00}));
+        CHECK(EncodeInt(-32'769) == Bytes({0xd2, 0xff, 0xff, 0x7f, 0xff}));
+        CHECK(EncodeInt(std::numeric_limits<int32_t>::min()) == Bytes({0xd2, 0x80, 0x00, 0x00, 0x00}));
+        CHECK(EncodeInt(int64_t{std::numeric_limits<int32_t>::min()} - 1)
+              == Bytes({0xd3, 0xff, 0xff, 0xff, 0xff, 0x7f, 0xff, 0xff, 0xff}));
+        CHECK(EncodeInt(std::numeric_limits<int64_t>::min())
+              == Bytes({0xd3, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}));
+    }
+}
+
+SCENARIO("MessagePack writer encodes strings, containers, doubles and nil") {
+    THEN("strings use fixstr and str 8/16/32 with the length in network byte order") {
+        CHECK(Encode([](msgpack::Writer& w) { w.String(""); }) == Bytes({0xa0}));
+        CHECK(Encode([](msgpack::Writer& w) { w.String("pos"); }) == Bytes({0xa3, 'p', 'o', 's'}));
+
+        const std::string str31(31, 'a');
+        CHECK(Encode([&](msgpack::Writer& w) { w.String(str31); }) == Bytes({0xbf}) + str31);
+
+        const std::string str32(32, 'b');
+        CHECK(Encode([&](msgpack::Writer& w) { w.String(str32); }) == Bytes({0xd9, 0x20}) + str32);
+
+        const std::string str255(255, 'c');
+        CHECK(Encode([&](msgpack::Writer& w) { w.String(str255); }) == Bytes({0xd9, 0xff}) + str255);
+
+        const std::string str256(256, 'd');
+        CHECK(Encode([&](msgpack::Writer& w) { w.String(str256); }) == Bytes({0xda, 0x01, 0x00}) + str256);
+
+        const std::string str65536(65'536, 'e');
+        CHECK(Encode([&](msgpack::Writer& w) { w.String(str65536); })
+              == Bytes({0xdb, 0x00, 0x01, 0x00, 0x00}) + str65536);
+    }
+
+    THEN("map headers use fixmap, map 16 and map 32") {
+        CHECK(Encode([](msgpack::Writer& w) { w.MapHeader(0); }) == Bytes({0x80}));
+        CHECK(Encode([](msgpack::Writer& w) { w.MapHeader(15); }) == Bytes({0x8f}));
+        CHECK(Encode([](msgpack::Writer& w) { w.MapHeader(16); }) == Bytes({0xde, 0x00, 0x10}));
+        CHECK(Encode([](msgpack::Writer& w) { w.MapHeader(65'535); }) == Bytes({0xde, 0xff, 0xff}));
+        CHECK(Encode([](msgpack::Writer& w) { w.MapHeader(65'536); }) == Bytes({0xdf, 0x00, 0x01, 0x00, 0x00}));
+    }
+
+    THEN("array headers use fixarray, array 16 and array 32") {
+        CHECK(Encode([](msgpack::Writer& w) { w.ArrayHeader(0); }) == Bytes({0x90}));
+        CHECK(Encode([](msgpack::Writer& w) { w.ArrayHeader(15); }) == Bytes({0x9f}));
+        CHECK(Encode([](msgpack::Writer& w) { w.ArrayHeader(16); }) == Bytes({0xdc, 0x00, 0x10}));
+        CHECK(Encode([](msgpack::Writer& w) { w.ArrayHeader(65'535); }) == Bytes({0xdc, 0xff, 0xff}));
+        CHECK(Encode([](msgpack::Writer& w) { w.ArrayHeader(65'536); }) == Bytes({0xdd, 0x00, 0x01, 0x00, 0x00}));
+    }
+
+    THEN("doubles are float 64 in network byte order") {
+        CHECK(Encode([](msgpack::Writer& w) { w.Double(1.5); })
+              == Bytes({0xcb, 0x3f, 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}));
+        CHECK(Encode([](msgpack::Writer& w) { w.Double(-2.0); })
+              == Bytes({0xcb, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}));
+    }
+
+    THEN("nil is a single byte") {
+        CHECK(Encode([](msgpack::Writer& w) { w.Nil(); }) == Bytes({0xc0}));
+    }
+}
+
+SCENARIO("State payload in MessagePack follows the JSON schema") {
+    using namespace model;
+
+    GIVEN("a state with a player carrying loot and a lost object") {
+        Dog dog{7, Dog::Name("Rex"s), Dog::Position({1.25, -3.5}), Dog::Speed({0, 2.5}), Direction::SOUTH};
+        dog.SetBagCapacity(3);
+        dog.CollectItem(Loot{40, 1, 10, {0, 0}});
+        dog.SetScore(300);
+        const Loot lost{3, 2, 5, {-0.5, 7.75}};
+
+        app::GameStateUseCase::StateView view;
+        view.players.push_back(std::make_shared<players::Player>(12, "Rex"s, &dog, nullptr));
+        view.loot.push_back(&lost);
+
+        WHEN("it is encoded") {
+            const std::string payload = app::GameStateUseCase::EncodeStateMsgPack(view);
+
+            THEN("the payload decodes field by field") {
+                Reader reader{payload};
+                REQUIRE(reader.MapHeader() == 2);
+
+                CHECK(reader.String() == "players"s);
+                REQUIRE(reader.MapHeader() == 1);
+                CHECK(reader.String() == "12"s);
+                REQUIRE(reader.MapHeader() == 5);
+
+                CHECK(reader.String() == "pos"s);
+                REQUIRE(reader.ArrayHeader() == 2);
+                CHECK(reader.Double() == 1.25);
+                CHECK(reader.Double() == -3.5);
+
+                CHECK(reader.String() == "speed"s);
+                REQUIRE(reader.ArrayHeader() == 2);
+                CHECK(reader.Double() == 0.0);
+                CHECK(reader.Double() == 2.5);
+
+                CHECK(reader.String() == "dir"s);
+                CHECK(reader.String() == "D"s);
+
+                CHECK(reader.String() == "bag"s);
+                REQUIRE(reader.ArrayHeader() == 1);
+                REQUIRE(reader.MapHeader() == 2);
+                CHECK(reader.String() == "id"s);
+                CHECK(reader.Int() == 40);
+                CHECK(reader.String() == "type"s);
+                CHECK(reader.Int() == 1);
+
+                CHECK(reader.String() == "score"s);
+                CHECK(reader.Int() == 300);
+
+                CHECK(reader.String() == "lostObjects"s);
+                REQUIRE(reader.MapHeader() == 1);
+                CHECK(reader.String() == "3"s);
+                REQUIRE(reader.MapHeader() == 2);
+                CHECK(reader.String() == "type"s);
+                CHECK(reader.Int() == 2);
+                CHECK(reader.String() == "pos"s);
+                REQUIRE(reader.ArrayHeader() == 2);
+                CHECK(reader.Double() == -0.5);
+                CHECK(reader.Double() == 7.75);
+
+                CHECK(reader.AtEnd());
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <ctime>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../src/profiler.h"
+
+using namespace std::literals;
+
+namespace {
+
+double ProcessCpuSeconds() {
+    timespec time{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) / 1e9;
+}
+
+/* Занимает процессор, пока процесс не израсходует seconds процессорного времени */
+[[gnu::noinline]] unsigned BurnCpu(double seconds) {
+    volatile unsigned sink = 0;
+    const double until = ProcessCpuSeconds() + seconds;
+    while (ProcessCpuSeconds() < until) {
+        for (unsigned i = 0; i < 10000; ++i) {
+            sink = sink * 31 + i;
+        }
+    }
+    return sink;
+}
+
+}  // namespace
+
+SCENARIO("The profiler samples CPU time into collapsed stacks") {
+    GIVEN("a profiler started at the maximum frequency") {
+        REQUIRE(profiler::Start(profiler::MAX_FREQUENCY_HZ));
+        CHECK(profiler::IsRunning());
+
+        THEN("a second start is refused while it runs") {
+            CHECK_FALSE(profiler::Start());
+            profiler::Stop();
+        }
+
+        WHEN("the process burns CPU and the profiler is stopped") {
+            BurnCpu(0.3);
+            profiler::Stop();
+            const profiler::Stats stats = profiler::GetStats();
+            const std::string collapsed = profiler::DumpCollapsed();
+
+            THEN("samples were taken") {
+                CHECK_FALSE(profiler::IsRunning());
+                CHECK(stats.samples > 0);
+                CHECK(stats.unique_stacks > 0);
+                CHECK_FALSE(collapsed.empty());
+            }
+
+            THEN("every line is \"frame;...;frame count\" and the counts add up to the stored samples") {
+                static const std::regex line_re{R"(([^;\n]+(;[^;\n]+)*) ([1-9][0-9]*))"};
+                std::istringstream lines{collapsed};
+                uint64_t total = 0;
+                size_t line_count = 0;
+                for (std::string line; std::getline(lines, line);) {
+                    std::smatch match;
+                    INFO(line);
+                    REQUIRE(std::regex_match(line, match, line_re));
+                    total += std::stoull(match[3]);
+                    ++line_count;
+                }
+                CHECK(line_count > 0);
+                CHECK(collapsed.back() == '\n');
+                CHECK(total <= stats.samples);
+                CHECK(total + stats.dropped >= stats.samples);
+            }
+        }
+    }
+}
+
+SCENARIO("The profiler frequency is parsed strictly") {
+    THEN("whole decimal numbers within the limits are accepted") {
+        CHECK(profiler::ParseFrequency("1") == 1u);
+        CHECK(profiler::ParseFrequency("99") == 99u);
+        CHECK(profiler::ParseFrequency(std::to_string(profiler::MAX_FREQUENCY_HZ)) ==
+              profiler::MAX_FREQUENCY_HZ);
+    }
+
+    THEN("partial numbers, signs, spaces and values out of range are rejected") {
+        for (const std::string_view text : {""sv, "12abc"sv, "abc"sv, " 12"sv, "12 "sv, "+12"sv, "-1"sv,
+                                            "1.5"sv, "0"sv, "1001"sv, "99999999999999999999"sv}) {
+            INFO(text);
+            CHECK_FALSE(profiler::ParseFrequency(text).has_value());
+        }
+    }
+
+    THEN("Start rejects a frequency out of range") {
+        CHECK_THROWS_AS(profiler::Start(0), std::invalid_argument);
+        CHECK_THROWS_AS(profiler::Start(profiler::MAX_FREQUENCY_HZ + 1), std::invalid_argument);
+        CHECK_FALSE(profiler::IsRunning());
+    }
+}
@@ -0,0 +1,160 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/rate_limiter.h"
+
+using namespace std::literals;
+using http_handler::ParseRateLimits;
+using http_handler::RateClass;
+using http_handler::RateLimiter;
+using http_handler::RateLimits;
+using http_handler::Route;
+
+namespace {
+
+namespace net = boost::asio;
+
+const net::ip::address CLIENT = net::ip::make_address("192.0.2.1");
+const net::ip::address OTHER_CLIENT = net::ip::make_address("2001:db8::1");
+
+const RateLimits& Limit(RateLimits& limits, RateClass rate_class, double rate, unsigned burst) {
+    limits[static_cast<size_t>(rate_class)] = {rate, burst};
+    return limits;
+}
+
+std::string Bearer(int player) {
+    return "Bearer token"s + std::to_string(player);
+}
+
+/* Сколько запросов подряд пропущено из count */
+int CountAllowed(RateLimiter& limiter, Route route, std::string_view authorization,
+                 const net::ip::address& remote, int count) {
+    int allowed = 0;
+    for (int i = 0; i < count; ++i) {
+        allowed += limiter.Allow(route, authorization, remote) ? 1 : 0;
+    }
+    return allowed;
+}
+
+}  // namespace
+
+SCENARIO("Rate limits are parsed from the command line") {
+    THEN("rate and optional burst are read per class") {
+        const RateLimits limits = ParseRateLimits({"state=20:40", "join=0.5", "read=10:0"});
+        CHECK(limits[static_cast<size_t>(RateClass::STATE)].rate == 20.0);
+        CHECK(limits[static_cast<size_t>(RateClass::STATE)].burst == 40);
+        CHECK(limits[static_cast<size_t>(RateClass::JOIN)].rate == 0.5);
+        CHECK(limits[static_cast<size_t>(RateClass::JOIN)].burst == 1);
+        /* Нулевой всплеск означает хотя бы один запрос */
+        CHECK(limits[static_cast<size_t>(RateClass::READ)].burst == 1);
+        CHECK(limits[static_cast<size_t>(RateClass::ACTION)].rate == 0.0);
+    }
+
+    THEN("a later spec for the same class wins") {
+        const RateLimits limits = ParseRateLimits({"action=5", "action=7:2"});
+        CHECK(limits[static_cast<size_t>(RateClass::ACTION)].rate == 7.0);
+        CHECK(limits[static_cast<size_t>(RateClass::ACTION)].burst == 2);
+    }
+
+    THEN("malformed specs are rejected") {
+        for (const std::string &spec : {"state"s, "state="s, "=20"s, "moves=20"s, "State=20"s, "state=abc"s,
+                                       "state=20x"s, "state=-1"s, "state=inf"s, "state=20:"s,
+                                       "state=20:x"s, "state=20:-3"s, "state= 20"s}) {
+            INFO(spec);
+            CHECK_THROWS_AS(ParseRateLimits({spec}), std::invalid_argument);
+        }
+    }
+}
+
+SCENARIO("GCRA admits a burst and then one request per interval") {
+    GIVEN("a state limit of 4 requests per second with a burst of 2") {
+        RateLimits limits{};
+        RateLimiter limiter{Limit(limits, RateClass::STATE, 4, 2)};
+        const std::string token = Bearer(1);
+        REQUIRE(limiter.Enabled());
+
+        THEN("the burst passes and the next request is rejected") {
+            CHECK(CountAllowed(limiter, Route::STATE, token, CLIENT, 5) == 2);
+        }
+
+        WHEN("one interval passes after the burst") {
+            REQUIRE(CountAllowed(limiter, Route::STATE, token, CLIENT, 2) == 2);
+            std::this_thread::sleep_for(300ms);
+
+            THEN("exactly one more request is admitted") {
+                CHECK(CountAllowed(limiter, Route::STATE, token, CLIENT, 3) == 1);
+            }
+        }
+
+        THEN("other classes and other players are not limited by this bucket") {
+            REQUIRE(CountAllowed(limiter, Route::STATE, token, CLIENT, 2) == 2);
+            CHECK(CountAllowed(limiter, Route::ACTION, token, CLIENT, 100) == 100);
+            CHECK(CountAllowed(limiter, Route::MAPS, "", CLIENT, 100) == 100);
+            CHECK(CountAllowed(limiter, Route::STATE, Bearer(2), CLIENT, 3) == 2);
+        }
+    }
+
+    GIVEN("a high rate with no burst") {
+        RateLimits limits{};
+        RateLimiter limiter{Limit(limits, RateClass::JOIN, 1'000, 1)};
+
+        THEN("requests are admitted again after the interval") {
+            CHECK(limiter.Allow(Route::JOIN, "", CLIENT));
+            CHECK_FALSE(limiter.Allow(Route::JOIN, "", CLIENT));
+            std::this_thread::sleep_for(5ms);
+            CHECK(limiter.Allow(Route::JOIN, "", CLIENT));
+        }
+    }
+
+    GIVEN("no limits") {
+        RateLimiter limiter{RateLimits{}};
+
+        THEN("everything is allowed") {
+            CHECK_FALSE(limiter.Enabled());
+            CHECK(CountAllowed(limiter, Route::STATE, Bearer(1), CLIENT, 1'000) == 1'000);
+        }
+    }
+}
+
+SCENARIO("Requests without a valid player are limited by client address") {
+    GIVEN("a state limit of 1 request per second and 4 players per address") {
+        RateLimits limits{};
+        RateLimiter limiter{Limit(limits, RateClass::STATE, 1, 1), 4};
+
+        WHEN("a client sends a new random token with every request") {
+            int allowed = 0;
+            for (int i = 0; i < 20; ++i) {
+                allowed += limiter.Allow(Route::STATE, Bearer(i), CLIENT) ? 1 : 0;
+            }
+
+            THEN("only the address share is admitted") {
+                CHECK(allowed == 4);
+            }
+
+            THEN("another address is not affected") {
+                CHECK(limiter.Allow(Route::STATE, Bearer(100), OTHER_CLIENT));
+            }
+        }
+
+        WHEN("requests come without a token") {
+            THEN("the address itself gets the per-player limit") {
+                CHECK(CountAllowed(limiter, Route::STATE, "", CLIENT, 5) == 1);
+                CHECK(CountAllowed(limiter, Route::STATE, "Basic abc", OTHER_CLIENT, 5) == 1);
+            }
+        }
+
+        WHEN("several real players share one address") {
+            THEN("each of them gets the full limit up to the address share") {
+                for (int player = 0; player < 4; ++player) {
+                    CHECK(limiter.Allow(Route::STATE, Bearer(player), CLIENT));
+                }
+                CHECK_FALSE(limiter.Allow(Route::STATE, Bearer(4), CLIENT));
+            }
+        }
+    }
+}
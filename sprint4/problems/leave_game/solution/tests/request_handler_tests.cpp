@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "../src/json_loader.h"
+#include "../src/request_handler.h"
+
+using app::StateEncoding;
+using http_compression::Encoding;
+using http_handler::LogicHandler;
+using http_handler::StringRequest;
+using http_handler::StringResponse;
+namespace http = http_handler::http;
+namespace net = http_handler::net;
+namespace fs = std::filesystem;
+using namespace std::literals;
+
+namespace {
+
+const std::string CONFIG =
+    R"({"lootGeneratorConfig": {"period": 5.0, "probability": 0.5}, "maps": [{"id": "town", "name": "Town", )"
+    R"("roads": [{"x0": 0, "y0": 0, "x1": 40}], "buildings": [], )"
+    R"("offices": [{"id": "o0", "x": 40, "y": 0, "offsetX": 5, "offsetY": 0}], )"
+    R"("lootTypes": [{"name": "key", "file": "key.obj", "type": "obj", "value": 1}]}]})";
+
+}  // namespace
+
+SCENARIO("State encoding is chosen from Accept") {
+    THEN("JSON stays the default") {
+        CHECK(LogicHandler::ChooseStateEncoding("") == StateEncoding::JSON);
+        CHECK(LogicHandler::ChooseStateEncoding("*/*") == StateEncoding::JSON);
+        CHECK(LogicHandler::ChooseStateEncoding("application/*") == StateEncoding::JSON);
+        CHECK(LogicHandler::ChooseStateEncoding("text/html") == StateEncoding::JSON);
+    }
+
+    THEN("msgpack is sent when it is asked for") {
+        CHECK(LogicHandler::ChooseStateEncoding("application/msgpack") == StateEncoding::MSGPACK);
+        CHECK(LogicHandler::ChooseStateEncoding("application/x-msgpack") == StateEncoding::MSGPACK);
+    }
+
+    THEN("a wildcard does not raise a type listed with a lower weight") {
+        CHECK(LogicHandler::ChooseStateEncoding("application/json;q=0.1, */*") == StateEncoding::MSGPACK);
+        CHECK(LogicHandler::ChooseStateEncoding("application/msgpack;q=0.2, application/json;q=0.1, */*")
+              == StateEncoding::MSGPACK);
+        CHECK(LogicHandler::ChooseStateEncoding("application/msgpack;q=0.1, */*") == StateEncoding::JSON);
+    }
+
+    THEN("the heavier of the two types wins") {
+        CHECK(LogicHandler::ChooseStateEncoding("application/json, application/msgpack;q=0.9") == StateEncoding::JSON);
+        CHECK(LogicHandler::ChooseStateEncoding("application/json;q=0.5, application/msgpack") == StateEncoding::MSGPACK);
+    }
+}
+
+SCENARIO("Response encoding respects the compression settings") {
+    GIVEN("a request accepting gzip and a response at the size threshold") {
+        http_compression::Settings settings;
+        StringRequest req;
+        req.set(http::field::accept_encoding, "deflate;q=0.5, gzip");
+        StringResponse response;
+        response.body() = std::string(settings.min_size, 'x');
+
+        THEN("the encoding comes from Accept-Encoding") {
+            CHECK(LogicHandler::ResponseEncoding(req, response, settings) == Encoding::GZIP);
+            req.set(http::field::accept_encoding, "deflate");
+            CHECK(LogicHandler::ResponseEncoding(req, response, settings) == Encoding::DEFLATE);
+            req.erase(http::field::accept_encoding);
+            CHECK(LogicHandler::ResponseEncoding(req, response, settings) == Encoding::IDENTITY);
+        }
+
+        THEN("a body shorter than the threshold is sent as is") {
+            response.body().pop_back();
+            CHECK(LogicHandler::ResponseEncoding(req, response, settings) == Encoding::IDENTITY);
+        }
+
+        THEN("an already encoded body is not compressed again") {
+            response.set(http::field::content_encoding, "gzip");
+            CHECK(LogicHandler::ResponseEncoding(req, response, settings) == Encoding::IDENTITY);
+        }
+
+        THEN("disabled compression sends every body as is") {
+            settings.enabled = false;
+            CHECK(LogicHandler::ResponseEncoding(req, response, settings) == Encoding::IDENTITY);
+        }
+    }
+}
+
+SCENARIO("A slow config reload does not hold up ticks") {
+    GIVEN("a server on one thread whose config is a pipe nobody has written yet") {
+        const fs::path dir = fs::temp_directory_path() / ("reload_test_" + std::to_string(::getpid()));
+        fs::create_directories(dir);
+        const fs::path pipe = dir / "config.json";
+        REQUIRE(::mkfifo(pipe.c_str(), 0600) == 0);
+
+        model::Game game = json_loader::ParseGame(CONFIG);
+        strct::Args args;
+        args.config = pipe.string();
+        args.root = dir.string();
+        args.tick = 5;
+        // Один поток: как контекст 0 в режиме per-core или с --threads 1
+        net::io_context ioc{1};
+        auto handler = std::make_shared<http_handler::RequestHandler>(game, args, net::make_strand(ioc), nullptr);
+
+        WHEN("a reload starts on the thread that runs the ticks") {
+            std::promise<size_t> reloaded;
+            net::post(ioc, [&handler, &reloaded] {
+                handler->ReloadMaps([&reloaded](size_t maps, const std::string&) {
+                    reloaded.set_value(maps);
+                });
+            });
+            std::thread io{[&ioc] { ioc.run(); }};
+
+            // Разбор ждёт данных из канала, пока тики идут
+            const uint64_t ticks_before = handler->GetTickCount();
+            const auto deadline = std::chrono::steady_clock::now() + 5s;
+            while (handler->GetTickCount() < ticks_before + 3 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(1ms);
+            }
+            const uint64_t ticks_during_reload = handler->GetTickCount() - ticks_before;
+
+            std::ofstream{pipe} << CONFIG;
+            std::future<size_t> maps = reloaded.get_future();
+            const bool done = maps.wait_for(5s) == std::future_status::ready;
+            ioc.stop();
+            io.join();
+
+            THEN("ticks complete while the file is read and the maps are replaced afterwards") {
+                CHECK(ticks_during_reload >= 3);
+                REQUIRE(done);
+                CHECK(maps.get() == 1);
+            }
+        }
+
+        handler.reset();
+        fs::remove_all(dir);
+    }
+}
@@ -0,0 +1,170 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/slot_map.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Item {
+    int id;
+    std::string name;
+};
+
+struct ItemIdOf {
+    int operator()(const Item& item) const {
+        return item.id;
+    }
+};
+
+using Items = util::SlotMap<Item, int, ItemIdOf>;
+
+/* Каждый объект находится по своему id, и Find указывает на объект внутри хранилища */
+void CheckIndexConsistent(const Items& items) {
+    for (size_t slot = 0; slot < items.size(); ++slot) {
+        const Item* found = items.Find(items[slot].id);
+        REQUIRE(found != nullptr);
+        CHECK(found == &items[slot]);
+    }
+}
+
+std::vector<int> Ids(const Items& items) {
+    std::vector<int> ids;
+    for (const Item& item : items) {
+        ids.push_back(item.id);
+    }
+    return ids;
+}
+
+}  // namespace
+
+SCENARIO("SlotMap keeps objects dense and finds them by id") {
+    GIVEN("a slot map with several objects") {
+        Items items;
+        for (int id : {10, 20, 30, 40}) {
+            items.Insert({id, "item"s + std::to_string(id)});
+        }
+
+        THEN("objects are stored in insertion order and found by id") {
+            CHECK(items.size() == 4);
+            CHECK(Ids(items) == std::vector<int>{10, 20, 30, 40});
+            CheckIndexConsistent(items);
+            CHECK(items.Find(50) == nullptr);
+        }
+
+        WHEN("an object in the middle is erased") {
+            REQUIRE(items.Erase(20));
+
+            THEN("the last object takes its slot and the index follows it") {
+                CHECK(Ids(items) == std::vector<int>{10, 40, 30});
+                REQUIRE(items.Find(40) != nullptr);
+                CHECK(items.Find(40)->name == "item40"s);
+                CHECK(items.Find(40) == &items[1]);
+                CheckIndexConsistent(items);
+            }
+
+            THEN("the erased object is no longer found") {
+                CHECK(items.Find(20) == nullptr);
+                CHECK_FALSE(items.Erase(20));
+                CHECK(items.size() == 3);
+            }
+        }
+
+        WHEN("the last object is erased") {
+            REQUIRE(items.Erase(40));
+
+            THEN("the other objects keep their slots") {
+                CHECK(Ids(items) == std::vector<int>{10, 20, 30});
+                CHECK(items.Find(40) == nullptr);
+                CheckIndexConsistent(items);
+            }
+        }
+
+        WHEN("the first object is erased") {
+            REQUIRE(items.Erase(10));
+
+            THEN("the last object moves to the front") {
+                CHECK(Ids(items) == std::vector<int>{40, 20, 30});
+                CheckIndexConsistent(items);
+            }
+        }
+
+        WHEN("an object with an existing id is inserted") {
+            THEN("insertion throws and the map is unchanged") {
+                CHECK_THROWS_AS(items.Insert({30, "other"s}), std::invalid_argument);
+                CHECK(items.size() == 4);
+                REQUIRE(items.Find(30) != nullptr);
+                CHECK(items.Find(30)->name == "item30"s);
+                CheckIndexConsistent(items);
+            }
+        }
+
+        WHEN("every object is erased") {
+            for (int id : {30, 10, 40, 20}) {
+                REQUIRE(items.Erase(id));
+                CheckIndexConsistent(items);
+            }
+
+            THEN("the map is empty and ids can be reused") {
+                CHECK(items.empty());
+                for (int id : {10, 20, 30, 40}) {
+                    CHECK(items.Find(id) == nullptr);
+                }
+                items.Insert({20, "again"s});
+                REQUIRE(items.Find(20) != nullptr);
+                CHECK(items.Find(20)->name == "again"s);
+            }
+        }
+    }
+
+    GIVEN("a single object") {
+        Items items;
+        items.Insert({1, "only"s});
+
+        WHEN("it is erased") {
+            REQUIRE(items.Erase(1));
+
+            THEN("the map is empty") {
+                CHECK(items.empty());
+                CHECK(items.Find(1) == nullptr);
+            }
+        }
+    }
+
+    GIVEN("a range with a duplicate id") {
+        const std::vector<Item> source = {{1, "a"s}, {2, "b"s}, {1, "c"s}};
+
+        THEN("construction from the range throws") {
+            CHECK_THROWS_AS(Items(source.begin(), source.end()), std::invalid_argument);
+        }
+    }
+
+    GIVEN("interleaved inserts and erases") {
+        Items items;
+        std::vector<int> alive;
+        for (int id = 0; id < 200; ++id) {
+            items.Insert({id, std::to_string(id)});
+            alive.push_back(id);
+            if (id % 3 == 2) {
+                /* Удаляем через один, включая только что вставленный последний объект */
+                const int victim = alive[(id / 3) % alive.size()];
+                REQUIRE(items.Erase(victim));
+                alive.erase(std::find(alive.begin(), alive.end(), victim));
+            }
+        }
+
+        THEN("the map holds exactly the live objects and finds each of them") {
+            CHECK(items.size() == alive.size());
+            CheckIndexConsistent(items);
+            for (int id : alive) {
+                REQUIRE(items.Find(id) != nullptr);
+                CHECK(items.Find(id)->name == std::to_string(id));
+            }
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "../src/model.h"
+#include "../src/random.h"
+#include "../src/spatial_grid.h"
+
+using namespace model;
+using namespace std::literals;
+
+namespace {
+
+std::vector<int> FindInGrid(const SpatialGrid<int>& grid, PairDouble center, double radius) {
+    std::vector<int> found;
+    grid.ForEachInRadius(center, radius, [&found](int value) {
+        found.push_back(value);
+    });
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+std::vector<int> LootIds(const std::vector<const Loot*>& loot) {
+    std::vector<int> ids;
+    for (const Loot* item : loot) {
+        ids.push_back(item->id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<int> DogIds(const std::vector<const Dog*>& dogs) {
+    std::vector<int> ids;
+    for (const Dog* dog : dogs) {
+        ids.push_back(dog->GetId());
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/* Карта с одной дорогой вдоль оси x и одним типом трофея */
+std::shared_ptr<const Map> MakeMap(double interest_radius) {
+    auto map = std::make_shared<Map>(Map::Id("grid_town"s), "Grid town"s);
+    map->AddRoad(Road{Road::HORIZONTAL, {0, 0}, 10});
+    LootType key;
+    key.name = "key"s;
+    map->AddLootType(key);
+    map->SetInterestRadius(interest_radius);
+    return map;
+}
+
+}  // namespace
+
+SCENARIO("Spatial grid finds objects in radius") {
+    GIVEN("a grid with objects around the origin and in negative cells") {
+        SpatialGrid<int> grid;
+        grid.Reset(1.0);
+        grid.Insert({0.5, 0.5}, 1);
+        grid.Insert({-0.5, -0.5}, 2);
+        grid.Insert({-0.01, 0.3}, 3);
+        grid.Insert({-3.5, 0}, 4);
+        grid.Insert({3.5, 0}, 5);
+        grid.Build();
+
+        THEN("objects in negative cells are found from a positive center") {
+            CHECK(FindInGrid(grid, {0.2, 0.2}, 1.0) == std::vector<int>{1, 2, 3});
+        }
+
+        THEN("a query around a negative center finds only its neighbours") {
+            CHECK(FindInGrid(grid, {-3.2, 0}, 0.5) == std::vector<int>{4});
+            CHECK(FindInGrid(grid, {-0.5, -0.5}, 0.1) == std::vector<int>{2});
+        }
+
+        THEN("the mirrored cells are not confused after the unsigned key conversion") {
+            CHECK(FindInGrid(grid, {3.2, 0}, 0.5) == std::vector<int>{5});
+        }
+    }
+
+    GIVEN("objects exactly on cell boundaries") {
+        SpatialGrid<int> grid;
+        grid.Reset(2.0);
+        grid.Insert({2.0, 0}, 1);
+        grid.Insert({-2.0, 0}, 2);
+        grid.Insert({0, 2.0}, 3);
+        grid.Insert({0, -2.0}, 4);
+        grid.Insert({2.0001, 0}, 5);
+        grid.Insert({-2.0001, 0}, 6);
+        grid.Build();
+
+        THEN("objects at exactly the radius are included, farther ones are not") {
+            CHECK(FindInGrid(grid, {0, 0}, 2.0) == std::vector<int>{1, 2, 3, 4});
+        }
+    }
+
+    GIVEN("random objects far from the origin on both sides") {
+        std::mt19937 random{7};
+        std::uniform_real_distribution<double> coord{-1'000.0, 1'000.0};
+        std::vector<PairDouble> points(2'000);
+        SpatialGrid<int> grid;
+        grid.Reset(7.5);
+        for (size_t i = 0; i < points.size(); ++i) {
+            points[i] = {coord(random), coord(random)};
+            grid.Insert(points[i], static_cast<int>(i));
+        }
+        grid.Build();
+
+        THEN("queries match a brute-force search") {
+            for (int query = 0; query < 200; ++query) {
+                const PairDouble center{coord(random), coord(random)};
+                const double radius = std::uniform_real_distribution<double>{0.0, 40.0}(random);
+                std::vector<int> expected;
+                for (size_t i = 0; i < points.size(); ++i) {
+                    const double dx = points[i].x - center.x;
+                    const double dy = points[i].y - center.y;
+                    if (dx * dx + dy * dy <= radius * radius) {
+                        expected.push_back(static_cast<int>(i));
+                    }
+                }
+                REQUIRE(FindInGrid(grid, center, radius) == expected);
+            }
+        }
+    }
+}
+
+SCENARIO("Game session answers interest radius queries") {
+    SetRandomSeed(1);
+
+    GIVEN("a session with loot and dogs") {
+        GameSession session{MakeMap(3.0)};
+        session.SetLootObjects({Loot{1, 0, 1, {1.0, 0}}, Loot{2, 0, 1, {-2.5, 0}}, Loot{3, 0, 1, {9.0, 0}}});
+        session.AddDog(1, Dog::Name("Rex"s), Dog::Position({0, 0}), Dog::Speed({0, 0}), Direction::NORTH);
+        session.AddDog(2, Dog::Name("Bim"s), Dog::Position({-3.0, 0}), Dog::Speed({0, 0}), Direction::NORTH);
+
+        std::vector<const Loot*> loot;
+        std::vector<const Dog*> dogs;
+
+        THEN("objects within the radius are found, including negative coordinates") {
+            session.FindLootInRadius({0, 0}, 3.0, loot);
+            CHECK(LootIds(loot) == std::vector<int>{1, 2});
+            session.FindDogsInRadius({0, 0}, 3.0, dogs);
+            CHECK(DogIds(dogs) == std::vector<int>{1, 2});
+            session.FindDogsInRadius({0, 0}, 2.9, dogs);
+            CHECK(DogIds(dogs) == std::vector<int>{1});
+        }
+
+        WHEN("loot is collected after a query") {
+            session.FindLootInRadius({0, 0}, 3.0, loot);
+            REQUIRE(loot.size() == 2);
+            const std::vector<int> collected = {1};
+            session.DeleteCollectedLoot(collected);
+
+            THEN("the grid is rebuilt and the collected loot is not found") {
+                session.FindLootInRadius({0, 0}, 3.0, loot);
+                CHECK(LootIds(loot) == std::vector<int>{2});
+            }
+        }
+
+        WHEN("new loot appears after a query") {
+            session.FindLootInRadius({0, 0}, 100.0, loot);
+            REQUIRE(loot.size() == 3);
+            session.UpdateLoot(2);
+
+            THEN("the grid is rebuilt and the new loot is found") {
+                session.FindLootInRadius({0, 0}, 100.0, loot);
+                CHECK(LootIds(loot) == std::vector<int>{1, 2, 3, 4, 5});
+            }
+        }
+
+        WHEN("a dog joins after a query") {
+            session.FindDogsInRadius({0, 0}, 3.0, dogs);
+            REQUIRE(dogs.size() == 2);
+            session.AddDog(3, Dog::Name("Laika"s), Dog::Position({1.5, 0}), Dog::Speed({0, 0}), Direction::NORTH);
+
+            THEN("the new dog is found") {
+                session.FindDogsInRadius({0, 0}, 3.0, dogs);
+                CHECK(DogIds(dogs) == std::vector<int>{1, 2, 3});
+            }
+        }
+    }
+}
@@ -1,6 +1,12 @@
 #include <catch2/catch_test_macros.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
+#include <vector>
 
+#include "../src/app.h"
 #include "../src/model.h"
 #include "../src/model_serialization.h"
 
@@ -17,9 +23,64 @@ namespace {
         OutputArchive output_archive{strm};
     };
 
+    /* Карта из двух дорог, выходящих из origin; в сессии помещаются два игрока */
+    Map MakeMap(const std::string& id, Point origin)
+    {
+        Map map{Map::Id(id), id};
+        map.AddRoad(Road{Road::HORIZONTAL, origin, origin.x + 40});
+        map.AddRoad(Road{Road::VERTICAL, origin, origin.y + 40});
+        LootType key;
+        key.name = "key"s;
+        key.value = 10;
+        map.AddLootType(key);
+        map.SetMaxPlayersPerSession(2);
+        return map;
+    }
+
+    Game MakeGame(const std::vector<std::pair<std::string, Point>>& maps)
+    {
+        Game game;
+        game.SetLootGenerator(5.0, 0.5);
+        for (const auto& [id, origin] : maps) {
+            game.AddMap(MakeMap(id, origin));
+        }
+        return game;
+    }
+
+    /* Снимок сессии, по которому сравниваются исходная и восстановленная игра */
+    struct SessionSnapshot
+    {
+        std::vector<int> dog_ids;
+        std::vector<std::string> dog_names;
+        std::vector<int> loot_ids;
+        std::vector<PairDouble> loot_pos;
+
+        bool operator==(const SessionSnapshot&) const = default;
+    };
+
+    std::vector<SessionSnapshot> TakeSnapshot(const Game& game, const Map::Id& map_id)
+    {
+        std::vector<SessionSnapshot> result;
+        const auto it = game.GetAllSessions().find(map_id);
+        if (it == game.GetAllSessions().end()) {
+            return result;
+        }
+        for (const GameSession& session : it->second) {
+            SessionSnapshot& snapshot = result.emplace_back();
+            for (const Dog& dog : session.GetDogs()) {
+                snapshot.dog_ids.push_back(dog.GetId());
+                snapshot.dog_names.push_back(*dog.GetName());
+            }
+            for (const Loot& loot : session.GetLootObjects()) {
+                snapshot.loot_ids.push_back(loot.id);
+                snapshot.loot_pos.push_back(loot.pos);
+            }
+        }
+        return result;
+    }
+
 } // namespace
 
-using Point2D = PairDouble;
 using Point2D = PairDouble;
 
 SCENARIO_METHOD(Fixture, "Point serialization")
@@ -50,7 +111,7 @@ SCENARIO_METHOD(Fixture, "Dog Serialization")
             Dog dog{42, Dog::Name("Pluto"s), Dog::Position({42.2, 12.5}), Dog::Speed({0, 0}), Direction::NORTH};
             dog.SetScore(42);
             dog.SetBagCapacity(3);
-            CHECK(dog.PutToBag({"10", 2u}));
+            dog.CollectItem(Loot{10, 2, 5, {1.0, 2.0}});
             dog.SetDirection(Direction::EAST);
             dog.SetSpeed(Dog::Speed({2.3, -1.2}));
             return dog;
@@ -66,18 +127,215 @@ SCENARIO_METHOD(Fixture, "Dog Serialization")
 
             THEN("it can be deserialized")
             {
-                // InputArchive input_archive{strm};
-                // serialization::DogRepr repr;
-                // input_archive >> repr;
-                // const auto restored = repr.Restore();
-
-                // CHECK(dog.GetId() == restored.GetId());
-                // CHECK(dog.GetName() == restored.GetName());
-                // CHECK(dog.GetPosition() == restored.GetPosition());
-                // CHECK(dog.GetSpeed() == restored.GetSpeed());
-                // CHECK(dog.GetBagCapacity() == restored.GetBagCapacity());
-                // CHECK(dog.GetBag() == restored.GetBag());
+                InputArchive input_archive{strm};
+                serialization::DogRepr repr;
+                input_archive >> repr;
+                const auto restored = repr.Restore();
+
+                CHECK(dog.GetId() == restored.GetId());
+                CHECK(*dog.GetName() == *restored.GetName());
+                CHECK(*dog.GetPosition() == *restored.GetPosition());
+                CHECK(*dog.GetSpeed() == *restored.GetSpeed());
+                CHECK(dog.GetDirection() == restored.GetDirection());
+                CHECK(dog.GetScore() == restored.GetScore());
+                CHECK(dog.GetBagCapacity() == restored.GetBagCapacity());
+                CHECK(dog.GetBag() == restored.GetBag());
             }
         }
     }
-}
\ No newline at end of file
+}
+
+SCENARIO("Game state with several sessions on one map is saved and restored")
+{
+    namespace net = boost::asio;
+    const Map::Id map_id{"town"s};
+    const std::string state_file =
+        (std::filesystem::temp_directory_path() / "state_serialization_tests.state").string();
+
+    GIVEN("four players joined to a map with two places per session")
+    {
+        net::io_context ioc;
+        Game game = MakeGame({{"town"s, {0, 0}}});
+        std::vector<SessionSnapshot> saved;
+        {
+            app::Aplication application{game, std::nullopt, state_file, std::nullopt, false,
+                                        nullptr, net::make_strand(ioc)};
+            std::string map_name = "town"s;
+            for (std::string name : {"Rex"s, "Pluto"s, "Bim"s, "Laika"s}) {
+                application.JoinGame(map_name, name);
+            }
+            saved = TakeSnapshot(game, map_id);
+            REQUIRE(saved.size() == 2);
+            REQUIRE(saved[0].dog_ids.size() == 2);
+            REQUIRE(saved[1].dog_ids.size() == 2);
+
+            application.SaveState();
+        }
+
+        WHEN("the state file is read")
+        {
+            std::ifstream in{state_file};
+            InputArchive input_archive{in};
+            serialization::GameStateRepr repr;
+            input_archive >> repr;
+
+            THEN("each session keeps its own dogs and loot")
+            {
+                const auto& sessions = repr.GetAllSessions().at("town"s);
+                REQUIRE(sessions.size() == 2);
+                for (size_t i = 0; i < sessions.size(); ++i) {
+                    CHECK(sessions[i].GetDogsRepr().size() == saved[i].dog_ids.size());
+                    CHECK(sessions[i].GetLoot().size() == saved[i].loot_ids.size());
+                }
+            }
+        }
+
+        WHEN("the state is loaded into a new game")
+        {
+            Game restored_game = MakeGame({{"town"s, {0, 0}}});
+            app::Aplication application{restored_game, std::nullopt, state_file, std::nullopt, false,
+                                        nullptr, net::make_strand(ioc)};
+            application.LoadState();
+
+            THEN("sessions are restored one to one, without exceeding the session size")
+            {
+                CHECK(TakeSnapshot(restored_game, map_id) == saved);
+            }
+        }
+    }
+
+    std::filesystem::remove(state_file);
+}
+
+SCENARIO("A dog's full bag is saved and restored")
+{
+    namespace net = boost::asio;
+    const Map::Id map_id{"town"s};
+    const std::string state_file =
+        (std::filesystem::temp_directory_path() / "state_serialization_bag_tests.state").string();
+
+    GIVEN("a player whose bag holds Dog::MAX_BAG_CAPACITY items")
+    {
+        net::io_context ioc;
+        Game game = MakeGame({{"town"s, {0, 0}}});
+        Dog::Bag saved_bag{{}};
+        {
+            app::Aplication application{game, std::nullopt, state_file, std::nullopt, false,
+                                        nullptr, net::make_strand(ioc)};
+            std::string map_name = "town"s;
+            std::string name = "Rex"s;
+            application.JoinGame(map_name, name);
+
+            Dog& dog = game.GetAllSessions().at(map_id).front().GetDogs().front();
+            dog.SetBagCapacity(static_cast<int>(Dog::MAX_BAG_CAPACITY));
+            dog.SetScore(70);
+            for (int i = 0; i < static_cast<int>(Dog::MAX_BAG_CAPACITY); ++i) {
+                dog.CollectItem(Loot{100 + i, 0, 10, {static_cast<double>(i), 0}});
+            }
+            saved_bag = dog.GetBag();
+            application.SaveState();
+        }
+
+        WHEN("the state is loaded into a new game")
+        {
+            Game restored_game = MakeGame({{"town"s, {0, 0}}});
+            app::Aplication application{restored_game, std::nullopt, state_file, std::nullopt, false,
+                                        nullptr, net::make_strand(ioc)};
+            application.LoadState();
+
+            THEN("the dog gets back every item in order, its capacity and score")
+            {
+                const auto& sessions = restored_game.GetAllSessions().at(map_id);
+                REQUIRE(sessions.size() == 1);
+                REQUIRE(sessions.front().GetDogs().size() == 1);
+                const Dog& restored = sessions.front().GetDogs().front();
+                CHECK((*restored.GetBag()).size() == Dog::MAX_BAG_CAPACITY);
+                CHECK(restored.GetBag() == saved_bag);
+                CHECK(restored.GetBagCapacity() == static_cast<int>(Dog::MAX_BAG_CAPACITY));
+                CHECK(restored.GetScore() == 70);
+            }
+        }
+    }
+
+    std::filesystem::remove(state_file);
+}
+
+SCENARIO("Saved state is restored after the configuration was reloaded")
+{
+    namespace net = boost::asio;
+    const Map::Id town_id{"town"s};
+    const std::string state_file =
+        (std::filesystem::temp_directory_path() / "state_serialization_reload_tests.state").string();
+    /* После перезагрузки дороги города сдвинуты, а деревни больше нет */
+    const Point new_town_origin{100, 100};
+
+    GIVEN("players who joined before and after a reload that moved one map and removed another")
+    {
+        net::io_context ioc;
+        Game game = MakeGame({{"town"s, {0, 0}}, {"village"s, {0, 0}}});
+        std::vector<SessionSnapshot> saved;
+        {
+            app::Aplication application{game, std::nullopt, state_file, std::nullopt, false,
+                                        nullptr, net::make_strand(ioc)};
+            std::string town = "town"s;
+            std::string village = "village"s;
+            for (std::string name : {"Rex"s, "Pluto"s}) {
+                application.JoinGame(town, name);
+            }
+            std::string bim = "Bim"s;
+            application.JoinGame(village, bim);
+
+            const Game reloaded = MakeGame({{"town"s, new_town_origin}});
+            game.ReplaceMaps(reloaded);
+            std::string laika = "Laika"s;
+            application.JoinGame(town, laika);
+
+            saved = TakeSnapshot(game, town_id);
+            REQUIRE(saved.size() == 2);
+            application.SaveState();
+        }
+
+        WHEN("the state is loaded with the new configuration")
+        {
+            Game restored_game = MakeGame({{"town"s, new_town_origin}});
+            app::Aplication application{restored_game, std::nullopt, state_file, std::nullopt, false,
+                                        nullptr, net::make_strand(ioc)};
+            application.LoadState();
+            const auto restored = TakeSnapshot(restored_game, town_id);
+
+            THEN("sessions of the removed map are skipped")
+            {
+                CHECK(restored_game.GetAllSessions().size() == 1);
+            }
+
+            THEN("both town sessions are restored on the current map")
+            {
+                REQUIRE(restored.size() == 2);
+                CHECK(restored[0].dog_names == saved[0].dog_names);
+                CHECK(restored[1].dog_names == saved[1].dog_names);
+                for (const GameSession& session : restored_game.GetAllSessions().at(town_id)) {
+                    CHECK(session.GetMap() == restored_game.FindMap(town_id));
+                }
+            }
+
+            THEN("dogs left off the new roads are moved to the spawn point")
+            {
+                const GameSession& old_session = restored_game.GetAllSessions().at(town_id).front();
+                for (const Dog& dog : old_session.GetDogs()) {
+                    CHECK(*dog.GetPosition() == PairDouble{100, 100});
+                    CHECK(dog.IsStopped());
+                }
+            }
+
+            THEN("loot of the old geometry is dropped, loot on the new roads is kept")
+            {
+                REQUIRE(restored.size() == 2);
+                CHECK(restored[0].loot_ids.empty());
+                CHECK_FALSE(saved[0].loot_ids.empty());
+                CHECK(restored[1] == saved[1]);
+            }
+        }
+    }
+
+    std::filesystem::remove(state_file);
+}
@@ -0,0 +1,86 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include "../src/static_vector.h"
+
+namespace {
+
+struct Item {
+    int id;
+    double weight;
+};
+
+using Items = util::StaticVector<Item, 3>;
+
+std::vector<int> Ids(const Items& items) {
+    std::vector<int> ids;
+    for (const Item& item : items) {
+        ids.push_back(item.id);
+    }
+    return ids;
+}
+
+}  // namespace
+
+SCENARIO("StaticVector stores up to its capacity inline") {
+    GIVEN("an empty vector") {
+        Items items;
+        CHECK(items.empty());
+        CHECK(Items::capacity() == 3);
+        CHECK(sizeof(Items) <= sizeof(Item) * 3 + sizeof(size_t));
+
+        WHEN("items are added up to the capacity") {
+            items.push_back({1, 0.5});
+            items.emplace_back(2, 1.5);
+            items.push_back({3, 2.5});
+
+            THEN("they are kept in insertion order") {
+                CHECK(items.size() == 3);
+                CHECK(Ids(items) == std::vector<int>{1, 2, 3});
+                CHECK(items[1].weight == 1.5);
+            }
+
+            THEN("one more item does not fit") {
+                CHECK_THROWS_AS(items.push_back({4, 0}), std::length_error);
+                CHECK(items.size() == 3);
+            }
+
+            THEN("clear empties it for reuse") {
+                items.clear();
+                CHECK(items.empty());
+                CHECK(items.begin() == items.end());
+                items.push_back({5, 0});
+                CHECK(Ids(items) == std::vector<int>{5});
+            }
+        }
+    }
+
+    GIVEN("a range of items") {
+        const std::vector<Item> source{{7, 0}, {8, 0}};
+
+        THEN("the vector is built from it") {
+            const Items items(source.begin(), source.end());
+            CHECK(Ids(items) == std::vector<int>{7, 8});
+        }
+    }
+}
+
+SCENARIO("StaticVector compares its elements only") {
+    using Ints = util::StaticVector<int, 4>;
+    Ints lhs;
+    Ints rhs;
+    lhs.push_back(1);
+    rhs.push_back(1);
+    rhs.push_back(2);
+
+    CHECK_FALSE(lhs == rhs);
+    rhs.clear();
+    rhs.push_back(1);
+    CHECK(lhs == rhs);
+    lhs.push_back(3);
+    lhs.clear();
+    lhs.push_back(1);
+    CHECK(lhs == rhs);
+}
@@ -0,0 +1,47 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory_resource>
+#include <vector>
+
+#include "../src/tick_arena.h"
+
+namespace {
+
+/* Тик, размещающий в арене count целых чисел по одному, как вектор без reserve */
+void RunTick(util::TickArena& arena, size_t count) {
+    std::pmr::vector<int> values{arena.Resource()};
+    for (size_t i = 0; i < count; ++i) {
+        values.push_back(static_cast<int>(i));
+    }
+    arena.Reset();
+}
+
+}  // namespace
+
+SCENARIO("Tick arena grows until a tick fits into its buffer") {
+    GIVEN("an arena with a small buffer") {
+        util::TickArena arena{1024};
+
+        THEN("a tick that fits does not touch the heap") {
+            RunTick(arena, 16);
+            CHECK(arena.GetLastTickStats().heap_allocations == 0);
+            CHECK(arena.GetLastTickStats().buffer_size == 1024);
+        }
+
+        WHEN("a tick overflows the buffer") {
+            RunTick(arena, 10'000);
+            const util::TickArena::Stats first = arena.GetLastTickStats();
+
+            THEN("the overflow is counted and the buffer grows by it") {
+                CHECK(first.heap_allocations > 0);
+                CHECK(first.buffer_size == 1024 + first.heap_bytes);
+            }
+
+            THEN("the same tick then runs without heap allocations") {
+                RunTick(arena, 10'000);
+                CHECK(arena.GetLastTickStats().heap_allocations == 0);
+                CHECK(arena.GetLastTickStats().buffer_size == first.buffer_size);
+            }
+        }
+    }
+}
@@ -0,0 +1,310 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "../src/app.h"
+#include "../src/timing_wheel.h"
+
+using namespace std::literals;
+
+namespace {
+
+using util::TimerNode;
+using util::TimingWheel;
+
+struct TestTimer : TimerNode {
+    int id = 0;
+};
+
+/* Срабатывание таймера: кто и в какой момент времени колеса */
+struct Expiration {
+    int id;
+    uint64_t at;
+
+    bool operator==(const Expiration&) const = default;
+};
+
+std::ostream& operator<<(std::ostream& out, const Expiration& expiration) {
+    return out << '{' << expiration.id << " at " << expiration.at << '}';
+}
+
+/* Продвигает колесо и собирает сработавшие таймеры */
+std::vector<Expiration> AdvanceTo(TimingWheel& wheel, uint64_t now) {
+    std::vector<Expiration> fired;
+    wheel.Advance(now, [&](TimerNode& node) {
+        fired.push_back({static_cast<TestTimer&>(node).id, wheel.Now()});
+    });
+    return fired;
+}
+
+}  // namespace
+
+SCENARIO("Timing wheel schedules and expires timers") {
+    GIVEN("a wheel with a scheduled timer") {
+        TimingWheel wheel{100};
+        TestTimer timer;
+        timer.id = 1;
+        wheel.Schedule(timer, 110);
+
+        THEN("the timer is pending") {
+            CHECK(timer.IsScheduled());
+            CHECK(timer.GetDeadline() == 110);
+            CHECK(wheel.Size() == 1);
+        }
+
+        WHEN("time has not reached the deadline") {
+            const auto fired = AdvanceTo(wheel, 109);
+
+            THEN("nothing expires") {
+                CHECK(fired.empty());
+                CHECK(timer.IsScheduled());
+                CHECK(wheel.Now() == 109);
+            }
+        }
+
+        WHEN("time reaches the deadline") {
+            const auto fired = AdvanceTo(wheel, 110);
+
+            THEN("the timer expires exactly at its deadline and leaves the wheel") {
+                CHECK(fired == std::vector<Expiration>{{1, 110}});
+                CHECK_FALSE(timer.IsScheduled());
+                CHECK(wheel.Size() == 0);
+            }
+        }
+
+        WHEN("time jumps far past the deadline") {
+            const auto fired = AdvanceTo(wheel, 1'000'000);
+
+            THEN("the timer expires once, at its deadline") {
+                CHECK(fired == std::vector<Expiration>{{1, 110}});
+                CHECK(wheel.Now() == 1'000'000);
+            }
+        }
+
+        WHEN("the timer is cancelled") {
+            wheel.Cancel(timer);
+            const auto fired = AdvanceTo(wheel, 1'000);
+
+            THEN("it never expires") {
+                CHECK(fired.empty());
+                CHECK_FALSE(timer.IsScheduled());
+                CHECK(wheel.Size() == 0);
+            }
+        }
+
+        WHEN("the timer is rescheduled to a later deadline") {
+            wheel.Schedule(timer, 200);
+
+            THEN("it expires only at the new deadline") {
+                CHECK(wheel.Size() == 1);
+                CHECK(AdvanceTo(wheel, 150).empty());
+                CHECK(AdvanceTo(wheel, 200) == std::vector<Expiration>{{1, 200}});
+            }
+        }
+
+        WHEN("the timer is rescheduled to an earlier deadline") {
+            wheel.Schedule(timer, 105);
+
+            THEN("it expires at the new deadline and not again at the old one") {
+                CHECK(AdvanceTo(wheel, 105) == std::vector<Expiration>{{1, 105}});
+                CHECK(AdvanceTo(wheel, 200).empty());
+            }
+        }
+    }
+
+    GIVEN("a wheel and a deadline in the past") {
+        TimingWheel wheel{100};
+        TestTimer timer;
+        timer.id = 7;
+        wheel.Schedule(timer, 10);
+
+        THEN("the timer expires on the next advance") {
+            CHECK(timer.GetDeadline() == 100);
+            CHECK(AdvanceTo(wheel, 100) == std::vector<Expiration>{{7, 100}});
+        }
+    }
+
+    GIVEN("a scheduled timer that is destroyed") {
+        TimingWheel wheel;
+        {
+            TestTimer timer;
+            wheel.Schedule(timer, 10);
+            REQUIRE(wheel.Size() == 1);
+        }
+
+        THEN("it is removed from the wheel") {
+            CHECK(wheel.Size() == 0);
+            CHECK(AdvanceTo(wheel, 100).empty());
+        }
+    }
+
+    GIVEN("a handler that reschedules the expired timer") {
+        TimingWheel wheel;
+        TestTimer timer;
+        wheel.Schedule(timer, 10);
+
+        THEN("the timer fires periodically") {
+            std::vector<uint64_t> fired_at;
+            wheel.Advance(45, [&](TimerNode& node) {
+                fired_at.push_back(wheel.Now());
+                wheel.Schedule(node, wheel.Now() + 10);
+            });
+            CHECK(fired_at == std::vector<uint64_t>{10, 20, 30, 40});
+            CHECK(timer.GetDeadline() == 50);
+        }
+    }
+}
+
+SCENARIO("Timing wheel cascades timers across levels") {
+    GIVEN("timers on every level and beyond the wheel horizon") {
+        TimingWheel wheel;
+        /* Границы слотов и уровней: 256, 256^2, 256^3 и за горизонтом 256^4 */
+        const std::vector<uint64_t> deadlines = {
+            1, 255, 256, 257, 511, 65'535, 65'536, 65'537, 70'000,
+            (uint64_t{1} << 24) - 1, uint64_t{1} << 24, (uint64_t{1} << 24) + 3,
+            (uint64_t{1} << 32) - 1, uint64_t{1} << 32, (uint64_t{1} << 32) + 5, uint64_t{3} << 32,
+        };
+        std::vector<TestTimer> timers(deadlines.size());
+        for (size_t i = 0; i < deadlines.size(); ++i) {
+            timers[i].id = static_cast<int>(i);
+            wheel.Schedule(timers[i], deadlines[i]);
+        }
+
+        std::vector<Expiration> expected;
+        for (size_t i = 0; i < deadlines.size(); ++i) {
+            expected.push_back({static_cast<int>(i), deadlines[i]});
+        }
+
+        WHEN("time advances in one step") {
+            const auto fired = AdvanceTo(wheel, uint64_t{1} << 34);
+
+            THEN("every timer expires at its deadline, in order") {
+                CHECK(fired == expected);
+                CHECK(wheel.Size() == 0);
+            }
+        }
+
+        WHEN("time advances in uneven steps") {
+            std::vector<Expiration> fired;
+            for (uint64_t now : {uint64_t{255}, uint64_t{256}, uint64_t{60'000}, uint64_t{65'536},
+                                 uint64_t{1} << 20, (uint64_t{1} << 24) + 1, uint64_t{1} << 31,
+                                 (uint64_t{1} << 32) + 4, uint64_t{1} << 34}) {
+                const auto step = AdvanceTo(wheel, now);
+                fired.insert(fired.end(), step.begin(), step.end());
+            }
+
+            THEN("the result is the same as in one step") {
+                CHECK(fired == expected);
+            }
+        }
+    }
+
+    GIVEN("random deadlines and random advance steps") {
+        std::mt19937_64 random{42};
+        TimingWheel wheel{1'000};
+        std::vector<TestTimer> timers(2'000);
+        std::multimap<uint64_t, int> pending;
+        for (size_t i = 0; i < timers.size(); ++i) {
+            /* Сроки на разных уровнях: от единиц до миллиардов тиков */
+            const uint64_t delay = random() % (uint64_t{1} << (random() % 34));
+            timers[i].id = static_cast<int>(i);
+            wheel.Schedule(timers[i], wheel.Now() + delay);
+            pending.emplace(wheel.Now() + delay, static_cast<int>(i));
+        }
+
+        THEN("timers expire at their deadlines as the reference model predicts") {
+            while (!pending.empty()) {
+                const uint64_t now = wheel.Now() + random() % (uint64_t{1} << (random() % 30));
+                std::vector<Expiration> expected;
+                for (auto it = pending.begin(); it != pending.end() && it->first <= now;) {
+                    expected.push_back({it->second, it->first});
+                    it = pending.erase(it);
+                }
+
+                auto fired = AdvanceTo(wheel, now);
+                /* Порядок внутри одного момента времени не определён */
+                const auto by_time_and_id = [](const Expiration& lhs, const Expiration& rhs) {
+                    return std::tie(lhs.at, lhs.id) < std::tie(rhs.at, rhs.id);
+                };
+                std::sort(fired.begin(), fired.end(), by_time_and_id);
+                std::sort(expected.begin(), expected.end(), by_time_and_id);
+                REQUIRE(fired == expected);
+                REQUIRE(wheel.Size() == pending.size());
+            }
+        }
+    }
+}
+
+SCENARIO("Idle players are retired by the timing wheel") {
+    using namespace model;
+    constexpr uint64_t RETIREMENT_MS = 15'000;
+
+    GIVEN("a player whose dog is standing still") {
+        TimingWheel wheel{1'000};
+        Dog dog{1, Dog::Name("Rex"s), Dog::Position({0, 0}), Dog::Speed({0, 0}), Direction::NORTH};
+        auto player = std::make_shared<players::Player>(1, "Rex"s, &dog, nullptr);
+        auto activity = std::make_unique<app::PlayerActivity>(player, wheel, RETIREMENT_MS);
+
+        const auto retire = [&](uint64_t now) {
+            std::vector<players::SharedPlayer> retired;
+            wheel.Advance(now, [&](TimerNode& node) {
+                retired.push_back(static_cast<app::PlayerActivity&>(node).GetPlayer());
+            });
+            return retired;
+        };
+
+        THEN("retirement is scheduled from the join time") {
+            CHECK(activity->IsScheduled());
+            CHECK(activity->GetDeadline() == 1'000 + RETIREMENT_MS);
+        }
+
+        WHEN("the dog stays idle for the retirement time") {
+            CHECK(retire(1'000 + RETIREMENT_MS - 1).empty());
+            const auto retired = retire(1'000 + RETIREMENT_MS);
+
+            THEN("the player is retired with the full playtime") {
+                REQUIRE(retired.size() == 1);
+                CHECK(retired.front() == player);
+                CHECK(activity->GetPlaytime().count() == RETIREMENT_MS);
+            }
+        }
+
+        WHEN("the dog starts moving before the deadline") {
+            retire(5'000);
+            dog.SetSpeed(Dog::Speed({1, 0}));
+
+            THEN("the player is not retired while moving") {
+                CHECK_FALSE(activity->IsScheduled());
+                CHECK(retire(100'000).empty());
+            }
+        }
+
+        WHEN("the dog moves and stops again") {
+            retire(5'000);
+            dog.SetSpeed(Dog::Speed({1, 0}));
+            retire(8'000);
+            dog.SetSpeed(Dog::Speed({0, 0}));
+
+            THEN("the retirement time is counted from the last stop") {
+                CHECK(retire(8'000 + RETIREMENT_MS - 1).empty());
+                CHECK(retire(8'000 + RETIREMENT_MS).size() == 1);
+            }
+        }
+
+        WHEN("the activity is destroyed, e.g. the player left") {
+            activity.reset();
+
+            THEN("the timer leaves the wheel and the dog has no listener") {
+                CHECK(wheel.Size() == 0);
+                dog.SetSpeed(Dog::Speed({1, 0}));
+                CHECK(retire(100'000).empty());
+            }
+        }
+    }
+}
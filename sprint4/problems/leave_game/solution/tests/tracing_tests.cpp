@@ -0,0 +1,143 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <regex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/tracing.h"
+
+using namespace std::literals;
+
+namespace {
+
+struct Event {
+    std::string name;
+    int tid;
+    double ts;
+    double dur;
+};
+
+/* События "ph":"X" из выгрузки DumpChromeTrace */
+std::vector<Event> ParseEvents(const std::string& trace) {
+    static const std::regex event_re{
+        R"re(\{"name":"([^"]*)","ph":"X","pid":1,"tid":(\d+),"ts":(-?[0-9.]+),"dur":(-?[0-9.]+)\})re"};
+    std::vector<Event> events;
+    for (auto it = std::sregex_iterator(trace.begin(), trace.end(), event_re); it != std::sregex_iterator(); ++it) {
+        const std::smatch& match = *it;
+        events.push_back({match[1], std::stoi(match[2]), std::stod(match[3]), std::stod(match[4])});
+    }
+    return events;
+}
+
+void TracedWork() {
+    TRACE_SCOPE("tracing_tests::Outer");
+    {
+        TRACE_SCOPE("tracing_tests::Inner");
+        std::this_thread::sleep_for(1ms);
+    }
+}
+
+}  // namespace
+
+SCENARIO("Spans from several threads are dumped in the Chrome trace format") {
+    GIVEN("tracing enabled with empty buffers") {
+        tracing::Clear();
+        tracing::SetEnabled(true);
+
+        WHEN("spans are recorded on the main thread and on a worker thread") {
+            TracedWork();
+            std::thread worker{TracedWork};
+            worker.join();
+            tracing::SetEnabled(false);
+            const std::string trace = tracing::DumpChromeTrace();
+            const std::vector<Event> events = ParseEvents(trace);
+
+            THEN("the dump is a trace_event object") {
+                CHECK(trace.rfind(R"({"traceEvents":[)", 0) == 0);
+                CHECK(trace.find(R"(],"displayTimeUnit":"ms"})") == trace.size() - 25);
+            }
+
+            THEN("every span is written with its name") {
+                std::multiset<std::string> names;
+                for (const Event& event : events) {
+                    names.insert(event.name);
+                }
+                CHECK(names.count("tracing_tests::Outer") == 2);
+                CHECK(names.count("tracing_tests::Inner") == 2);
+                CHECK(names.size() == 4);
+            }
+
+            THEN("the threads get different tids") {
+                std::set<int> tids;
+                for (const Event& event : events) {
+                    tids.insert(event.tid);
+                }
+                CHECK(tids.size() == 2);
+                CHECK(*tids.begin() >= 1);
+            }
+
+            THEN("durations are non-negative and an inner span lies within its outer span") {
+                for (const Event& event : events) {
+                    CHECK(event.dur >= 0);
+                }
+                for (const Event& inner : events) {
+                    if (inner.name != "tracing_tests::Inner") {
+                        continue;
+                    }
+                    CHECK(inner.dur >= 1000);
+                    for (const Event& outer : events) {
+                        if (outer.name == "tracing_tests::Outer" && outer.tid == inner.tid) {
+                            CHECK(outer.ts <= inner.ts);
+                            CHECK(inner.ts + inner.dur <= outer.ts + outer.dur + 0.001);
+                        }
+                    }
+                }
+            }
+        }
+
+        tracing::SetEnabled(false);
+        tracing::Clear();
+    }
+}
+
+SCENARIO("Disabled tracing records nothing") {
+    tracing::Clear();
+    tracing::SetEnabled(false);
+    TracedWork();
+    CHECK(ParseEvents(tracing::DumpChromeTrace()).empty());
+}
+
+SCENARIO("Buffers of finished threads are released") {
+    GIVEN("tracing enabled with empty buffers") {
+        tracing::Clear();
+        tracing::SetEnabled(true);
+        const size_t buffers = tracing::GetThreadBufferCount();
+
+        WHEN("a thread finishes without recording spans") {
+            std::thread([] {}).join();
+
+            THEN("it leaves no buffer behind") {
+                CHECK(tracing::GetThreadBufferCount() == buffers);
+            }
+        }
+
+        WHEN("a thread finishes after recording spans") {
+            std::thread worker{TracedWork};
+            worker.join();
+            tracing::SetEnabled(false);
+
+            THEN("its spans stay in the dump until the buffers are cleared") {
+                CHECK(tracing::GetThreadBufferCount() == buffers + 1);
+                CHECK(ParseEvents(tracing::DumpChromeTrace()).size() == 2);
+                tracing::Clear();
+                CHECK(tracing::GetThreadBufferCount() == buffers);
+                CHECK(ParseEvents(tracing::DumpChromeTrace()).empty());
+            }
+        }
+
+        tracing::SetEnabled(false);
+        tracing::Clear();
+    }
+}
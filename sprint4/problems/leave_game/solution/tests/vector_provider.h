@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+#include "../src/collision_detector.h"
+
+namespace test_support {
+
+/* Предметы и собиратели из готовых векторов; общий для тестов и бенчмарков детектора столкновений */
+class VectorProvider : public collision_detector::ItemGathererProvider {
+public:
+    using Item = collision_detector::Item;
+    using Gatherer = collision_detector::Gatherer;
+
+    VectorProvider(std::vector<Item> items, std::vector<Gatherer> gatherers)
+        : items_(std::move(items))
+        , gatherers_(std::move(gatherers)) {
+    }
+
+    size_t ItemsCount() const override {
+        return items_.size();
+    }
+
+    Item GetItem(size_t idx) const override {
+        return items_[idx];
+    }
+
+    size_t GatherersCount() const override {
+        return gatherers_.size();
+    }
+
+    Gatherer GetGatherer(size_t idx) const override {
+        return gatherers_[idx];
+    }
+
+    const std::vector<Item>& Items() const {
+        return items_;
+    }
+
+    const std::vector<Gatherer>& Gatherers() const {
+        return gatherers_;
+    }
+
+private:
+    std::vector<Item> items_;
+    std::vector<Gatherer> gatherers_;
+};
+
+}  // namespace test_support